@@ -0,0 +1,94 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// eglext_swiftshader.h: SwiftShader specific EGL types.
+
+#ifndef __eglext_swiftshader_h_
+#define __eglext_swiftshader_h_ 1
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+** Headless windows
+**
+** On displays without a window system, obtained from eglGetPlatformDisplayEXT
+** with EGL_PLATFORM_SURFACELESS_MESA or from eglGetDisplay when there's no X
+** server, a pointer to an EGLHeadlessWindowSW can be passed to
+** eglCreateWindowSurface and eglCreatePlatformWindowSurfaceEXT. Each swap
+** delivers the frame to the window's sink. The structure has to remain valid
+** for the lifetime of the surface. Changing its width or height resizes the
+** surface on the next swap, which restarts file sinks.
+**
+** Frames consist of 32-bit pixels with blue in the lowest byte (B8G8R8A8 in
+** memory order on little-endian machines), with the top row first.
+*/
+#define EGL_HEADLESS_WINDOW_MAGIC_SW      0x48575357  /* "SWHW" */
+
+#define EGL_HEADLESS_SINK_CALLBACK_SW     1   /* Passes each frame to callback */
+#define EGL_HEADLESS_SINK_RING_SW         2   /* Writes frames to a ring of buffers mapped from path */
+#define EGL_HEADLESS_SINK_RAW_SW          3   /* Writes frames to path without any header or padding */
+#define EGL_HEADLESS_SINK_Y4M_SW          4   /* Writes frames to path as a YUV4MPEG2 4:2:0 stream */
+
+typedef struct EGLHeadlessFrameSW
+{
+	const void *pixels;   /* Only valid until the callback returns */
+	EGLint width;
+	EGLint height;
+	EGLint stride;        /* In bytes */
+	EGLint sequence;      /* Counts frames from 1 */
+} EGLHeadlessFrameSW;
+
+typedef void (EGLAPIENTRYP PFNEGLHEADLESSCALLBACKSWPROC) (void *userData, const EGLHeadlessFrameSW *frame);
+
+typedef struct EGLHeadlessWindowSW
+{
+	EGLint magic;         /* EGL_HEADLESS_WINDOW_MAGIC_SW */
+	EGLint width;
+	EGLint height;
+	EGLint sink;          /* EGL_HEADLESS_SINK_*_SW */
+	PFNEGLHEADLESSCALLBACKSWPROC callback;   /* Callback sink */
+	void *userData;
+	const char *path;     /* Ring and file sinks, e.g. /dev/shm/frames for a ring */
+	EGLint bufferCount;   /* Ring sink, at least 2 */
+	EGLint frameRate;     /* Y4M sink, in frames per second */
+} EGLHeadlessWindowSW;
+
+/*
+** A ring sink's file starts with this header, followed by bufferCount buffers
+** of height rows of stride bytes each, the first one at offset. Frame n is
+** written to buffer (n - 1) % bufferCount, after which sequence is set to n.
+** A reader which copied frame n has to check that sequence is still below
+** n + bufferCount - 1, or else the buffer may have been overwritten meanwhile.
+*/
+typedef struct EGLHeadlessRingSW
+{
+	EGLint magic;         /* EGL_HEADLESS_WINDOW_MAGIC_SW */
+	EGLint width;
+	EGLint height;
+	EGLint stride;
+	EGLint bufferCount;
+	EGLint offset;
+	volatile EGLint sequence;
+} EGLHeadlessRingSW;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __eglext_swiftshader_h_ */
@@ -42,7 +42,8 @@ COMMON_SRC_FILES := \
 	Common/Resource.cpp \
 	Common/Socket.cpp \
 	Common/Thread.cpp \
-	Common/Timer.cpp
+	Common/Timer.cpp \
+	Common/Trace.cpp
 
 COMMON_SRC_FILES += \
 	Main/Config.cpp \
@@ -54,11 +55,13 @@ ifdef use_subzero
 COMMON_SRC_FILES += \
 	Reactor/SubzeroReactor.cpp \
 	Reactor/Routine.cpp \
+	Reactor/ExecutableMemory.cpp \
 	Reactor/Optimizer.cpp
 else
 COMMON_SRC_FILES += \
 	Reactor/LLVMReactor.cpp \
 	Reactor/Routine.cpp \
+	Reactor/ExecutableMemory.cpp \
 	Reactor/LLVMRoutine.cpp \
 	Reactor/LLVMRoutineManager.cpp
 endif
@@ -103,6 +103,25 @@ namespace sw
 		return buffer;
 	}
 
+	void *Resource::tryLock(Accessor claimer)
+	{
+		criticalSection.lock();
+
+		if(count != 0 && accessor != claimer)
+		{
+			criticalSection.unlock();
+
+			return nullptr;
+		}
+
+		accessor = claimer;
+		count++;
+
+		criticalSection.unlock();
+
+		return buffer;
+	}
+
 	void Resource::unlock()
 	{
 		criticalSection.lock();
@@ -36,6 +36,7 @@ namespace sw
 
 		void *lock(Accessor claimer);
 		void *lock(Accessor relinquisher, Accessor claimer);
+		void *tryLock(Accessor claimer);   // Returns null instead of waiting for another accessor
 		void unlock();
 		void unlock(Accessor relinquisher);
 
@@ -0,0 +1,152 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Serializer_hpp
+#define sw_Serializer_hpp
+
+#include <string>
+#include <vector>
+#include <string.h>
+
+namespace sw
+{
+	// 32-bit FNV-1a, for detecting corrupt serialized data
+	inline unsigned int checksum(const void *data, size_t size, unsigned int hash = 0x811C9DC5)
+	{
+		const unsigned char *bytes = static_cast<const unsigned char*>(data);
+
+		for(size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 0x01000193;
+		}
+
+		return hash;
+	}
+
+	// Appends plain values to a byte buffer. Only meant for data which is read
+	// back by the same build, so no attempt is made at endianness or padding
+	// independence.
+	class Serializer
+	{
+	public:
+		void write(const void *data, size_t size)
+		{
+			const unsigned char *bytes = static_cast<const unsigned char*>(data);
+			buffer.insert(buffer.end(), bytes, bytes + size);
+		}
+
+		template<class T>
+		void write(const T &value)
+		{
+			write(&value, sizeof(T));
+		}
+
+		void write(const std::string &string)
+		{
+			write((unsigned int)string.size());
+			write(string.data(), string.size());
+		}
+
+		const std::vector<unsigned char> &data() const
+		{
+			return buffer;
+		}
+
+	private:
+		std::vector<unsigned char> buffer;
+	};
+
+	// Reads back what a Serializer wrote. Reading past the end puts the stream in
+	// a failed state in which all further reads return zeroed data, so callers
+	// only have to check isValid() once they're done.
+	class Deserializer
+	{
+	public:
+		Deserializer(const void *data, size_t size) : position(static_cast<const unsigned char*>(data)), end(position + size), valid(true)
+		{
+		}
+
+		void read(void *data, size_t size)
+		{
+			if(!valid || size > remaining())
+			{
+				valid = false;
+				memset(data, 0, size);
+				return;
+			}
+
+			memcpy(data, position, size);
+			position += size;
+		}
+
+		template<class T>
+		void read(T &value)
+		{
+			read(&value, sizeof(T));
+		}
+
+		void read(std::string &string)
+		{
+			unsigned int size = 0;
+			read(size);
+
+			if(size > remaining())
+			{
+				valid = false;
+				size = 0;
+			}
+
+			string.assign(reinterpret_cast<const char*>(position), size);
+			position += size;
+		}
+
+		// Reads an element count, rejecting counts which can't possibly fit in
+		// the remaining data to avoid huge allocations on corrupt input
+		unsigned int readCount(size_t elementSize)
+		{
+			unsigned int count = 0;
+			read(count);
+
+			if(count > remaining() / elementSize)
+			{
+				valid = false;
+				return 0;
+			}
+
+			return count;
+		}
+
+		size_t remaining() const
+		{
+			return valid ? end - position : 0;
+		}
+
+		bool isValid() const
+		{
+			return valid;
+		}
+
+		void invalidate()
+		{
+			valid = false;
+		}
+
+	private:
+		const unsigned char *position;
+		const unsigned char *const end;
+		bool valid;
+	};
+}
+
+#endif   // sw_Serializer_hpp
@@ -15,6 +15,8 @@
 #ifndef sw_Thread_hpp
 #define sw_Thread_hpp
 
+#include "Types.hpp"
+
 #if defined(_WIN32)
 	#ifndef WIN32_LEAN_AND_MEAN
 		#define WIN32_LEAN_AND_MEAN
@@ -96,9 +98,8 @@ namespace sw
 		#endif
 	};
 
-	#if PERF_PROFILE
 	int64_t atomicExchange(int64_t volatile *target, int64_t value);
-	#endif
+	int64_t atomicAdd(int64_t volatile *target, int64_t value);
 
 	int atomicExchange(int volatile *target, int value);
 	int atomicIncrement(int volatile *value);
@@ -191,18 +192,23 @@ namespace sw
 		#endif
 	}
 
-	#if PERF_PROFILE
 	inline int64_t atomicExchange(volatile int64_t *target, int64_t value)
 	{
 		#if defined(_WIN32)
 			return InterlockedExchange64(target, value);
 		#else
-			int ret;
-			__asm__ __volatile__("lock; xchg8 %0,(%1)" : "=r" (ret) :"r" (target), "0" (value) : "memory" );
-			return ret;
+			return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+		#endif
+	}
+
+	inline int64_t atomicAdd(volatile int64_t *target, int64_t value)
+	{
+		#if defined(_WIN32)
+			return InterlockedExchangeAdd64(target, value) + value;
+		#else
+			return __sync_add_and_fetch(target, value);
 		#endif
 	}
-	#endif
 
 	inline int atomicExchange(volatile int *target, int value)
 	{
@@ -242,6 +248,15 @@ namespace sw
 		#endif
 	}
 
+	inline int atomicCompareExchange(volatile int *target, int exchange, int comparand)
+	{
+		#if defined(_WIN32)
+			return InterlockedCompareExchange((volatile long*)target, exchange, comparand);
+		#else
+			return __sync_val_compare_and_swap(target, comparand, exchange);
+		#endif
+	}
+
 	inline void nop()
 	{
 		#if defined(_WIN32)
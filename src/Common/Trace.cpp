@@ -0,0 +1,217 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Trace.hpp"
+
+#include "MutexLock.hpp"
+#include "Thread.hpp"
+
+#include <stdio.h>
+
+namespace
+{
+	const int ringSize = 1 << 15;   // Events per thread, a power of two
+
+	struct TraceEvent
+	{
+		const char *name;
+		int64_t begin;
+		int64_t end;
+		int draw;
+		int unit;
+		int cluster;
+	};
+
+	struct ThreadRecord
+	{
+		int id;
+		std::string name;
+		TraceEvent *events;   // Allocated on the first event
+		volatile int count;   // Events recorded, of which the last ringSize are kept
+		ThreadRecord *next;
+	};
+
+	sw::MutexLock mutex;   // Protects all of the below
+	ThreadRecord *threads = nullptr;   // Never freed, since threads may outlive dumps
+	int threadCount = 0;
+	int64_t origin = 0;
+	std::string exitFile;
+
+	sw::Thread::LocalStorageKey threadKey = sw::Thread::allocateLocalStorageKey();
+
+	ThreadRecord *currentThread()
+	{
+		ThreadRecord *thread = (ThreadRecord*)sw::Thread::getLocalStorage(threadKey);
+
+		if(!thread)
+		{
+			thread = new ThreadRecord();
+			thread->events = nullptr;
+			thread->count = 0;
+
+			LockGuard lock(mutex);
+			thread->id = ++threadCount;
+			thread->next = threads;
+			threads = thread;
+
+			sw::Thread::setLocalStorage(threadKey, thread);
+		}
+
+		return thread;
+	}
+
+	// Writes the trace when the library is unloaded
+	struct ExitWriter
+	{
+		~ExitWriter()
+		{
+			if(sw::Trace::isEnabled() && !exitFile.empty())
+			{
+				sw::Trace::write(exitFile);
+			}
+		}
+	} exitWriter;
+}
+
+namespace sw
+{
+	volatile bool Trace::enabled = false;
+
+	void Trace::enable(const std::string &file)
+	{
+		LockGuard lock(mutex);
+
+		if(!origin)
+		{
+			origin = Timer::counter();
+		}
+
+		exitFile = file;
+		enabled = true;
+	}
+
+	void Trace::disable()
+	{
+		enabled = false;   // Keeps the events recorded so far
+	}
+
+	void Trace::nameThread(const char *name)
+	{
+		if(!enabled)
+		{
+			return;
+		}
+
+		ThreadRecord *thread = currentThread();
+
+		LockGuard lock(mutex);
+		thread->name = name;
+	}
+
+	void Trace::record(const char *name, int64_t begin, int64_t end, int draw, int unit, int cluster)
+	{
+		ThreadRecord *thread = currentThread();
+
+		if(!thread->events)
+		{
+			thread->events = new TraceEvent[ringSize];
+		}
+
+		TraceEvent &event = thread->events[thread->count & (ringSize - 1)];
+		event.name = name;
+		event.begin = begin;
+		event.end = end;
+		event.draw = draw;
+		event.unit = unit;
+		event.cluster = cluster;
+
+		atomicIncrement(&thread->count);   // Publishes the event
+	}
+
+	std::string Trace::json()
+	{
+		LockGuard lock(mutex);
+
+		double scale = 1.0e6 / Timer::frequency();   // To microseconds
+		std::string json = "{\"traceEvents\":[\n";
+		bool first = true;
+		char line[256];
+
+		for(ThreadRecord *thread = threads; thread; thread = thread->next)
+		{
+			if(!thread->name.empty())
+			{
+				snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%.64s\"}}",
+				         first ? "" : ",\n", thread->id, thread->name.c_str());
+
+				json += line;
+				first = false;
+			}
+
+			if(!thread->events)
+			{
+				continue;
+			}
+
+			// Events which get overwritten while this runs may appear torn
+			int count = thread->count;
+			int start = count > ringSize ? count - ringSize : 0;
+
+			for(int i = start; i < count; i++)
+			{
+				const TraceEvent &event = thread->events[i & (ringSize - 1)];
+
+				int length = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+				                      first ? "" : ",\n", event.name, thread->id, (event.begin - origin) * scale, (event.end - event.begin) * scale);
+
+				const char *separator = "";
+				const char *argumentNames[3] = {"draw", "unit", "cluster"};
+				const int arguments[3] = {event.draw, event.unit, event.cluster};
+
+				for(int a = 0; a < 3; a++)
+				{
+					if(arguments[a] >= 0)
+					{
+						length += snprintf(line + length, sizeof(line) - length, "%s\"%s\":%d", separator, argumentNames[a], arguments[a]);
+						separator = ",";
+					}
+				}
+
+				json += line;
+				json += "}}";
+				first = false;
+			}
+		}
+
+		json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		return json;
+	}
+
+	bool Trace::write(const std::string &file)
+	{
+		FILE *output = fopen(file.c_str(), "wb");
+
+		if(!output)
+		{
+			return false;
+		}
+
+		std::string trace = json();
+		bool written = fwrite(trace.data(), 1, trace.size(), output) == trace.size();
+		fclose(output);
+
+		return written;
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_Trace_hpp
+#define sw_Trace_hpp
+
+#include "Timer.hpp"
+#include "Types.hpp"
+
+#include <string>
+
+namespace sw
+{
+	// Records timeline events into a ring buffer per thread, which only its own
+	// thread writes to. The events can be written out in the Chrome trace event
+	// format, to be opened in chrome://tracing or Perfetto.
+	class Trace
+	{
+	public:
+		static void enable(const std::string &file);   // Written at exit, unless empty
+		static void disable();
+
+		static bool isEnabled()
+		{
+			return enabled;
+		}
+
+		static void nameThread(const char *name);   // Only when enabled
+
+		// The name has to be a string literal, as only its pointer is stored.
+		// Negative arguments are omitted.
+		static void record(const char *name, int64_t begin, int64_t end, int draw, int unit, int cluster);
+
+		static std::string json();
+		static bool write(const std::string &file);
+
+	private:
+		static volatile bool enabled;
+	};
+
+	// Records its lifetime as an event, when tracing is enabled on construction
+	class TraceScope
+	{
+	public:
+		explicit TraceScope(const char *name, int draw = -1, int unit = -1, int cluster = -1)
+			: name(Trace::isEnabled() ? name : nullptr), draw(draw), unit(unit), cluster(cluster)
+		{
+			if(this->name)
+			{
+				begin = Timer::counter();
+			}
+		}
+
+		~TraceScope()
+		{
+			if(name)
+			{
+				Trace::record(name, begin, Timer::counter(), draw, unit, cluster);
+			}
+		}
+
+	private:
+		const char *const name;
+		const int draw;
+		const int unit;
+		const int cluster;
+		int64_t begin;
+	};
+}
+
+#endif   // sw_Trace_hpp
@@ -77,10 +77,6 @@ namespace D3D8
 	{
 		TRACE("");
 
-		#if PERF_PROFILE
-			profiler.nextFrame();
-		#endif
-
 		void *source = backBuffer[0]->lockInternal(0, 0, 0, sw::LOCK_READONLY, sw::PUBLIC);   // FIXME: External
 		sw::Format format = backBuffer[0]->getInternalFormat();
 		int stride = backBuffer[0]->getInternalPitchB();
@@ -1829,7 +1829,7 @@ namespace D3D9
 			void *sourceBuffer = source->lockExternal(0, 0, 0, sw::LOCK_READONLY, sw::PUBLIC);
 			void *destBuffer = dest->lockExternal(0, 0, 0, sw::LOCK_WRITEONLY, sw::PUBLIC);
 
-			static void (__cdecl *blitFunction)(void *dst, void *src);
+			static void (__cdecl *blitFunction)(void *dst, void *src, void *cursor, const sw::Rect *region);
 			static sw::Routine *blitRoutine;
 			static sw::BlitState blitState = {0};
 
@@ -1848,10 +1848,11 @@ namespace D3D9
 				delete blitRoutine;
 
 				blitRoutine = sw::FrameBuffer::copyRoutine(blitState);
-				blitFunction = (void(__cdecl*)(void*, void*))blitRoutine->getEntry();
+				blitFunction = (void(__cdecl*)(void*, void*, void*, const sw::Rect*))blitRoutine->getEntry();
 			}
 
-			blitFunction(destBuffer, sourceBuffer);
+			sw::Rect region(0, 0, update.width, update.height);
+			blitFunction(destBuffer, sourceBuffer, nullptr, &region);
 
 			dest->unlockExternal();
 			source->unlockExternal();
@@ -16,6 +16,7 @@
 
 #include "Thread.hpp"
 #include "Timer.hpp"
+#include "Reactor/ExecutableMemory.hpp"
 
 namespace sw
 {
@@ -23,6 +24,33 @@ namespace sw
 
 	Profiler::Profiler()
 	{
+		enabled = false;
+		hud = false;
+
+		for(int i = 0; i < 16; i++)
+		{
+			threadBusy[i] = 0;
+		}
+
+		for(int type = 0; type < ROUTINE_TYPES; type++)
+		{
+			routineHits[type] = 0;
+			routineMisses[type] = 0;
+			compileTime[type] = 0;
+
+			for(int bucket = 0; bucket < COMPILE_BUCKETS; bucket++)
+			{
+				compileHistogram[type][bucket] = 0;
+			}
+		}
+
+		blits = 0;
+		blitTime = 0;
+		resolves = 0;
+		resolveTime = 0;
+		surfaceMemory = 0;
+		drawsQueued = 0;
+
 		reset();
 	}
 
@@ -32,37 +60,36 @@ namespace sw
 		framesTotal = 0;
 		FPS = 0;
 
-		#if PERF_PROFILE
-			for(int i = 0; i < PERF_TIMERS; i++)
-			{
-				cycles[i] = 0;
-			}
+		codeMemoryUsed = 0;
+		codeMemoryReserved = 0;
+		routineCount = 0;
 
-			ropOperations = 0;
-			ropOperationsTotal = 0;
-			ropOperationsFrame = 0;
+		specializableDraws = 0;
+		specializedDraws = 0;
 
-			texOperations = 0;
-			texOperationsTotal = 0;
-			texOperationsFrame = 0;
+		for(int i = 0; i < PERF_TIMERS; i++)
+		{
+			cycles[i] = 0;
+		}
 
-			compressedTex = 0;
-			compressedTexTotal = 0;
-			compressedTexFrame = 0;
-		#endif
+		for(int i = 0; i < PERF_COUNTERS; i++)
+		{
+			counters[i] = 0;
+			countersFrame[i] = 0;
+			countersTotal[i] = 0;
+		}
 	};
 
 	void Profiler::nextFrame()
 	{
-		#if PERF_PROFILE
-			ropOperationsFrame = sw::atomicExchange(&ropOperations, 0);
-			texOperationsFrame = sw::atomicExchange(&texOperations, 0);
-			compressedTexFrame = sw::atomicExchange(&compressedTex, 0);
-
-			ropOperationsTotal += ropOperationsFrame;
-			texOperationsTotal += texOperationsFrame;
-			compressedTexTotal += compressedTexFrame;
-		#endif
+		if(enabled)
+		{
+			for(int i = 0; i < PERF_COUNTERS; i++)
+			{
+				countersFrame[i] = sw::atomicExchange(&counters[i], 0);
+				countersTotal[i] += countersFrame[i];
+			}
+		}
 
 		static double fpsTime = sw::Timer::seconds();
 
@@ -72,6 +99,11 @@ namespace sw
 
 		if(delta > 1.0)
 		{
+			ExecutableMemoryStatistics codeMemory = getExecutableMemoryStatistics();
+			codeMemoryUsed = codeMemory.used;
+			codeMemoryReserved = codeMemory.reserved;
+			routineCount = codeMemory.allocations;
+
 			FPS = framesSec / delta;
 
 			fpsTime = time;
@@ -79,4 +111,29 @@ namespace sw
 			framesSec = 0;
 		}
 	}
+
+	void Profiler::routineCompiled(int type, int64_t time)
+	{
+		int64_t limit = Timer::frequency() / 1000;   // 1 ms
+		int bucket = 0;
+
+		while(time > limit && bucket < COMPILE_BUCKETS - 1)
+		{
+			limit *= 2;
+			bucket++;
+		}
+
+		atomicAdd(&routineMisses[type], (int64_t)1);
+		atomicAdd(&compileTime[type], time);
+		atomicAdd(&compileHistogram[type][bucket], (int64_t)1);
+	}
+
+	ProfilerTimer::ProfilerTimer(volatile int64_t *time) : time(time), start(Timer::counter())
+	{
+	}
+
+	ProfilerTimer::~ProfilerTimer()
+	{
+		atomicAdd(time, Timer::counter() - start);
+	}
 }
\ No newline at end of file
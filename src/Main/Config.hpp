@@ -17,9 +17,6 @@
 
 #include "Common/Types.hpp"
 
-#define PERF_HUD 0       // Display time spent on vertex, setup and pixel processing for each thread
-#define PERF_PROFILE 0   // Profile various pipeline stages and display the timing in SwiftConfig
-
 #if defined(_WIN32)
 #define S3TC_SUPPORT 1
 #else
@@ -47,6 +44,35 @@ namespace sw
 		PERF_TIMERS
 	};
 
+	enum
+	{
+		PERF_VERTICES,      // Vertices shaded, excluding vertex cache hits
+		PERF_PRIMITIVES,    // Primitives set up
+		PERF_CULLED,        // Primitives rejected by setup
+		PERF_CLIPPED,       // Primitives passed to the clipper
+		PERF_QUADS,         // 2x2 pixel quads rasterized
+		PERF_TEXTURE_OPERATIONS,
+		PERF_COMPRESSED_TEXTURE_OPERATIONS,
+		PERF_RASTER_OPERATIONS,
+
+		PERF_COUNTERS
+	};
+
+	enum
+	{
+		ROUTINE_VERTEX,
+		ROUTINE_SETUP,
+		ROUTINE_PIXEL,
+		ROUTINE_BLIT,
+
+		ROUTINE_TYPES
+	};
+
+	enum
+	{
+		COMPILE_BUCKETS = 9   // Compile times up to 1, 2, 4, ..., 128 ms, and longer
+	};
+
 	struct Profiler
 	{
 		Profiler();
@@ -58,21 +84,52 @@ namespace sw
 		int framesTotal;
 		double FPS;
 
-		#if PERF_PROFILE
+		int64_t codeMemoryUsed;       // Bytes of executable memory used by routines
+		int64_t codeMemoryReserved;   // Bytes of executable memory reserved from the OS
+		int routineCount;
+
+		int64_t specializableDraws;   // Draws with shaders that can be specialized for uniform values
+		int64_t specializedDraws;
+
+		// Instrumentation is compiled in, but only routines generated while enabled
+		// is set measure time and count pipeline operations
+		bool enabled;
+		bool hud;   // Display time spent on vertex, setup and pixel processing for each thread
+
 		double cycles[PERF_TIMERS];
 
-		int64_t ropOperations;
-		int64_t ropOperationsTotal;
-		int64_t ropOperationsFrame;
+		volatile int64_t counters[PERF_COUNTERS];   // Updated atomically by the pipeline
+		int64_t countersFrame[PERF_COUNTERS];
+		int64_t countersTotal[PERF_COUNTERS];
+
+		// Always collected and never reset, for the metrics endpoints. Times are in
+		// Timer::counter() units, unless noted otherwise.
+		void routineCompiled(int type, int64_t time);   // Counts a routine cache miss, and the time to compile its replacement
+
+		volatile int64_t threadBusy[16];   // Time spent executing tasks by each worker thread
+		volatile int64_t routineHits[ROUTINE_TYPES];
+		volatile int64_t routineMisses[ROUTINE_TYPES];
+		volatile int64_t compileTime[ROUTINE_TYPES];
+		volatile int64_t compileHistogram[ROUTINE_TYPES][COMPILE_BUCKETS];
+		volatile int64_t blits;
+		volatile int64_t blitTime;
+		volatile int64_t resolves;
+		volatile int64_t resolveTime;
+		volatile int64_t surfaceMemory;   // Bytes of surface buffers currently allocated
+		volatile int drawsQueued;         // Draws submitted to the renderer which haven't completed yet
+	};
+
+	// Adds its lifetime to one of the profiler's times
+	class ProfilerTimer
+	{
+	public:
+		explicit ProfilerTimer(volatile int64_t *time);
 
-		int64_t texOperations;
-		int64_t texOperationsTotal;
-		int64_t texOperationsFrame;
+		~ProfilerTimer();
 
-		int64_t compressedTex;
-		int64_t compressedTexTotal;
-		int64_t compressedTexFrame;
-		#endif
+	private:
+		volatile int64_t *const time;
+		const int64_t start;
 	};
 
 	extern Profiler profiler;
@@ -80,6 +137,8 @@ namespace sw
 	enum
 	{
 		OUTLINE_RESOLUTION = 8192,   // Maximum vertical resolution of the render target
+		GUARD_BAND = 1024,           // Distance from the viewport center beyond which triangles get clipped, in pixels. Keeps edge setup within 32-bit.
+		SMALL_TRIANGLE = 8,          // Maximum width and height of triangles rasterized using edge functions, in pixels
 		MIPMAP_LEVELS = 14,
 		TEXTURE_IMAGE_UNITS = 16,
 		VERTEX_TEXTURE_IMAGE_UNITS = 16,
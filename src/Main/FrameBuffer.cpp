@@ -18,6 +18,8 @@
 #include "Renderer/Surface.hpp"
 #include "Reactor/Reactor.hpp"
 #include "Common/Debug.hpp"
+#include "Common/Memory.hpp"
+#include "Common/Trace.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -27,8 +29,6 @@
 #include <cutils/properties.h>
 #endif
 
-#define ASYNCHRONOUS_BLIT 0   // FIXME: Currently leads to rare race conditions
-
 namespace sw
 {
 	extern bool forceWindowed;
@@ -65,22 +65,25 @@ namespace sw
 		blitState.cursorWidth = 0;
 		blitState.cursorHeight = 0;
 
-		if(ASYNCHRONOUS_BLIT)
+		for(int i = 0; i < STAGING_BUFFERS; i++)
 		{
-			terminate = false;
-			FrameBuffer *parameters = this;
-			blitThread = new Thread(threadFunction, &parameters);
+			staged[i].buffer = nullptr;
+			staged[i].size = 0;
 		}
+
+		head = 0;
+		pending = 0;
+		terminate = false;
+		presentThread = nullptr;
 	}
 
 	FrameBuffer::~FrameBuffer()
 	{
-		if(ASYNCHRONOUS_BLIT)
+		stopPresentThread();
+
+		for(int i = 0; i < STAGING_BUFFERS; i++)
 		{
-			terminate = true;
-			blitEvent.signal();
-			blitThread->join();
-			delete blitThread;
+			deallocate(staged[i].buffer);
 		}
 
 		delete blitRoutine;
@@ -130,13 +133,20 @@ namespace sw
 		cursor.positionY = y;
 	}
 
-	void FrameBuffer::copy(void *source, Format format, size_t stride)
+	void FrameBuffer::flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count)
+	{
+		flip(source, sourceFormat, sourceStride);
+	}
+
+	void FrameBuffer::copy(void *source, Format format, size_t stride, const Rect *damage, int count)
 	{
 		if(!source)
 		{
 			return;
 		}
 
+		TraceScope trace("Swap");
+
 		if(!lock())
 		{
 			return;
@@ -144,43 +154,149 @@ namespace sw
 
 		sourceFormat = format;
 
-		if(topLeftOrigin)
+		void *target = topLeftOrigin ? source : (byte*)source + (height - 1) * stride;
+
+		cursor.x = cursor.positionX - cursor.hotspotX;
+		cursor.y = cursor.positionY - cursor.hotspotY;
+
+		getDamage(damage, count, copyDamage);
+		copyLocked(target, format, &cursor, copyDamage);
+
+		unlock();
+
+		present(copyDamage.data(), (int)copyDamage.size());
+
+		profiler.nextFrame();   // Every swap counts as a frame, however little of it was damaged
+	}
+
+	void FrameBuffer::startPresentThread()
+	{
+		if(!presentThread)
 		{
-			target = source;
+			terminate = false;
+			presentThread = new Thread(presentThreadFunction, this);
 		}
-		else
+	}
+
+	void FrameBuffer::stopPresentThread()
+	{
+		if(!presentThread)
 		{
-			target = (byte*)source + (height - 1) * stride;
+			return;
 		}
 
-		cursor.x = cursor.positionX - cursor.hotspotX;
-		cursor.y = cursor.positionY - cursor.hotspotY;
+		// The present thread only terminates once all pending frames are presented
+		presentMutex.lock();
+		terminate = true;
+		presentMutex.unlock();
 
-		if(ASYNCHRONOUS_BLIT)
+		frameStaged.signal();
+		presentThread->join();
+		delete presentThread;
+		presentThread = nullptr;
+	}
+
+	void FrameBuffer::copyAsync(void *source, Format format, size_t stride, const Rect *damage, int count)
+	{
+		if(!source)
 		{
-			blitEvent.signal();
-			syncEvent.wait();
+			return;
 		}
-		else
+
+		ASSERT(presentThread);
+
+		TraceScope trace("Swap");
+
+		// Wait for the present thread to hand back a staging buffer
+		presentMutex.lock();
+
+		while(pending == STAGING_BUFFERS)
 		{
-			copyLocked();
+			presentMutex.unlock();
+			frameReleased.wait();
+			presentMutex.lock();
 		}
 
-		unlock();
+		StagedFrame &frame = staged[(head + pending) % STAGING_BUFFERS];
+
+		presentMutex.unlock();
+
+		size_t size = height * stride;
+
+		if(frame.size != size)
+		{
+			deallocate(frame.buffer);
+			frame.buffer = allocate(size);
+			frame.size = size;
+		}
 
-		profiler.nextFrame();   // Assumes every copy() is a full frame
+		frame.cursor = cursor;
+		frame.cursor.x = cursor.positionX - cursor.hotspotX;
+		frame.cursor.y = cursor.positionY - cursor.hotspotY;
+
+		// Only the rows which will be converted have to be staged
+		getDamage(damage, count, frame.damage);
+
+		for(const Rect &rect : frame.damage)
+		{
+			int row = topLeftOrigin ? rect.y0 : height - rect.y1;
+			size_t offset = row * stride;
+
+			memcpy((byte*)frame.buffer + offset, (byte*)source + offset, rect.height() * stride);
+		}
+
+		frame.target = topLeftOrigin ? frame.buffer : (byte*)frame.buffer + (height - 1) * stride;
+		frame.format = format;
+
+		presentMutex.lock();
+		pending++;
+		presentMutex.unlock();
+
+		frameStaged.signal();
+
+		profiler.nextFrame();   // Counted when staged, since presentation lags behind
 	}
 
-	void FrameBuffer::copyLocked()
+	void FrameBuffer::getDamage(const Rect *rects, int count, std::vector<Rect> &damage) const
+	{
+		damage.clear();
+
+		// The cursor isn't tracked as damage, so it forces a full update
+		if(!rects || cursor.width > 0)
+		{
+			damage.push_back(Rect(0, 0, width, height));
+			return;
+		}
+
+		for(int i = 0; i < count; i++)
+		{
+			Rect rect = rects[i];
+
+			if(!topLeftOrigin)
+			{
+				rect = Rect(rect.x0, height - rect.y1, rect.x1, height - rect.y0);
+			}
+
+			rect.x0 &= ~3;   // Keeps the copy routine's loads aligned
+			rect.clip(0, 0, width, height);
+
+			if(rect.x0 < rect.x1 && rect.y0 < rect.y1)
+			{
+				damage.push_back(rect);
+			}
+		}
+	}
+
+	void FrameBuffer::copyLocked(void *target, Format format, Cursor *cursor, const std::vector<Rect> &damage)
 	{
 		BlitState update = {};
 		update.width = width;
 		update.height = height;
 		update.destFormat = destFormat;
-		update.sourceFormat = sourceFormat;
+		update.sourceFormat = format;
 		update.stride = stride;
-		update.cursorWidth = cursor.width;
-		update.cursorHeight = cursor.height;
+		update.cursorWidth = cursor->width;
+		update.cursorHeight = cursor->height;
 
 		if(memcmp(&blitState, &update, sizeof(BlitState)) != 0)
 		{
@@ -188,10 +304,13 @@ namespace sw
 			delete blitRoutine;
 
 			blitRoutine = copyRoutine(blitState);
-			blitFunction = (void(*)(void*, void*, Cursor*))blitRoutine->getEntry();
+			blitFunction = (void(*)(void*, void*, Cursor*, const Rect*))blitRoutine->getEntry();
 		}
 
-		blitFunction(locked, target, &cursor);
+		for(const Rect &rect : damage)
+		{
+			blitFunction(locked, target, cursor, &rect);
+		}
 	}
 
 	Routine *FrameBuffer::copyRoutine(const BlitState &state)
@@ -204,18 +323,24 @@ namespace sw
 		const int sBytes = Surface::bytes(state.sourceFormat);
 		const int sStride = topLeftOrigin ? (sBytes * width2) : -(sBytes * width2);
 
-		Function<Void(Pointer<Byte>, Pointer<Byte>, Pointer<Byte>)> function;
+		Function<Void(Pointer<Byte>, Pointer<Byte>, Pointer<Byte>, Pointer<Byte>)> function;
 		{
 			Pointer<Byte> dst(function.Arg<0>());
 			Pointer<Byte> src(function.Arg<1>());
 			Pointer<Byte> cursor(function.Arg<2>());
+			Pointer<Byte> region(function.Arg<3>());
 
-			For(Int y = 0, y < height, y++)
-			{
-				Pointer<Byte> d = dst + y * dStride;
-				Pointer<Byte> s = src + y * sStride;
+			// Only the region is converted. Its left edge must be a multiple of 4 to
+			// keep the source loads aligned.
+			Int x0 = *Pointer<Int>(region + OFFSET(Rect,x0));
+			Int y0 = *Pointer<Int>(region + OFFSET(Rect,y0));
+			Int x1 = *Pointer<Int>(region + OFFSET(Rect,x1));
+			Int y1 = *Pointer<Int>(region + OFFSET(Rect,y1));
 
-				Int x0 = 0;
+			For(Int y = y0, y < y1, y++)
+			{
+				Pointer<Byte> d = dst + y * dStride + x0 * dBytes;
+				Pointer<Byte> s = src + y * sStride + x0 * sBytes;
 
 				switch(state.destFormat)
 				{
@@ -228,7 +353,7 @@ namespace sw
 						{
 						case FORMAT_X8R8G8B8:
 						case FORMAT_A8R8G8B8:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								*Pointer<Int4>(d, 1) = *Pointer<Int4>(s, sStride % 16 ? 1 : 16);
 
@@ -238,7 +363,7 @@ namespace sw
 							break;
 						case FORMAT_X8B8G8R8:
 						case FORMAT_A8B8G8R8:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								Int4 bgra = *Pointer<Int4>(s, sStride % 16 ? 1 : 16);
 
@@ -251,7 +376,7 @@ namespace sw
 							}
 							break;
 						case FORMAT_A16B16G16R16:
-							For(, x < width - 1, x += 2)
+							For(, x < x1 - 1, x += 2)
 							{
 								UShort4 c0 = As<UShort4>(Swizzle(*Pointer<Short4>(s + 0), 0xC6)) >> 8;
 								UShort4 c1 = As<UShort4>(Swizzle(*Pointer<Short4>(s + 8), 0xC6)) >> 8;
@@ -263,7 +388,7 @@ namespace sw
 							}
 							break;
 						case FORMAT_R5G6B5:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								Int4 rgb = Int4(*Pointer<Short4>(s));
 
@@ -280,7 +405,7 @@ namespace sw
 							break;
 						}
 
-						For(, x < width, x++)
+						For(, x < x1, x++)
 						{
 							switch(state.sourceFormat)
 							{
@@ -336,7 +461,7 @@ namespace sw
 						{
 						case FORMAT_X8B8G8R8:
 						case FORMAT_A8B8G8R8:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								*Pointer<Int4>(d, 1) = *Pointer<Int4>(s, sStride % 16 ? 1 : 16);
 
@@ -346,7 +471,7 @@ namespace sw
 							break;
 						case FORMAT_X8R8G8B8:
 						case FORMAT_A8R8G8B8:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								Int4 bgra = *Pointer<Int4>(s, sStride % 16 ? 1 : 16);
 
@@ -359,7 +484,7 @@ namespace sw
 							}
 							break;
 						case FORMAT_A16B16G16R16:
-							For(, x < width - 1, x += 2)
+							For(, x < x1 - 1, x += 2)
 							{
 								UShort4 c0 = *Pointer<UShort4>(s + 0) >> 8;
 								UShort4 c1 = *Pointer<UShort4>(s + 8) >> 8;
@@ -371,7 +496,7 @@ namespace sw
 							}
 							break;
 						case FORMAT_R5G6B5:
-							For(, x < width - 3, x += 4)
+							For(, x < x1 - 3, x += 4)
 							{
 								Int4 rgb = Int4(*Pointer<Short4>(s));
 
@@ -389,7 +514,7 @@ namespace sw
 							break;
 						}
 
-						For(, x < width, x++)
+						For(, x < x1, x++)
 						{
 							switch(state.sourceFormat)
 							{
@@ -435,7 +560,7 @@ namespace sw
 					break;
 				case FORMAT_R8G8B8:
 					{
-						For(Int x = x0, x < width, x++)
+						For(Int x = x0, x < x1, x++)
 						{
 							switch(state.sourceFormat)
 							{
@@ -477,7 +602,7 @@ namespace sw
 					break;
 				case FORMAT_R5G6B5:
 					{
-						For(Int x = x0, x < width, x++)
+						For(Int x = x0, x < x1, x++)
 						{
 							switch(state.sourceFormat)
 							{
@@ -651,20 +776,51 @@ namespace sw
 		}
 	}
 
-	void FrameBuffer::threadFunction(void *parameters)
+	void FrameBuffer::presentThreadFunction(void *parameters)
 	{
-		FrameBuffer *frameBuffer = *static_cast<FrameBuffer**>(parameters);
+		Trace::nameThread("Present");
 
-		while(!frameBuffer->terminate)
+		static_cast<FrameBuffer*>(parameters)->presentLoop();
+	}
+
+	void FrameBuffer::presentLoop()
+	{
+		while(true)
 		{
-			frameBuffer->blitEvent.wait();
+			presentMutex.lock();
 
-			if(!frameBuffer->terminate)
+			while(pending == 0 && !terminate)
 			{
-				frameBuffer->copyLocked();
+				presentMutex.unlock();
+				frameStaged.wait();
+				presentMutex.lock();
+			}
+
+			if(pending == 0)
+			{
+				presentMutex.unlock();
+				return;
+			}
+
+			StagedFrame &frame = staged[head];
 
-				frameBuffer->syncEvent.signal();
+			presentMutex.unlock();
+
+			TraceScope trace("Present");
+
+			if(lock())
+			{
+				copyLocked(frame.target, frame.format, &frame.cursor, frame.damage);
+				unlock();
+				present(frame.damage.data(), (int)frame.damage.size());
 			}
+
+			presentMutex.lock();
+			head = (head + 1) % STAGING_BUFFERS;
+			pending--;
+			presentMutex.unlock();
+
+			frameReleased.signal();
 		}
 	}
 }
@@ -18,6 +18,9 @@
 #include "Reactor/Reactor.hpp"
 #include "Renderer/Surface.hpp"
 #include "Common/Thread.hpp"
+#include "Common/MutexLock.hpp"
+
+#include <vector>
 
 namespace sw
 {
@@ -34,6 +37,18 @@ namespace sw
 		int cursorHeight;
 	};
 
+	// Memory which a back buffer can be rendered into directly, laid out like the
+	// source of FrameBuffer::flip(), so that flipping it only has to present it.
+	// Can outlive the frame buffer which created it.
+	class SharedBackBuffer
+	{
+	public:
+		virtual ~SharedBackBuffer() {}
+
+		virtual void *getPixels() = 0;   // First row of the source
+		virtual int getPitchB() = 0;     // Negative when rows are stored bottom-up
+	};
+
 	class [[clang::lto_visibility_public]] FrameBuffer
 	{
 	public:
@@ -48,9 +63,17 @@ namespace sw
 		virtual void flip(void *source, Format sourceFormat, size_t sourceStride) = 0;
 		virtual void blit(void *source, const Rect *sourceRect, const Rect *destRect, Format sourceFormat, size_t sourceStride) = 0;
 
+		// Only the damaged rectangles have to be updated. They're in the coordinates
+		// of the source, so their origin is at its first row. Without an override
+		// the whole source is flipped.
+		virtual void flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count);
+
 		virtual void *lock() = 0;
 		virtual void unlock() = 0;
 
+		// Returns null when back buffers of this format have to be copied
+		virtual SharedBackBuffer *createSharedBackBuffer(Format format) { return nullptr; }
+
 		static void setCursorImage(sw::Surface *cursor);
 		static void setCursorOrigin(int x0, int y0);
 		static void setCursorPosition(int x, int y);
@@ -58,7 +81,25 @@ namespace sw
 		static Routine *copyRoutine(const BlitState &state);
 
 	protected:
-		void copy(void *source, Format format, size_t stride);
+		// A null damage array means the whole source, while an empty one means
+		// nothing has to be copied.
+		void copy(void *source, Format format, size_t stride, const Rect *damage = nullptr, int count = 0);
+
+		// Asynchronous presentation. copyAsync() stages the source in a buffer owned
+		// by the frame buffer and returns, leaving the conversion and the call to
+		// present() to the present thread. Derived classes have to call
+		// stopPresentThread() before destroying anything present() depends on.
+		void startPresentThread();
+		void stopPresentThread();
+		void copyAsync(void *source, Format format, size_t stride, const Rect *damage = nullptr, int count = 0);
+
+		// Called after a copy to make the given rectangles of the locked buffer
+		// visible. They're in window coordinates.
+		virtual void present(const Rect *damage, int count) {}
+
+		// Transforms damage in source coordinates into window coordinates
+		void getDamage(const Rect *rects, int count, std::vector<Rect> &damage) const;
+
 		int width;
 		int height;
 		Format sourceFormat;
@@ -69,12 +110,6 @@ namespace sw
 		void *locked;   // Video memory back buffer
 
 	private:
-		void copyLocked();
-
-		static void threadFunction(void *parameters);
-
-		void *target;   // Render target buffer
-
 		struct Cursor
 		{
 			void *image;
@@ -90,16 +125,40 @@ namespace sw
 
 		static Cursor cursor;
 
-		void (*blitFunction)(void *dst, void *src, Cursor *cursor);
+		void copyLocked(void *target, Format format, Cursor *cursor, const std::vector<Rect> &damage);
+
+		static void presentThreadFunction(void *parameters);
+		void presentLoop();
+
+		void (*blitFunction)(void *dst, void *src, Cursor *cursor, const Rect *region);
 		Routine *blitRoutine;
 		BlitState blitState;
+		std::vector<Rect> copyDamage;
 
 		static void blend(const BlitState &state, const Pointer<Byte> &d, const Pointer<Byte> &s, const Pointer<Byte> &c);
 
-		Thread *blitThread;
-		Event syncEvent;
-		Event blitEvent;
-		volatile bool terminate;
+		enum {STAGING_BUFFERS = 2};
+
+		struct StagedFrame
+		{
+			void *buffer;
+			size_t size;
+			void *target;   // Source of the copy routine, within buffer
+			Format format;
+			Cursor cursor;
+			std::vector<Rect> damage;   // In window coordinates
+		};
+
+		// Frames are staged in ring order. Slots [head, head + pending) belong to the
+		// present thread, the others to the thread calling copyAsync().
+		StagedFrame staged[STAGING_BUFFERS];
+		int head;
+		int pending;
+		bool terminate;
+		MutexLock presentMutex;   // Protects head, pending and terminate
+		Event frameStaged;
+		Event frameReleased;
+		Thread *presentThread;
 
 		static bool topLeftOrigin;
 	};
@@ -0,0 +1,339 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// FrameBufferHeadless.cpp: Implements the FrameBufferHeadless class, which
+// delivers frames to memory or files instead of presenting them in a window.
+
+#include "FrameBufferHeadless.hpp"
+
+#include "Common/Debug.hpp"
+#include "Common/Memory.hpp"
+#include "Common/Thread.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace sw
+{
+	namespace
+	{
+		// Owns the memory a callback sink's back buffer is rendered into, so that it
+		// stays valid when the frame buffer is destroyed first
+		class HeadlessBackBuffer : public SharedBackBuffer
+		{
+		public:
+			HeadlessBackBuffer(int height, int pitchB) : height(height), pitchB(pitchB)
+			{
+				// Render targets are processed in 2x2 quads, so an odd height needs a
+				// row above the top one. The extra bytes match Surface::allocateBuffer().
+				int height2 = (height + 1) & ~1;
+				memory = allocateZero(height2 * pitchB + 4);
+				frame = (byte*)memory + (height2 - height) * pitchB;
+			}
+
+			~HeadlessBackBuffer() override
+			{
+				deallocate(memory);
+			}
+
+			// Frames are delivered top-down, while the source of a flip is bottom-up
+			void *getPixels() override
+			{
+				return (byte*)frame + (height - 1) * pitchB;
+			}
+
+			int getPitchB() override
+			{
+				return -pitchB;
+			}
+
+			void *getFrame() const
+			{
+				return frame;
+			}
+
+		private:
+			void *memory;
+			void *frame;   // Top row
+			const int height;
+			const int pitchB;
+		};
+
+		// Offset of the first buffer in a ring sink's file
+		const int ringOffset = 64;
+	}
+
+	FrameBufferHeadless::FrameBufferHeadless(const EGLHeadlessWindowSW *window, int width, int height, bool asynchronous)
+		: FrameBuffer(width, height, false, false), sink(window->sink), callback(window->callback), userData(window->userData),
+		  asynchronous(asynchronous), sequence(0), buffer(nullptr), ring(nullptr), ringSize(0), ringBuffers(window->bufferCount), file(nullptr),
+		  sharedPixels(nullptr), sharedFrame(nullptr), sharedPitchB(0)
+	{
+		stride = width * 4;
+
+		switch(sink)
+		{
+		case EGL_HEADLESS_SINK_CALLBACK_SW:
+			break;
+		case EGL_HEADLESS_SINK_RING_SW:
+			{
+				// Readers may still have the previous file mapped, so it can't be truncated
+				ringPath = window->path;
+				unlink(ringPath.c_str());
+
+				int fd = open(ringPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+				ringSize = ringOffset + (size_t)ringBuffers * height * stride;
+
+				if(fd != -1 && ftruncate(fd, ringSize) == 0)
+				{
+					void *memory = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+					if(memory != MAP_FAILED)
+					{
+						ring = (EGLHeadlessRingSW*)memory;
+						ring->width = width;
+						ring->height = height;
+						ring->stride = stride;
+						ring->bufferCount = ringBuffers;
+						ring->offset = ringOffset;
+						ring->sequence = 0;
+						atomicExchange(&ring->magic, EGL_HEADLESS_WINDOW_MAGIC_SW);
+					}
+				}
+
+				if(fd != -1)
+				{
+					close(fd);
+				}
+
+				if(!ring)
+				{
+					// Frames are still rendered into the plain buffer below, but not delivered
+					TRACE("Failed to map frame ring %s", ringPath.c_str());
+				}
+			}
+			break;
+		case EGL_HEADLESS_SINK_RAW_SW:
+		case EGL_HEADLESS_SINK_Y4M_SW:
+			file = fopen(window->path, "wb");
+
+			if(!file)
+			{
+				TRACE("Failed to open frame file %s", window->path);
+			}
+			else if(sink == EGL_HEADLESS_SINK_Y4M_SW)
+			{
+				// Chroma is averaged over 2x2 pixels, which places it like JPEG does
+				int frameRate = (window->frameRate > 0) ? window->frameRate : 30;
+				fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, frameRate);
+			}
+			break;
+		default:
+			ASSERT(false);
+		}
+
+		if(!ring)
+		{
+			buffer = allocateZero(height * stride + 4);
+		}
+
+		// Only the file sinks benefit from writing frames on another thread, while
+		// the memory sinks hand out the frame itself
+		this->asynchronous = asynchronous && file;
+
+		if(this->asynchronous)
+		{
+			startPresentThread();
+		}
+	}
+
+	FrameBufferHeadless::~FrameBufferHeadless()
+	{
+		stopPresentThread();   // Writes any pending frames
+
+		if(ring)
+		{
+			atomicExchange(&ring->magic, 0);   // Tells readers the ring is abandoned
+			munmap(ring, ringSize);
+			unlink(ringPath.c_str());
+		}
+
+		if(file)
+		{
+			fclose(file);
+		}
+
+		deallocate(buffer);
+	}
+
+	void *FrameBufferHeadless::getFrame()
+	{
+		if(ring)
+		{
+			return (byte*)ring + ringOffset + (size_t)(sequence % ringBuffers) * height * stride;
+		}
+
+		return buffer;
+	}
+
+	void *FrameBufferHeadless::lock()
+	{
+		locked = getFrame();
+
+		return locked;
+	}
+
+	void FrameBufferHeadless::unlock()
+	{
+		locked = nullptr;
+	}
+
+	SharedBackBuffer *FrameBufferHeadless::createSharedBackBuffer(Format format)
+	{
+		// Only callbacks can be handed the back buffer itself. The other sinks keep
+		// frames after the swap, while the next one is being rendered.
+		if(sink != EGL_HEADLESS_SINK_CALLBACK_SW || sharedPixels ||
+		   (format != FORMAT_X8R8G8B8 && format != FORMAT_A8R8G8B8))
+		{
+			return nullptr;
+		}
+
+		HeadlessBackBuffer *sharedBuffer = new HeadlessBackBuffer(height, Surface::pitchB(width, format, true));
+		sharedPixels = sharedBuffer->getPixels();
+		sharedFrame = sharedBuffer->getFrame();
+		sharedPitchB = -sharedBuffer->getPitchB();
+
+		return sharedBuffer;
+	}
+
+	void FrameBufferHeadless::blit(void *source, const Rect *sourceRect, const Rect *destRect, Format sourceFormat, size_t sourceStride)
+	{
+		flipWithDamage(source, sourceFormat, sourceStride, nullptr, 0);
+	}
+
+	void FrameBufferHeadless::flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count)
+	{
+		if(source && source == sharedPixels)
+		{
+			deliver(sharedFrame, sharedPitchB);
+		}
+		else if(asynchronous)
+		{
+			copyAsync(source, sourceFormat, sourceStride, damage, count);
+		}
+		else if(ring)
+		{
+			copy(source, sourceFormat, sourceStride);   // Ring buffers hold older frames, so damage doesn't apply
+		}
+		else
+		{
+			copy(source, sourceFormat, sourceStride, damage, count);
+		}
+	}
+
+	void FrameBufferHeadless::present(const Rect *damage, int count)
+	{
+		deliver(getFrame(), stride);   // Every swap is a frame, even when nothing changed
+	}
+
+	void FrameBufferHeadless::deliver(const void *pixels, int pitchB)
+	{
+		sequence++;
+
+		switch(sink)
+		{
+		case EGL_HEADLESS_SINK_CALLBACK_SW:
+			{
+				EGLHeadlessFrameSW frame;
+				frame.pixels = pixels;
+				frame.width = width;
+				frame.height = height;
+				frame.stride = pitchB;
+				frame.sequence = sequence;
+
+				callback(userData, &frame);
+			}
+			break;
+		case EGL_HEADLESS_SINK_RING_SW:
+			if(ring)
+			{
+				atomicExchange(&ring->sequence, sequence);   // Publishes the frame after its pixels
+			}
+			break;
+		case EGL_HEADLESS_SINK_RAW_SW:
+			if(file)
+			{
+				fwrite(pixels, 1, height * pitchB, file);   // Frame buffer rows aren't padded
+			}
+			break;
+		case EGL_HEADLESS_SINK_Y4M_SW:
+			if(file)
+			{
+				writeY4M(pixels, pitchB);
+			}
+			break;
+		default:
+			ASSERT(false);
+		}
+	}
+
+	void FrameBufferHeadless::writeY4M(const void *pixels, int pitchB)
+	{
+		// BT.601 with limited range, like most players assume for YUV4MPEG2
+		int chromaWidth = (width + 1) / 2;
+		int chromaHeight = (height + 1) / 2;
+		planes.resize(width * height + 2 * chromaWidth * chromaHeight);
+
+		unsigned char *Y = planes.data();
+		unsigned char *U = Y + width * height;
+		unsigned char *V = U + chromaWidth * chromaHeight;
+
+		for(int y = 0; y < height; y++)
+		{
+			const unsigned char *row = (const unsigned char*)pixels + y * pitchB;
+
+			for(int x = 0; x < width; x++)
+			{
+				int b = row[4 * x + 0];
+				int g = row[4 * x + 1];
+				int r = row[4 * x + 2];
+
+				Y[y * width + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			}
+		}
+
+		for(int y = 0; y < chromaHeight; y++)
+		{
+			const unsigned char *row0 = (const unsigned char*)pixels + (2 * y) * pitchB;
+			const unsigned char *row1 = (2 * y + 1 < height) ? row0 + pitchB : row0;
+
+			for(int x = 0; x < chromaWidth; x++)
+			{
+				int x0 = 4 * (2 * x);
+				int x1 = (2 * x + 1 < width) ? x0 + 4 : x0;
+
+				int b = row0[x0 + 0] + row0[x1 + 0] + row1[x0 + 0] + row1[x1 + 0];
+				int g = row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1];
+				int r = row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2];
+
+				U[y * chromaWidth + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+				V[y * chromaWidth + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+			}
+		}
+
+		fputs("FRAME\n", file);
+		fwrite(planes.data(), 1, planes.size(), file);
+	}
+}
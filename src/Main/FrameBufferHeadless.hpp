@@ -0,0 +1,75 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_FrameBufferHeadless_hpp
+#define sw_FrameBufferHeadless_hpp
+
+#include "Main/FrameBuffer.hpp"
+
+#include <EGL/eglext_swiftshader.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace sw
+{
+	// Presents to the sink of an EGLHeadlessWindowSW instead of a window system
+	class FrameBufferHeadless : public FrameBuffer
+	{
+	public:
+		FrameBufferHeadless(const EGLHeadlessWindowSW *window, int width, int height, bool asynchronous);
+
+		~FrameBufferHeadless() override;
+
+		void flip(void *source, Format sourceFormat, size_t sourceStride) override {blit(source, 0, 0, sourceFormat, sourceStride);};
+		void blit(void *source, const Rect *sourceRect, const Rect *destRect, Format sourceFormat, size_t sourceStride) override;
+		void flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count) override;
+
+		void *lock() override;
+		void unlock() override;
+
+		SharedBackBuffer *createSharedBackBuffer(Format format) override;
+
+	protected:
+		void present(const Rect *damage, int count) override;
+
+	private:
+		void *getFrame();   // Memory the next copy converts into
+		void deliver(const void *pixels, int pitchB);
+		void writeY4M(const void *pixels, int pitchB);
+
+		const int sink;
+		PFNEGLHEADLESSCALLBACKSWPROC callback;
+		void *userData;
+		bool asynchronous;
+		int sequence;   // Frames delivered so far
+
+		void *buffer;   // Callback and file sinks
+
+		EGLHeadlessRingSW *ring;   // Mapping of the ring sink's file
+		size_t ringSize;
+		int ringBuffers;
+		std::string ringPath;
+
+		FILE *file;
+		std::vector<unsigned char> planes;   // Y4M sink
+
+		void *sharedPixels;   // Source which is rendered in place
+		void *sharedFrame;    // Its top row
+		int sharedPitchB;
+	};
+}
+
+#endif   // sw_FrameBufferHeadless_hpp
@@ -17,11 +17,14 @@
 // Implements EGLSurface and related functionality. [EGL 1.4] section 2.2 page 3.
 
 #include "FrameBufferX11.hpp"
+#include "FrameBufferHeadless.hpp"
 
 #include "libX11.hpp"
+#include "Common/Configurator.hpp"
 
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -44,8 +47,59 @@ namespace sw
 		}
 	}
 
-	FrameBufferX11::FrameBufferX11(Display *display, Window window, int width, int height) : FrameBuffer(width, height, false, false), ownX11(!display), x_display(display), x_window(window)
+	namespace
 	{
+		// Maps the image's MIT-SHM segment a second time, so the back buffer stays
+		// valid when the frame buffer is destroyed first
+		class SharedMemoryBackBuffer : public SharedBackBuffer
+		{
+		public:
+			SharedMemoryBackBuffer(void *memory, int height, int bytesPerLine) : memory(memory), height(height), bytesPerLine(bytesPerLine)
+			{
+			}
+
+			~SharedMemoryBackBuffer() override
+			{
+				shmdt(memory);
+			}
+
+			// X11 images are stored top-down, while the source of a flip is bottom-up
+			void *getPixels() override
+			{
+				return (char*)memory + (height - 1) * bytesPerLine;
+			}
+
+			int getPitchB() override
+			{
+				return -bytesPerLine;
+			}
+
+		private:
+			void *const memory;
+			const int height;
+			const int bytesPerLine;
+		};
+	}
+
+	FrameBufferX11::FrameBufferX11(Display *display, Window window, int width, int height, bool asynchronous, bool zeroCopy) : FrameBuffer(width, height, false, false), asynchronous(asynchronous), zeroCopy(zeroCopy), ownX11(!display), x_display(display), x_window(window), sharedPixels(nullptr)
+	{
+		if(asynchronous && x_display)
+		{
+			// Xlib connections can't be used by multiple threads without XInitThreads(),
+			// so the present thread gets a connection of its own
+			Display *present_display = libX11->XOpenDisplay(DisplayString(x_display));
+
+			if(present_display)
+			{
+				x_display = present_display;
+				ownX11 = true;
+			}
+			else
+			{
+				this->asynchronous = false;
+			}
+		}
+
 		if(!x_display)
 		{
 			x_display = libX11->XOpenDisplay(0);
@@ -65,7 +119,8 @@ namespace sw
 		{
 			x_image = libX11->XShmCreateImage(x_display, visual, depth, ZPixmap, 0, &shminfo, width, height);
 
-			shminfo.shmid = shmget(IPC_PRIVATE, x_image->bytes_per_line * x_image->height, IPC_CREAT | SHM_R | SHM_W);
+			// The extra bytes allow the segment to back a render target, like Surface::allocateBuffer()
+			shminfo.shmid = shmget(IPC_PRIVATE, x_image->bytes_per_line * x_image->height + 4, IPC_CREAT | SHM_R | SHM_W);
 			shminfo.shmaddr = x_image->data = buffer = (char*)shmat(shminfo.shmid, 0, 0);
 			shminfo.readOnly = False;
 
@@ -91,10 +146,17 @@ namespace sw
 			buffer = new char[width * height * 4];
 			x_image = libX11->XCreateImage(x_display, visual, depth, ZPixmap, 0, buffer, width, height, 32, width * 4);
 		}
+
+		if(this->asynchronous)
+		{
+			startPresentThread();
+		}
 	}
 
 	FrameBufferX11::~FrameBufferX11()
 	{
+		stopPresentThread();   // Presents any pending frames
+
 		if(!mit_shm)
 		{
 			x_image->data = 0;
@@ -130,17 +192,80 @@ namespace sw
 		locked = 0;
 	}
 
+	SharedBackBuffer *FrameBufferX11::createSharedBackBuffer(Format format)
+	{
+		// Formats and pitch have to match exactly, or the copy routine is needed.
+		// Render targets are processed in 2x2 quads, so an odd height would touch
+		// the row above the segment.
+		bool match = zeroCopy && mit_shm && !sharedPixels && (height & 1) == 0 &&
+		             (format == FORMAT_X8R8G8B8 || format == FORMAT_A8R8G8B8) &&
+		             x_image->bits_per_pixel == 32 &&
+		             x_image->red_mask == 0xFF0000 && x_image->green_mask == 0x00FF00 && x_image->blue_mask == 0x0000FF &&
+		             x_image->bytes_per_line == Surface::pitchB(width, format, true);
+
+		if(!match)
+		{
+			return nullptr;
+		}
+
+		void *memory = shmat(shminfo.shmid, 0, 0);
+
+		if(memory == (void*)-1)
+		{
+			return nullptr;
+		}
+
+		SharedBackBuffer *sharedBuffer = new SharedMemoryBackBuffer(memory, height, x_image->bytes_per_line);
+		sharedPixels = sharedBuffer->getPixels();
+
+		// Frames rendered in place can't be presented while the next one is rendered
+		stopPresentThread();
+		asynchronous = false;
+
+		return sharedBuffer;
+	}
+
 	void FrameBufferX11::blit(void *source, const Rect *sourceRect, const Rect *destRect, Format sourceFormat, size_t sourceStride)
 	{
-		copy(source, sourceFormat, sourceStride);
+		flipWithDamage(source, sourceFormat, sourceStride, nullptr, 0);
+	}
 
-		if(!mit_shm)
+	void FrameBufferX11::flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count)
+	{
+		if(source && source == sharedPixels)
+		{
+			getDamage(damage, count, sharedDamage);
+			present(sharedDamage.data(), (int)sharedDamage.size());
+		}
+		else if(asynchronous)
 		{
-			libX11->XPutImage(x_display, x_window, x_gc, x_image, 0, 0, 0, 0, width, height);
+			copyAsync(source, sourceFormat, sourceStride, damage, count);
 		}
 		else
 		{
-			libX11->XShmPutImage(x_display, x_window, x_gc, x_image, 0, 0, 0, 0, width, height, False);
+			copy(source, sourceFormat, sourceStride, damage, count);
+		}
+	}
+
+	void FrameBufferX11::present(const Rect *damage, int count)
+	{
+		if(count == 0)
+		{
+			return;
+		}
+
+		for(int i = 0; i < count; i++)
+		{
+			const Rect &rect = damage[i];
+
+			if(!mit_shm)
+			{
+				libX11->XPutImage(x_display, x_window, x_gc, x_image, rect.x0, rect.y0, rect.x0, rect.y0, rect.width(), rect.height());
+			}
+			else
+			{
+				libX11->XShmPutImage(x_display, x_window, x_gc, x_image, rect.x0, rect.y0, rect.x0, rect.y0, rect.width(), rect.height(), False);
+			}
 		}
 
 		libX11->XSync(x_display, False);
@@ -149,5 +274,19 @@ namespace sw
 
 sw::FrameBuffer *createFrameBuffer(void *display, Window window, int width, int height)
 {
-	return new sw::FrameBufferX11((::Display*)display, window, width, height);
+	sw::Configurator ini("SwiftShader.ini");
+	bool asynchronous = ini.getBoolean("Testing", "AsynchronousPresent", false);
+	bool zeroCopy = ini.getBoolean("Testing", "ZeroCopyPresent", false);
+
+	if(getenv("SWIFTSHADER_ASYNCHRONOUS_PRESENT"))   // Lets tests cover both present paths regardless of SwiftShader.ini
+	{
+		asynchronous = atoi(getenv("SWIFTSHADER_ASYNCHRONOUS_PRESENT")) != 0;
+	}
+
+	if(!display)   // Displays without an X server only have headless windows
+	{
+		return new sw::FrameBufferHeadless((const EGLHeadlessWindowSW*)window, width, height, asynchronous);
+	}
+
+	return new sw::FrameBufferX11((::Display*)display, window, width, height, asynchronous, zeroCopy);
 }
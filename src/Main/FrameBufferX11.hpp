@@ -31,17 +31,25 @@ namespace sw
 	class FrameBufferX11 : public FrameBuffer
 	{
 	public:
-		FrameBufferX11(Display *display, Window window, int width, int height);
+		FrameBufferX11(Display *display, Window window, int width, int height, bool asynchronous, bool zeroCopy);
 
 		~FrameBufferX11() override;
 
 		void flip(void *source, Format sourceFormat, size_t sourceStride) override {blit(source, 0, 0, sourceFormat, sourceStride);};
 		void blit(void *source, const Rect *sourceRect, const Rect *destRect, Format sourceFormat, size_t sourceStride) override;
+		void flipWithDamage(void *source, Format sourceFormat, size_t sourceStride, const Rect *damage, int count) override;
 
 		void *lock() override;
 		void unlock() override;
 
+		SharedBackBuffer *createSharedBackBuffer(Format format) override;
+
+	protected:
+		void present(const Rect *damage, int count) override;
+
 	private:
+		bool asynchronous;
+		bool zeroCopy;
 		bool ownX11;
 		Display *x_display;
 		Window x_window;
@@ -53,6 +61,9 @@ namespace sw
 		XShmSegmentInfo shminfo;
 
 		char *buffer;
+
+		void *sharedPixels;   // Source which is rendered in place
+		std::vector<Rect> sharedDamage;
 	};
 }
 
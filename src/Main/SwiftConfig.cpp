@@ -17,10 +17,14 @@
 #include "Configurator.hpp"
 #include "Debug.hpp"
 #include "Config.hpp"
+#include "Trace.hpp"
+#include "Timer.hpp"
+#include "Reactor/ExecutableMemory.hpp"
 #include "Version.h"
 
 #include <sstream>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <sys/stat.h>
 #include <string.h>
@@ -28,6 +32,7 @@
 namespace sw
 {
 	extern Profiler profiler;
+	extern int threadCount;
 
 	std::string itoa(int number)
 	{
@@ -36,6 +41,13 @@ namespace sw
 		return ss.str();
 	}
 
+	std::string ltoa(int64_t number)
+	{
+		std::stringstream ss;
+		ss << number;
+		return ss.str();
+	}
+
 	std::string ftoa(double number)
 	{
 		std::stringstream ss;
@@ -71,7 +83,7 @@ namespace sw
 		receiveBuffer = new char[bufferLength];
 
 		Socket::startup();
-		listenSocket = new Socket("localhost", "8080");
+		listenSocket = new Socket("localhost", itoa(config.serverPort).c_str());
 		listenSocket->listen();
 
 		terminate = false;
@@ -135,7 +147,7 @@ namespace sw
 
 				while(bytesReceived > 0 && !terminate)
 				{
-					if(clientSocket->select(10))
+					if(clientSocket->select(100000))   // Scrapers keep their connection open between requests
 					{
 						bytesReceived = clientSocket->receive(receiveBuffer, bufferLength);
 
@@ -177,6 +189,14 @@ namespace sw
 				{
 					return send(clientSocket, OK, page());
 				}
+				else if(match(&request, "/metrics "))
+				{
+					return send(clientSocket, OK, metrics(), "text/plain; version=0.0.4");
+				}
+				else if(match(&request, "/metrics.json "))
+				{
+					return send(clientSocket, OK, metricsJSON(), "application/json");
+				}
 			}
 		}
 		else if(match(&request, "POST /"))
@@ -221,6 +241,10 @@ namespace sw
 				{
 					return send(clientSocket, OK, profile());
 				}
+				else if(match(&request, "/trace "))
+				{
+					return send(clientSocket, OK, Trace::json(), "application/json");
+				}
 			}
 		}
 
@@ -247,7 +271,7 @@ namespace sw
 		html += "function request()\n";
 		html += "{\n";
 		html += "var xhr = new XMLHttpRequest();\n";
-		html += "xhr.open('POST', 'http://localhost:8080/swiftshader/profile', true);\n";
+		html += "xhr.open('POST', '/swiftshader/profile', true);\n";
 		html += "xhr.onreadystatechange = function()\n";
 		html += "{\n";
 		html += "if(xhr.readyState == 4 && xhr.status == 200)\n";
@@ -333,6 +357,23 @@ namespace sw
 		html += "<option value='4096'" + (config.setupRoutineCacheSize == 4096 ? selected : empty) + ">4096</option>\n";
 		html += "</select></td>\n";
 		html += "</tr>\n";
+		html += "<tr><td>Code memory budget:</td><td><select name='codeMemoryBudget' title='The amount of memory available to dynamically generated routines. When exceeded, the least recently used routines get evicted from the caches.'>\n";
+		html += "<option value='32'"  + (config.codeMemoryBudget == 32  ? selected : empty) + ">32 MB</option>\n";
+		html += "<option value='64'"  + (config.codeMemoryBudget == 64  ? selected : empty) + ">64 MB</option>\n";
+		html += "<option value='128'" + (config.codeMemoryBudget == 128 ? selected : empty) + ">128 MB (default)</option>\n";
+		html += "<option value='256'" + (config.codeMemoryBudget == 256 ? selected : empty) + ">256 MB</option>\n";
+		html += "<option value='512'" + (config.codeMemoryBudget == 512 ? selected : empty) + ">512 MB</option>\n";
+		html += "<option value='0'"   + (config.codeMemoryBudget == 0   ? selected : empty) + ">Unlimited</option>\n";
+		html += "</select></td>\n";
+		html += "</tr>\n";
+		html += "<tr><td>Draw queue memory:</td><td><select name='drawQueueMemory' title='The amount of memory available to draw calls queued ahead of the renderer. More memory lets the application run further ahead when issuing many small draw calls.'>\n";
+		html += "<option value='2'"  + (config.drawQueueMemory == 2  ? selected : empty) + ">2 MB</option>\n";
+		html += "<option value='8'"  + (config.drawQueueMemory == 8  ? selected : empty) + ">8 MB</option>\n";
+		html += "<option value='16'" + (config.drawQueueMemory == 16 ? selected : empty) + ">16 MB</option>\n";
+		html += "<option value='32'" + (config.drawQueueMemory == 32 ? selected : empty) + ">32 MB (default)</option>\n";
+		html += "<option value='64'" + (config.drawQueueMemory == 64 ? selected : empty) + ">64 MB</option>\n";
+		html += "</select></td>\n";
+		html += "</tr>\n";
 		html += "<tr><td>Vertex cache size:</td><td><select name='vertexCacheSize' title='The number of processed vertices being cached for reuse. Lower numbers save memory but require more vertices to be reprocessed.'>\n";
 		html += "<option value='64'"   + (config.vertexCacheSize == 64   ? selected : empty) + ">64 (default)</option>\n";
 		html += "</select></td>\n";
@@ -416,6 +457,13 @@ namespace sw
 			html += "</select></td></tr>\n";
 		}
 
+		html += "<tr><td>Uniform specialization:</td><td><select name='shaderSpecialization' title='The number of routine variants per shader which are specialized for the values of uniforms that control flow depends on.'>\n";
+		html += "<option value='0'"  + (config.shaderSpecialization == 0  ? selected : empty) + ">Disabled (default)</option>\n";
+		html += "<option value='2'"  + (config.shaderSpecialization == 2  ? selected : empty) + ">2 variants</option>\n";
+		html += "<option value='4'"  + (config.shaderSpecialization == 4  ? selected : empty) + ">4 variants</option>\n";
+		html += "<option value='8'"  + (config.shaderSpecialization == 8  ? selected : empty) + ">8 variants</option>\n";
+		html += "<option value='16'" + (config.shaderSpecialization == 16 ? selected : empty) + ">16 variants</option>\n";
+		html += "</select></td></tr>\n";
 		html += "</table>\n";
 		html += "<h2><em>Testing & Experimental</em></h2>\n";
 		html += "<table>\n";
@@ -439,6 +487,12 @@ namespace sw
 		html += "</select></td>\n";
 		html += "<tr><td>Force clearing registers that have no default value:</td><td><input name = 'forceClearRegisters' type='checkbox'" + (config.forceClearRegisters == true ? checked : empty) + " title='Initializes shader register values to 0 even if they have no default.'></td></tr>";
 		html += "</table>\n";
+		html += "<h2><em>Profiling</em></h2>\n";
+		html += "<table>\n";
+		html += "<tr><td>Profile pipeline stages:</td><td><input name = 'profiling' type='checkbox'" + (config.profiling == true ? checked : empty) + " title='Generates instrumented routines which measure the time spent in the pixel pipeline and count the operations of each stage, displayed on the profile page.'></td></tr>";
+		html += "<tr><td>Heads-up display:</td><td><input name = 'perfHUD' type='checkbox'" + (config.perfHUD == true ? checked : empty) + " title='Displays the time spent on vertex, setup and pixel processing for each thread (Direct3D 9 only).'></td></tr>";
+		html += "<tr><td>Record timeline trace:</td><td><input name = 'tracing' type='checkbox'" + (config.tracing == true ? checked : empty) + " title='Records draws, tasks, routine compilations, blits and swaps of each thread, for viewing in Perfetto or chrome://tracing.'> <a href='/swiftshader/trace'>Download</a></td></tr>";
+		html += "</table>\n";
 	#ifndef NDEBUG
 		html += "<h2><em>Debugging</em></h2>\n";
 		html += "<table>\n";
@@ -465,8 +519,37 @@ namespace sw
 
 		html += "<p>FPS: " + ftoa(profiler.FPS) + "</p>\n";
 		html += "<p>Frame: " + itoa(profiler.framesTotal) + "</p>\n";
+		html += "<p>Code memory (KB): " + itoa((int)(profiler.codeMemoryUsed / 1024)) + " used by " + itoa(profiler.routineCount) + " routines, " + itoa((int)(profiler.codeMemoryReserved / 1024)) + " reserved</p>\n";
+		html += "<p>Specialized draws: " + itoa((int)profiler.specializedDraws) + " of " + itoa((int)profiler.specializableDraws) + (profiler.specializableDraws ? " (" + itoa((int)(100 * profiler.specializedDraws / profiler.specializableDraws)) + "%)" : "") + "</p>\n";
+
+		if(profiler.enabled)
+		{
+			static const char *const counterNames[PERF_COUNTERS] =
+			{
+				"Vertices shaded",
+				"Primitives set up",
+				"Primitives culled",
+				"Primitives clipped",
+				"Quads rasterized",
+				"Texture operations",
+				"Compressed texture operations",
+				"Raster operations",
+			};
+
+			html += "<table><tr><td></td><td>Current frame</td><td>Average</td></tr>\n";
+
+			for(int i = 0; i < PERF_COUNTERS; i++)
+			{
+				double average = (double)profiler.countersTotal[i] / std::max(profiler.framesTotal, 1);
+
+				html += "<tr><td>" + std::string(counterNames[i]) + " (thousand):</td><td>" + ftoa(profiler.countersFrame[i] / 1.0e3) + "</td><td>" + ftoa(average / 1.0e3) + "</td></tr>\n";
+			}
+
+			html += "</table>\n";
+		}
 
-		#if PERF_PROFILE
+		if(profiler.enabled && profiler.cycles[PERF_PIXEL] > 0)
+		{
 			int texTime = (int)(1000 * profiler.cycles[PERF_TEX] / profiler.cycles[PERF_PIXEL] + 0.5);
 			int shaderTime = (int)(1000 * profiler.cycles[PERF_SHADER] / profiler.cycles[PERF_PIXEL] + 0.5);
 			int pipeTime = (int)(1000 * profiler.cycles[PERF_PIPE] / profiler.cycles[PERF_PIXEL] + 0.5);
@@ -484,13 +567,6 @@ namespace sw
 			double interpTimeF = (double)interpTime / 10;
 			double rastTimeF = (double)rastTime / 10;
 
-			double averageRopOperations = profiler.ropOperationsTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
-			double averageCompressedTex = profiler.compressedTexTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
-			double averageTexOperations = profiler.texOperationsTotal / std::max(profiler.framesTotal, 1) / 1.0e6f;
-
-			html += "<p>Raster operations (million): " + ftoa(profiler.ropOperationsFrame / 1.0e6f) + " (current), " + ftoa(averageRopOperations) + " (average)</p>\n";
-			html += "<p>Texture operations (million): " + ftoa(profiler.texOperationsFrame / 1.0e6f) + " (current), " + ftoa(averageTexOperations) + " (average)</p>\n";
-			html += "<p>Compressed texture operations (million): " + ftoa(profiler.compressedTexFrame / 1.0e6f) + " (current), " + ftoa(averageCompressedTex) + " (average)</p>\n";
 			html += "<div id='profile' style='position:relative; width:1010px; height:50px; background-color:silver;'>";
 			html += "<div style='position:relative; width:1000px; height:40px; background-color:white; left:5px; top:5px;'>";
 			html += "<div style='position:relative; float:left; width:" + itoa(rastTime)   + "px; height:40px; border-style:none; text-align:center; line-height:40px; background-color:#FFFF7F; overflow:hidden;'>" + ftoa(rastTimeF)   + "% rast</div>\n";
@@ -505,12 +581,148 @@ namespace sw
 			{
 				profiler.cycles[i] = 0;
 			}
-		#endif
+		}
 
 		return html;
 	}
 
-	void SwiftConfig::send(Socket *clientSocket, Status code, std::string body)
+	namespace
+	{
+		const char *const routineTypeNames[ROUTINE_TYPES] = {"vertex", "setup", "pixel", "blit"};
+
+		double toSeconds(int64_t time)
+		{
+			return (double)time / Timer::frequency();
+		}
+
+		void addMetric(std::string &text, const char *name, const char *type, const char *help)
+		{
+			text += std::string("# HELP ") + name + " " + help + "\n";
+			text += std::string("# TYPE ") + name + " " + type + "\n";
+		}
+	}
+
+	std::string SwiftConfig::metrics()
+	{
+		std::string text;
+		ExecutableMemoryStatistics codeMemory = getExecutableMemoryStatistics();
+		int workers = std::min(threadCount, 16);
+
+		addMetric(text, "swiftshader_fps", "gauge", "Frames presented per second.");
+		text += "swiftshader_fps " + ftoa(profiler.FPS) + "\n";
+
+		addMetric(text, "swiftshader_frames_total", "counter", "Frames presented.");
+		text += "swiftshader_frames_total " + itoa(profiler.framesTotal + profiler.framesSec) + "\n";
+
+		addMetric(text, "swiftshader_thread_busy_seconds_total", "counter", "Time spent executing rendering tasks, per worker thread.");
+		for(int i = 0; i < workers; i++)
+		{
+			text += "swiftshader_thread_busy_seconds_total{thread=\"" + itoa(i) + "\"} " + ftoa(toSeconds(profiler.threadBusy[i])) + "\n";
+		}
+
+		addMetric(text, "swiftshader_routine_cache_hits_total", "counter", "Routine cache lookups which found a routine.");
+		for(int type = 0; type < ROUTINE_TYPES; type++)
+		{
+			text += std::string("swiftshader_routine_cache_hits_total{type=\"") + routineTypeNames[type] + "\"} " + ltoa(profiler.routineHits[type]) + "\n";
+		}
+
+		addMetric(text, "swiftshader_routine_cache_misses_total", "counter", "Routine cache lookups which compiled a routine.");
+		for(int type = 0; type < ROUTINE_TYPES; type++)
+		{
+			text += std::string("swiftshader_routine_cache_misses_total{type=\"") + routineTypeNames[type] + "\"} " + ltoa(profiler.routineMisses[type]) + "\n";
+		}
+
+		addMetric(text, "swiftshader_routine_compile_seconds", "histogram", "Time spent compiling routines.");
+		for(int type = 0; type < ROUTINE_TYPES; type++)
+		{
+			std::string labels = std::string("type=\"") + routineTypeNames[type] + "\"";
+			int64_t count = 0;
+
+			for(int bucket = 0; bucket < COMPILE_BUCKETS; bucket++)
+			{
+				count += profiler.compileHistogram[type][bucket];
+				std::string bound = (bucket < COMPILE_BUCKETS - 1) ? ftoa((1 << bucket) / 1000.0) : "+Inf";
+
+				text += "swiftshader_routine_compile_seconds_bucket{" + labels + ",le=\"" + bound + "\"} " + ltoa(count) + "\n";
+			}
+
+			text += "swiftshader_routine_compile_seconds_sum{" + labels + "} " + ftoa(toSeconds(profiler.compileTime[type])) + "\n";
+			text += "swiftshader_routine_compile_seconds_count{" + labels + "} " + ltoa(count) + "\n";
+		}
+
+		addMetric(text, "swiftshader_code_memory_bytes", "gauge", "Executable memory used by routines, and reserved from the system.");
+		text += "swiftshader_code_memory_bytes{state=\"used\"} " + ltoa(codeMemory.used) + "\n";
+		text += "swiftshader_code_memory_bytes{state=\"reserved\"} " + ltoa(codeMemory.reserved) + "\n";
+
+		addMetric(text, "swiftshader_routines", "gauge", "Routines in executable memory.");
+		text += "swiftshader_routines " + itoa(codeMemory.allocations) + "\n";
+
+		addMetric(text, "swiftshader_surface_memory_bytes", "gauge", "Memory allocated for textures, render targets and other surfaces.");
+		text += "swiftshader_surface_memory_bytes " + ltoa(profiler.surfaceMemory) + "\n";
+
+		addMetric(text, "swiftshader_draws_queued", "gauge", "Draws submitted to the renderer which haven't completed.");
+		text += "swiftshader_draws_queued " + itoa(profiler.drawsQueued) + "\n";
+
+		addMetric(text, "swiftshader_blits_total", "counter", "Surface blits.");
+		text += "swiftshader_blits_total " + ltoa(profiler.blits) + "\n";
+
+		addMetric(text, "swiftshader_blit_seconds_total", "counter", "Time spent blitting surfaces.");
+		text += "swiftshader_blit_seconds_total " + ftoa(toSeconds(profiler.blitTime)) + "\n";
+
+		addMetric(text, "swiftshader_resolves_total", "counter", "Multisample resolves.");
+		text += "swiftshader_resolves_total " + ltoa(profiler.resolves) + "\n";
+
+		addMetric(text, "swiftshader_resolve_seconds_total", "counter", "Time spent resolving multisampled surfaces.");
+		text += "swiftshader_resolve_seconds_total " + ftoa(toSeconds(profiler.resolveTime)) + "\n";
+
+		return text;
+	}
+
+	std::string SwiftConfig::metricsJSON()
+	{
+		std::string json;
+		ExecutableMemoryStatistics codeMemory = getExecutableMemoryStatistics();
+		int workers = std::min(threadCount, 16);
+
+		json += "{\"fps\":" + ftoa(profiler.FPS);
+		json += ",\"frames\":" + itoa(profiler.framesTotal + profiler.framesSec);
+
+		json += ",\"threadBusySeconds\":[";
+		for(int i = 0; i < workers; i++)
+		{
+			json += (i ? "," : "") + ftoa(toSeconds(profiler.threadBusy[i]));
+		}
+		json += "]";
+
+		json += ",\"routines\":{";
+		for(int type = 0; type < ROUTINE_TYPES; type++)
+		{
+			json += std::string(type ? "," : "") + "\"" + routineTypeNames[type] + "\":{";
+			json += "\"hits\":" + ltoa(profiler.routineHits[type]);
+			json += ",\"misses\":" + ltoa(profiler.routineMisses[type]);
+			json += ",\"compileSeconds\":" + ftoa(toSeconds(profiler.compileTime[type]));
+			json += ",\"compileHistogram\":[";   // Not cumulative, with upper bounds of 1, 2, 4, ... ms and the rest
+
+			for(int bucket = 0; bucket < COMPILE_BUCKETS; bucket++)
+			{
+				json += (bucket ? "," : "") + ltoa(profiler.compileHistogram[type][bucket]);
+			}
+
+			json += "]}";
+		}
+		json += "}";
+
+		json += ",\"codeMemory\":{\"used\":" + ltoa(codeMemory.used) + ",\"reserved\":" + ltoa(codeMemory.reserved) + ",\"budget\":" + ltoa(codeMemory.budget) + ",\"routines\":" + itoa(codeMemory.allocations) + "}";
+		json += ",\"surfaceMemory\":" + ltoa(profiler.surfaceMemory);
+		json += ",\"drawsQueued\":" + itoa(profiler.drawsQueued);
+		json += ",\"blits\":{\"count\":" + ltoa(profiler.blits) + ",\"seconds\":" + ftoa(toSeconds(profiler.blitTime)) + "}";
+		json += ",\"resolves\":{\"count\":" + ltoa(profiler.resolves) + ",\"seconds\":" + ftoa(toSeconds(profiler.resolveTime)) + "}";
+		json += "}\n";
+
+		return json;
+	}
+
+	void SwiftConfig::send(Socket *clientSocket, Status code, std::string body, const char *contentType)
 	{
 		std::string status;
 		char header[1024];
@@ -521,10 +733,10 @@ namespace sw
 		case NotFound: status += "HTTP/1.1 404 Not Found\r\n"; break;
 		}
 
-		sprintf(header, "Content-Type: text/html; charset=UTF-8\r\n"
+		sprintf(header, "Content-Type: %s; charset=UTF-8\r\n"
 						"Content-Length: %zd\r\n"
 						"Host: localhost\r\n"
-						"\r\n", body.size());
+						"\r\n", contentType, body.size());
 
 		std::string message = status + header + body;
 		clientSocket->send(message.c_str(), (int)message.length());
@@ -547,6 +759,9 @@ namespace sw
 		config.disable10BitMode = false;
 		config.precache = false;
 		config.forceClearRegisters = false;
+		config.profiling = false;
+		config.perfHUD = false;
+		config.tracing = false;
 
 		while(*post != 0)
 		{
@@ -585,6 +800,14 @@ namespace sw
 			{
 				config.vertexCacheSize = integer;
 			}
+			else if(sscanf(post, "codeMemoryBudget=%d", &integer))
+			{
+				config.codeMemoryBudget = integer;
+			}
+			else if(sscanf(post, "drawQueueMemory=%d", &integer))
+			{
+				config.drawQueueMemory = integer;
+			}
 			else if(sscanf(post, "textureSampleQuality=%d", &integer))
 			{
 				config.textureSampleQuality = integer;
@@ -653,6 +876,10 @@ namespace sw
 			{
 				config.optimization[index - 1] = (Optimization)integer;
 			}
+			else if(sscanf(post, "shaderSpecialization=%d", &integer))
+			{
+				config.shaderSpecialization = integer;
+			}
 			else if(strstr(post, "disableServer=on"))
 			{
 				config.disableServer = true;
@@ -689,6 +916,18 @@ namespace sw
 			{
 				config.forceClearRegisters = true;
 			}
+			else if(strstr(post, "profiling=on"))
+			{
+				config.profiling = true;
+			}
+			else if(strstr(post, "perfHUD=on"))
+			{
+				config.perfHUD = true;
+			}
+			else if(strstr(post, "tracing=on"))
+			{
+				config.tracing = true;
+			}
 		#ifndef NDEBUG
 			else if(sscanf(post, "minPrimitives=%d", &integer))
 			{
@@ -724,6 +963,8 @@ namespace sw
 		config.pixelRoutineCacheSize = ini.getInteger("Caches", "PixelRoutineCacheSize", 1024);
 		config.setupRoutineCacheSize = ini.getInteger("Caches", "SetupRoutineCacheSize", 1024);
 		config.vertexCacheSize = ini.getInteger("Caches", "VertexCacheSize", 64);
+		config.codeMemoryBudget = ini.getInteger("Caches", "CodeMemoryBudget", 128);
+		config.drawQueueMemory = ini.getInteger("Caches", "DrawQueueMemory", 32);
 		config.textureSampleQuality = ini.getInteger("Quality", "TextureSampleQuality", 2);
 		config.mipmapQuality = ini.getInteger("Quality", "MipmapQuality", 1);
 		config.perspectiveCorrection = ini.getBoolean("Quality", "PerspectiveCorrection", true);
@@ -741,7 +982,10 @@ namespace sw
 			config.optimization[pass] = (Optimization)ini.getInteger("Optimization", "OptimizationPass" + itoa(pass + 1), pass == 0 ? InstructionCombining : Disabled);
 		}
 
+		config.shaderSpecialization = ini.getInteger("Optimization", "ShaderSpecialization", 0);
+
 		config.disableServer = ini.getBoolean("Testing", "DisableServer", false);
+		config.serverPort = ini.getInteger("Testing", "ServerPort", 8080);
 		config.forceWindowed = ini.getBoolean("Testing", "ForceWindowed", false);
 		config.complementaryDepthBuffer = ini.getBoolean("Testing", "ComplementaryDepthBuffer", false);
 		config.postBlendSRGB = ini.getBoolean("Testing", "PostBlendSRGB", false);
@@ -752,6 +996,16 @@ namespace sw
 		config.precache = ini.getBoolean("Testing", "Precache", false);
 		config.shadowMapping = ini.getInteger("Testing", "ShadowMapping", 3);
 		config.forceClearRegisters = ini.getBoolean("Testing", "ForceClearRegisters", false);
+		config.profiling = ini.getBoolean("Profiling", "Enable", false) || getenv("SWIFTSHADER_PROFILE");
+		config.perfHUD = ini.getBoolean("Profiling", "HUD", false);
+		config.tracing = ini.getBoolean("Profiling", "Trace", false);
+		config.traceFile = ini.getValue("Profiling", "TraceFile", "SwiftShader.json");
+
+		if(getenv("SWIFTSHADER_TRACE"))
+		{
+			config.tracing = true;
+			config.traceFile = getenv("SWIFTSHADER_TRACE");
+		}
 
 	#ifndef NDEBUG
 		config.minPrimitives = 1;
@@ -764,7 +1018,12 @@ namespace sw
 		bool noConfig = stat("SwiftShader.ini", &status) != 0;
 		newConfig = !noConfig && abs((int)status.st_mtime - lastModified) > 1;
 
-		if(disableServerOverride)
+		if(getenv("SWIFTSHADER_SERVER_PORT"))   // Serves the metrics even where the server is disabled by default
+		{
+			config.serverPort = atoi(getenv("SWIFTSHADER_SERVER_PORT"));
+			config.disableServer = false;
+		}
+		else if(disableServerOverride)
 		{
 			config.disableServer = true;
 		}
@@ -782,6 +1041,8 @@ namespace sw
 		ini.addValue("Caches", "PixelRoutineCacheSize", itoa(config.pixelRoutineCacheSize));
 		ini.addValue("Caches", "SetupRoutineCacheSize", itoa(config.setupRoutineCacheSize));
 		ini.addValue("Caches", "VertexCacheSize", itoa(config.vertexCacheSize));
+		ini.addValue("Caches", "CodeMemoryBudget", itoa(config.codeMemoryBudget));
+		ini.addValue("Caches", "DrawQueueMemory", itoa(config.drawQueueMemory));
 		ini.addValue("Quality", "TextureSampleQuality", itoa(config.textureSampleQuality));
 		ini.addValue("Quality", "MipmapQuality", itoa(config.mipmapQuality));
 		ini.addValue("Quality", "PerspectiveCorrection", itoa(config.perspectiveCorrection));
@@ -799,7 +1060,10 @@ namespace sw
 			ini.addValue("Optimization", "OptimizationPass" + itoa(pass + 1), itoa(config.optimization[pass]));
 		}
 
+		ini.addValue("Optimization", "ShaderSpecialization", itoa(config.shaderSpecialization));
+
 		ini.addValue("Testing", "DisableServer", itoa(config.disableServer));
+		ini.addValue("Testing", "ServerPort", itoa(config.serverPort));
 		ini.addValue("Testing", "ForceWindowed", itoa(config.forceWindowed));
 		ini.addValue("Testing", "ComplementaryDepthBuffer", itoa(config.complementaryDepthBuffer));
 		ini.addValue("Testing", "PostBlendSRGB", itoa(config.postBlendSRGB));
@@ -810,6 +1074,10 @@ namespace sw
 		ini.addValue("Testing", "Precache", itoa(config.precache));
 		ini.addValue("Testing", "ShadowMapping", itoa(config.shadowMapping));
 		ini.addValue("Testing", "ForceClearRegisters", itoa(config.forceClearRegisters));
+		ini.addValue("Profiling", "Enable", itoa(config.profiling));
+		ini.addValue("Profiling", "HUD", itoa(config.perfHUD));
+		ini.addValue("Profiling", "Trace", itoa(config.tracing));
+		ini.addValue("Profiling", "TraceFile", config.traceFile);
 		ini.addValue("LastModified", "Time", itoa((int)time(0)));
 
 		ini.writeFile("SwiftShader Configuration File\n"
@@ -38,6 +38,8 @@ namespace sw
 			int pixelRoutineCacheSize;
 			int setupRoutineCacheSize;
 			int vertexCacheSize;
+			int codeMemoryBudget;   // In megabytes, 0 is unlimited
+			int drawQueueMemory;    // In megabytes, for draw calls buffered ahead of the renderer
 			int textureSampleQuality;
 			int mipmapQuality;
 			bool perspectiveCorrection;
@@ -49,7 +51,9 @@ namespace sw
 			bool enableSSSE3;
 			bool enableSSE4_1;
 			Optimization optimization[10];
+			int shaderSpecialization;   // Routine variants per shader, 0 is disabled
 			bool disableServer;
+			int serverPort;
 			bool keepSystemCursor;
 			bool forceWindowed;
 			bool complementaryDepthBuffer;
@@ -62,6 +66,10 @@ namespace sw
 			bool precache;
 			int shadowMapping;
 			bool forceClearRegisters;
+			bool profiling;   // Instruments routines and counts pipeline operations
+			bool perfHUD;
+			bool tracing;   // Records a timeline of the renderer's tasks
+			std::string traceFile;   // Written at exit
 		#ifndef NDEBUG
 			unsigned int minPrimitives;
 			unsigned int maxPrimitives;
@@ -91,7 +99,9 @@ namespace sw
 		void respond(Socket *clientSocket, const char *request);
 		std::string page();
 		std::string profile();
-		void send(Socket *clientSocket, Status code, std::string body = "");
+		std::string metrics();       // Prometheus text format
+		std::string metricsJSON();
+		void send(Socket *clientSocket, Status code, std::string body = "", const char *contentType = "text/html");
 		void parsePost(const char *post);
 
 		void readConfiguration(bool disableServerOverride = false);
@@ -15,6 +15,7 @@
 #include "Image.hpp"
 
 #include "Renderer/Blitter.hpp"
+#include "Main/FrameBuffer.hpp"
 #include "../libEGL/Texture.hpp"
 #include "../common/debug.h"
 #include "Common/Math.hpp"
@@ -1189,6 +1190,8 @@ namespace egl
 			: Image(width, height, format, type, pitchP) {}
 		ImageImplementation(GLsizei width, GLsizei height, sw::Format internalFormat, int multiSampleDepth, bool lockable)
 			: Image(width, height, internalFormat, multiSampleDepth, lockable) {}
+		ImageImplementation(GLsizei width, GLsizei height, sw::Format internalFormat, sw::SharedBackBuffer *sharedBuffer)
+			: Image(width, height, internalFormat, sharedBuffer) {}
 
 		~ImageImplementation() override
 		{
@@ -1231,6 +1234,21 @@ namespace egl
 		return new ImageImplementation(width, height, internalFormat, multiSampleDepth, lockable);
 	}
 
+	Image *Image::create(GLsizei width, GLsizei height, sw::Format internalFormat, sw::SharedBackBuffer *sharedBuffer)
+	{
+		return new ImageImplementation(width, height, internalFormat, sharedBuffer);
+	}
+
+	Image::Image(GLsizei width, GLsizei height, sw::Format internalFormat, sw::SharedBackBuffer *sharedBuffer)
+		: sw::Surface(nullptr, width, height, 1, internalFormat, false, true),
+		  width(width), height(height), format(0 /*GL_NONE*/), type(0 /*GL_NONE*/), internalFormat(internalFormat), depth(1),
+		  parentTexture(nullptr), sharedBuffer(sharedBuffer)
+	{
+		shared = false;
+		Object::addRef();
+		setClientBuffer(sharedBuffer->getPixels(), sharedBuffer->getPitchB());
+	}
+
 	Image::~Image()
 	{
 		// sync() must be called in the destructor of the most derived class to ensure their vtable isn't destroyed
@@ -1242,6 +1260,8 @@ namespace egl
 			parentTexture->release();
 		}
 
+		delete sharedBuffer;   // Rendering has been synchronized by the most derived class
+
 		ASSERT(!shared);
 	}
 
@@ -37,6 +37,11 @@
 #define SW_YV12_BT709 0x48315659   // YCrCb 4:2:0 Planar, 16-byte aligned, BT.709 color space, studio swing
 #define SW_YV12_JFIF  0x4A315659   // YCrCb 4:2:0 Planar, 16-byte aligned, BT.601 color space, full swing
 
+namespace sw
+{
+class SharedBackBuffer;
+}
+
 namespace egl
 {
 
@@ -53,7 +58,7 @@ protected:
 	Image(Texture *parentTexture, GLsizei width, GLsizei height, GLenum format, GLenum type)
 		: sw::Surface(parentTexture->getResource(), width, height, 1, SelectInternalFormat(format, type), true, true),
 		  width(width), height(height), format(format), type(type), internalFormat(SelectInternalFormat(format, type)), depth(1),
-		  parentTexture(parentTexture)
+		  parentTexture(parentTexture), sharedBuffer(nullptr)
 	{
 		shared = false;
 		Object::addRef();
@@ -64,7 +69,7 @@ protected:
 	Image(Texture *parentTexture, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type)
 		: sw::Surface(parentTexture->getResource(), width, height, depth, SelectInternalFormat(format, type), true, true),
 		  width(width), height(height), format(format), type(type), internalFormat(SelectInternalFormat(format, type)), depth(depth),
-		  parentTexture(parentTexture)
+		  parentTexture(parentTexture), sharedBuffer(nullptr)
 	{
 		shared = false;
 		Object::addRef();
@@ -75,7 +80,7 @@ protected:
 	Image(GLsizei width, GLsizei height, GLenum format, GLenum type, int pitchP)
 		: sw::Surface(nullptr, width, height, 1, SelectInternalFormat(format, type), true, true, pitchP),
 		  width(width), height(height), format(format), type(type), internalFormat(SelectInternalFormat(format, type)), depth(1),
-		  parentTexture(nullptr)
+		  parentTexture(nullptr), sharedBuffer(nullptr)
 	{
 		shared = true;
 		Object::addRef();
@@ -85,12 +90,15 @@ protected:
 	Image(GLsizei width, GLsizei height, sw::Format internalFormat, int multiSampleDepth, bool lockable)
 		: sw::Surface(nullptr, width, height, multiSampleDepth, internalFormat, lockable, true),
 		  width(width), height(height), format(0 /*GL_NONE*/), type(0 /*GL_NONE*/), internalFormat(internalFormat), depth(multiSampleDepth),
-		  parentTexture(nullptr)
+		  parentTexture(nullptr), sharedBuffer(nullptr)
 	{
 		shared = false;
 		Object::addRef();
 	}
 
+	// Render target in memory shared with the frame buffer
+	Image(GLsizei width, GLsizei height, sw::Format internalFormat, sw::SharedBackBuffer *sharedBuffer);
+
 public:
 	// 2D texture image
 	static Image *create(Texture *parentTexture, GLsizei width, GLsizei height, GLenum format, GLenum type);
@@ -104,6 +112,9 @@ public:
 	// Render target
 	static Image *create(GLsizei width, GLsizei height, sw::Format internalFormat, int multiSampleDepth, bool lockable);
 
+	// Render target in memory shared with the frame buffer, which the image takes ownership of
+	static Image *create(GLsizei width, GLsizei height, sw::Format internalFormat, sw::SharedBackBuffer *sharedBuffer);
+
 	GLsizei getWidth() const
 	{
 		return width;
@@ -201,6 +212,7 @@ protected:
 	bool shared;   // Used as an EGLImage
 
 	egl::Texture *parentTexture;
+	sw::SharedBackBuffer *sharedBuffer;
 
 	~Image() override = 0;
 
@@ -21,6 +21,10 @@
 #include "ParseHelper.h"
 #include "ValidateLimitations.h"
 
+#include <mutex>
+#include <vector>
+#include <string.h>
+
 namespace
 {
 class TScopedPoolAllocator {
@@ -43,6 +47,97 @@ private:
 };
 }  // namespace
 
+//
+// The built-in levels of a symbol table, allocated from their own pool. Once
+// constructed they're only read, by any number of compilers and threads.
+//
+struct TBuiltInSymbolTable
+{
+	TBuiltInSymbolTable(GLenum shaderType, const ShBuiltInResources &resources);
+	~TBuiltInSymbolTable();
+
+	const GLenum shaderType;
+	const ShBuiltInResources resources;
+
+	TPoolAllocator allocator;
+	TSymbolTable symbolTable;
+};
+
+TBuiltInSymbolTable::TBuiltInSymbolTable(GLenum shaderType, const ShBuiltInResources &resources)
+	: shaderType(shaderType), resources(resources)
+{
+	TPoolAllocator *previousAllocator = GetGlobalPoolAllocator();
+	allocator.push();
+	SetGlobalPoolAllocator(&allocator);
+
+	symbolTable.push();   // COMMON_BUILTINS
+	symbolTable.push();   // ESSL1_BUILTINS
+	symbolTable.push();   // ESSL3_BUILTINS
+
+	TPublicType integer;
+	integer.type = EbtInt;
+	integer.primarySize = 1;
+	integer.secondarySize = 1;
+	integer.array = false;
+
+	TPublicType floatingPoint;
+	floatingPoint.type = EbtFloat;
+	floatingPoint.primarySize = 1;
+	floatingPoint.secondarySize = 1;
+	floatingPoint.array = false;
+
+	switch(shaderType)
+	{
+	case GL_FRAGMENT_SHADER:
+		symbolTable.setDefaultPrecision(integer, EbpMedium);
+		break;
+	case GL_VERTEX_SHADER:
+		symbolTable.setDefaultPrecision(integer, EbpHigh);
+		symbolTable.setDefaultPrecision(floatingPoint, EbpHigh);
+		break;
+	default: assert(false && "Language not supported");
+	}
+
+	InsertBuiltInFunctions(shaderType, resources, symbolTable);
+
+	IdentifyBuiltIns(shaderType, resources, symbolTable);
+
+	symbolTable.computeLazyProperties();
+
+	SetGlobalPoolAllocator(previousAllocator);
+}
+
+TBuiltInSymbolTable::~TBuiltInSymbolTable()
+{
+	allocator.popAll();
+}
+
+namespace
+{
+std::mutex builtInSymbolTablesMutex;
+std::vector<std::shared_ptr<TBuiltInSymbolTable>> builtInSymbolTables;   // Protected by the above
+
+std::shared_ptr<TBuiltInSymbolTable> GetBuiltInSymbolTable(GLenum shaderType, const ShBuiltInResources &resources)
+{
+	std::lock_guard<std::mutex> lock(builtInSymbolTablesMutex);
+
+	for(size_t i = 0; i < builtInSymbolTables.size(); i++)
+	{
+		// The resources only consist of integers, which are all initialized
+		if(builtInSymbolTables[i]->shaderType == shaderType &&
+		   memcmp(&builtInSymbolTables[i]->resources, &resources, sizeof(ShBuiltInResources)) == 0)
+		{
+			return builtInSymbolTables[i];
+		}
+	}
+
+	std::shared_ptr<TBuiltInSymbolTable> builtIns = std::make_shared<TBuiltInSymbolTable>(shaderType, resources);
+	builtInSymbolTables.push_back(builtIns);
+
+	return builtIns;
+}
+}  // namespace
+
 //
 // Initialize built-in resources with minimum expected values.
 //
@@ -66,6 +161,7 @@ ShBuiltInResources::ShBuiltInResources()
 	OES_standard_derivatives = 0;
 	OES_fragment_precision_high = 0;
 	OES_EGL_image_external = 0;
+	EXT_draw_buffers = 0;
 
 	MaxCallStackDepth = UINT_MAX;
 }
@@ -164,37 +260,9 @@ bool TCompiler::compile(const char* const shaderStrings[],
 bool TCompiler::InitBuiltInSymbolTable(const ShBuiltInResources &resources)
 {
 	assert(symbolTable.isEmpty());
-	symbolTable.push();   // COMMON_BUILTINS
-	symbolTable.push();   // ESSL1_BUILTINS
-	symbolTable.push();   // ESSL3_BUILTINS
-
-	TPublicType integer;
-	integer.type = EbtInt;
-	integer.primarySize = 1;
-	integer.secondarySize = 1;
-	integer.array = false;
 
-	TPublicType floatingPoint;
-	floatingPoint.type = EbtFloat;
-	floatingPoint.primarySize = 1;
-	floatingPoint.secondarySize = 1;
-	floatingPoint.array = false;
-
-	switch(shaderType)
-	{
-	case GL_FRAGMENT_SHADER:
-		symbolTable.setDefaultPrecision(integer, EbpMedium);
-		break;
-	case GL_VERTEX_SHADER:
-		symbolTable.setDefaultPrecision(integer, EbpHigh);
-		symbolTable.setDefaultPrecision(floatingPoint, EbpHigh);
-		break;
-	default: assert(false && "Language not supported");
-	}
-
-	InsertBuiltInFunctions(shaderType, resources, symbolTable);
-
-	IdentifyBuiltIns(shaderType, resources, symbolTable);
+	builtInSymbolTable = GetBuiltInSymbolTable(shaderType, resources);
+	symbolTable.shareBuiltIns(builtInSymbolTable->symbolTable);
 
 	return true;
 }
@@ -264,6 +332,12 @@ bool InitCompilerGlobals()
 
 void FreeCompilerGlobals()
 {
+	{
+		// Compilers which are still alive keep using theirs
+		std::lock_guard<std::mutex> lock(builtInSymbolTablesMutex);
+		builtInSymbolTables.clear();
+	}
+
 	FreeParseContextIndex();
 	FreePoolIndex();
 }
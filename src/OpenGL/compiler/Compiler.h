@@ -19,6 +19,8 @@
 #include "InfoSink.h"
 #include "SymbolTable.h"
 
+#include <memory>
+
 enum ShCompileOptions
 {
   SH_VALIDATE                = 0,
@@ -66,6 +68,8 @@ typedef unsigned int GLenum;
 #define GL_FRAGMENT_SHADER                0x8B30
 #define GL_VERTEX_SHADER                  0x8B31
 
+struct TBuiltInSymbolTable;
+
 //
 // The base class for the machine dependent compiler to derive from
 // for managing object code from the compile.
@@ -108,7 +112,9 @@ private:
 	unsigned int maxCallStackDepth;
 
 	// Built-in symbol table for the given language, spec, and resources.
-	// It is preserved from compile-to-compile.
+	// Its built-in levels are shared with all compilers using the same ones,
+	// and only user-defined levels are pushed for each compile.
+	std::shared_ptr<TBuiltInSymbolTable> builtInSymbolTable;
 	TSymbolTable symbolTable;
 	// Built-in extensions with default behavior.
 	TExtensionBehavior extensionBehavior;
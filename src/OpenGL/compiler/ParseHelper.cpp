@@ -16,6 +16,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <limits>
 
 #include "glslang.h"
 #include "preprocessor/SourceLocation.h"
@@ -18,12 +18,30 @@
 #include <stdint.h>
 #endif
 #include <stdio.h>
+#include <mutex>
 
 #include "InitializeGlobals.h"
 #include "osinclude.h"
 
 OS_TLSIndex PoolIndex = OS_INVALID_TLS_INDEX;
 
+namespace
+{
+	// Single pages released by pool allocators, for reuse by the next ones.
+	// Never destroyed, since pool allocators may be destroyed during static destruction.
+	struct TPageCache
+	{
+		std::mutex mutex;
+		void* pages = nullptr;   // Linked through their first word
+		size_t count = 0;
+		size_t limit = 1024 * 1024;   // In bytes
+	};
+
+	TPageCache &pageCache = *new TPageCache();
+
+	const size_t cachedPageSize = 8 * 1024;   // The default growth increment
+}
+
 bool InitializePoolIndex()
 {
 	assert(PoolIndex == OS_INVALID_TLS_INDEX);
@@ -60,9 +78,11 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
 	pageSize(growthIncrement),
 	alignment(allocationAlignment),
 	freeList(0),
-	inUseList(0),
-	numCalls(0),
+	inUseList(0)
+#ifdef GUARD_BLOCKS
+	, numCalls(0),
 	totalBytes(0)
+#endif
 {
 	//
 	// Don't allow page sizes we know are smaller than all common
@@ -105,7 +125,12 @@ TPoolAllocator::~TPoolAllocator()
 	while (inUseList) {
 		tHeader* next = inUseList->nextPage;
 		inUseList->~tHeader();
-		delete [] reinterpret_cast<char*>(inUseList);
+		if (inUseList->pageCount > 1)
+			delete [] reinterpret_cast<char*>(inUseList);
+		else {
+			inUseList->nextPage = freeList;
+			freeList = inUseList;
+		}
 		inUseList = next;
 	}
 
@@ -113,10 +138,62 @@ TPoolAllocator::~TPoolAllocator()
 	// here, because we did it already when the block was
 	// placed into the free list.
 	//
-	while (freeList) {
-		tHeader* next = freeList->nextPage;
-		delete [] reinterpret_cast<char*>(freeList);
-		freeList = next;
+	releasePages(freeList);
+}
+
+void TPoolAllocator::setPageCacheLimit(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(pageCache.mutex);
+	pageCache.limit = bytes;
+
+	while (pageCache.count * cachedPageSize > pageCache.limit) {
+		void* page = pageCache.pages;
+		pageCache.pages = *reinterpret_cast<void**>(page);
+		pageCache.count--;
+		delete [] reinterpret_cast<char*>(page);
+	}
+}
+
+//
+// Get a single page from the cache, or from the OS.
+//
+TPoolAllocator::tHeader* TPoolAllocator::newPage()
+{
+	if (pageSize == cachedPageSize) {
+		std::lock_guard<std::mutex> lock(pageCache.mutex);
+
+		if (pageCache.pages) {
+			void* page = pageCache.pages;
+			pageCache.pages = *reinterpret_cast<void**>(page);
+			pageCache.count--;
+			return reinterpret_cast<tHeader*>(page);
+		}
+	}
+
+	return reinterpret_cast<tHeader*>(::new char[pageSize]);
+}
+
+//
+// Return a list of single pages to the cache, and the ones exceeding its limit to the OS.
+//
+void TPoolAllocator::releasePages(tHeader* pages)
+{
+	if (pages && pageSize == cachedPageSize) {
+		std::lock_guard<std::mutex> lock(pageCache.mutex);
+
+		while (pages && (pageCache.count + 1) * cachedPageSize <= pageCache.limit) {
+			tHeader* next = pages->nextPage;
+			*reinterpret_cast<void**>(pages) = pageCache.pages;
+			pageCache.pages = pages;
+			pageCache.count++;
+			pages = next;
+		}
+	}
+
+	while (pages) {
+		tHeader* next = pages->nextPage;
+		delete [] reinterpret_cast<char*>(pages);
+		pages = next;
 	}
 }
 
@@ -210,13 +287,15 @@ void TPoolAllocator::popAll()
 		pop();
 }
 
-void* TPoolAllocator::allocate(size_t numBytes)
+void* TPoolAllocator::allocateSlow(size_t numBytes)
 {
+#ifdef GUARD_BLOCKS
 	//
 	// Just keep some interesting statistics.
 	//
 	++numCalls;
 	totalBytes += numBytes;
+#endif
 
 	// If we are using guard blocks, all allocations are bracketed by
 	// them: [guardblock][allocation][guardblock].  numBytes is how
@@ -275,7 +354,7 @@ void* TPoolAllocator::allocate(size_t numBytes)
 		memory = freeList;
 		freeList = freeList->nextPage;
 	} else {
-		memory = reinterpret_cast<tHeader*>(::new char[pageSize]);
+		memory = newPage();
 		if (memory == 0)
 			return 0;
 	}
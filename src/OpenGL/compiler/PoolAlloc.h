@@ -121,6 +121,9 @@ private:
 // page size.  But, having it be about that size or equal to a set of
 // pages is likely most optimal.
 //
+// Single pages of destroyed pool allocators are kept in a process-wide
+// cache, up to a limit, so that compiles don't go back to the OS for them.
+//
 class TPoolAllocator {
 public:
 	TPoolAllocator(int growthIncrement = 8*1024, int allocationAlignment = 16);
@@ -151,7 +154,24 @@ public:
 	// Call allocate() to actually acquire memory.  Returns 0 if no memory
 	// available, otherwise a properly aligned pointer to 'numBytes' of memory.
 	//
-	void* allocate(size_t numBytes);
+	void* allocate(size_t numBytes) {
+#ifndef GUARD_BLOCKS
+		// Without guard blocks, allocations only bump the offset into the current page
+		if (numBytes <= pageSize - currentPageOffset) {
+			unsigned char* memory = reinterpret_cast<unsigned char*>(inUseList) + currentPageOffset;
+			currentPageOffset = (currentPageOffset + numBytes + alignmentMask) & ~alignmentMask;
+			return memory;
+		}
+#endif
+		return allocateSlow(numBytes);
+	}
+
+	//
+	// Call setPageCacheLimit() to change how many bytes of single pages are
+	// kept for reuse by other pool allocators.  Zero disables the cache.
+	// libGLESv2 sets it from [Caches] CompilerPageCacheSize in SwiftShader.ini.
+	//
+	static void setPageCacheLimit(size_t bytes);
 
 	//
 	// There is no deallocate.  The point of this class is that
@@ -202,6 +222,12 @@ protected:
 		return TAllocation::offsetAllocation(memory);
 	}
 
+	// Handles guard blocks, and allocations which don't fit in the current page
+	void* allocateSlow(size_t numBytes);
+
+	tHeader* newPage();
+	void releasePages(tHeader* pages);
+
 	size_t pageSize;        // granularity of allocation from the OS
 	size_t alignment;       // all returned allocations will be aligned at
 							// this granularity, which will be a power of 2
@@ -214,8 +240,10 @@ protected:
 	tHeader* inUseList;     // list of all memory currently being used
 	tAllocStack stack;      // stack of where to allocate from, to partition pool
 
+#ifdef GUARD_BLOCKS
 	int numCalls;           // just an interesting statistic
 	size_t totalBytes;      // just an interesting statistic
+#endif
 private:
 	TPoolAllocator& operator=(const TPoolAllocator&);  // dont allow assignment operator
 	TPoolAllocator(const TPoolAllocator&);  // dont allow default copy constructor
@@ -31,7 +31,7 @@
 #define snprintf _snprintf
 #endif
 
-int TSymbolTableLevel::uniqueId = 0;
+std::atomic<int> TSymbolTableLevel::uniqueId(0);
 
 TType::TType(const TPublicType &p) :
 	type(p.type), precision(p.precision), qualifier(p.qualifier), invariant(p.invariant), layoutQualifier(p.layoutQualifier),
@@ -195,6 +195,25 @@ TSymbolTableLevel::~TSymbolTableLevel()
 		delete (*it).second;
 }
 
+void TSymbolTableLevel::computeLazyProperties()
+{
+	for(tLevel::iterator it = level.begin(); it != level.end(); ++it)
+	{
+		if(it->second->isVariable())
+		{
+			TType &type = static_cast<TVariable*>(it->second)->getType();
+			type.getMangledName();
+			type.getObjectSize();
+
+			if(type.getStruct())
+			{
+				type.getStruct()->mangledName();
+				type.getStruct()->deepestNesting();
+			}
+		}
+	}
+}
+
 TSymbol *TSymbolTable::find(const TString &name, int shaderVersion, bool *builtIn, bool *sameScope) const
 {
 	int level = currentLevel();
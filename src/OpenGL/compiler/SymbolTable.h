@@ -47,6 +47,7 @@
 #include "InfoSink.h"
 #include "intermediate.h"
 #include <set>
+#include <atomic>
 
 //
 // Symbol base class.  (Can build functions or variables out of these...)
@@ -233,9 +234,13 @@ public:
 		return ++uniqueId;
 	}
 
+	// Computes the properties of the symbols' types which are otherwise computed
+	// on first use, so that the level can be read by compilers on other threads.
+	void computeLazyProperties();
+
 protected:
 	tLevel level;
-	static int uniqueId;     // for unique identification in code generation
+	static std::atomic<int> uniqueId;     // for unique identification in code generation
 };
 
 enum ESymbolLevel
@@ -315,7 +320,7 @@ class TSymbolTable
 {
 public:
 	TSymbolTable()
-		: mGlobalInvariant(false)
+		: mBuiltIns(nullptr), mGlobalInvariant(false)
 	{
 		//
 		// The symbol table cannot be used until push() is called, but
@@ -333,6 +338,24 @@ public:
 	}
 
 	bool isEmpty() { return table.empty(); }
+
+	// Uses the built-in levels of a table which is no longer modified, and has to
+	// outlive this one, instead of creating them.
+	void shareBuiltIns(const TSymbolTable &builtIns)
+	{
+		assert(isEmpty() && builtIns.currentLevel() == LAST_BUILTIN_LEVEL);
+		table = builtIns.table;
+		precisionStack = builtIns.precisionStack;
+		mBuiltIns = &builtIns;
+	}
+
+	void computeLazyProperties()
+	{
+		for(size_t level = 0; level < table.size(); level++)
+		{
+			table[level]->computeLazyProperties();
+		}
+	}
 	bool atBuiltInLevel() { return currentLevel() <= LAST_BUILTIN_LEVEL; }
 	bool atGlobalLevel() { return currentLevel() <= GLOBAL_LEVEL; }
 	void push()
@@ -527,7 +550,11 @@ public:
 	void setGlobalInvariant() { mGlobalInvariant = true; }
 	bool getGlobalInvariant() const { return mGlobalInvariant; }
 
-	bool hasUnmangledBuiltIn(const char *name) { return mUnmangledBuiltinNames.count(std::string(name)) > 0; }
+	bool hasUnmangledBuiltIn(const char *name) const
+	{
+		const TSymbolTable *builtIns = mBuiltIns ? mBuiltIns : this;
+		return builtIns->mUnmangledBuiltinNames.count(std::string(name)) > 0;
+	}
 
 private:
 	// Used to insert unmangled functions to check redeclaration of built-ins in ESSL 3.00.
@@ -540,6 +567,7 @@ protected:
 	typedef std::map< TBasicType, TPrecision > PrecisionStackLevel;
 	std::vector< PrecisionStackLevel > precisionStack;
 
+	const TSymbolTable *mBuiltIns;   // Shared built-in levels, if not owned
 	std::set<std::string> mUnmangledBuiltinNames;
 
 	std::set<std::string> mInvariantVaryings;
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 #elif defined(__linux__)
 #include "Main/libX11.hpp"
+#include <EGL/eglext_swiftshader.h>
 #elif defined(__APPLE__)
 #include "OSXUtils.hpp"
 #endif
@@ -569,7 +570,28 @@ bool Display::isValidWindow(EGLNativeWindowType window)
 
 			return status == True;
 		}
-		return false;
+		else   // Headless
+		{
+			const EGLHeadlessWindowSW *headless = (const EGLHeadlessWindowSW*)window;
+
+			if(!headless || headless->magic != EGL_HEADLESS_WINDOW_MAGIC_SW || headless->width <= 0 || headless->height <= 0)
+			{
+				return false;
+			}
+
+			switch(headless->sink)
+			{
+			case EGL_HEADLESS_SINK_CALLBACK_SW:
+				return headless->callback != nullptr;
+			case EGL_HEADLESS_SINK_RING_SW:
+				return headless->path != nullptr && headless->bufferCount >= 2;
+			case EGL_HEADLESS_SINK_RAW_SW:
+			case EGL_HEADLESS_SINK_Y4M_SW:
+				return headless->path != nullptr;
+			default:
+				return false;
+			}
+		}
 	#elif defined(__APPLE__)
 		return sw::OSX::IsValidWindow(window);
 	#else
@@ -28,6 +28,7 @@
 
 #if defined(__linux__) && !defined(__ANDROID__)
 #include "Main/libX11.hpp"
+#include <EGL/eglext_swiftshader.h>
 #elif defined(_WIN32)
 #include <tchar.h>
 #elif defined(__APPLE__)
@@ -35,6 +36,7 @@
 #endif
 
 #include <algorithm>
+#include <vector>
 
 namespace egl
 {
@@ -66,13 +68,15 @@ bool Surface::initialize()
 {
 	ASSERT(!backBuffer && !depthStencil);
 
+	sw::SharedBackBuffer *sharedBuffer = createSharedBackBuffer();
+
 	if(libGLES_CM)
 	{
-		backBuffer = libGLES_CM->createBackBuffer(width, height, config);
+		backBuffer = libGLES_CM->createBackBuffer(width, height, config, sharedBuffer);
 	}
 	else if(libGLESv2)
 	{
-		backBuffer = libGLESv2->createBackBuffer(width, height, config);
+		backBuffer = libGLESv2->createBackBuffer(width, height, config, sharedBuffer);
 	}
 
 	if(!backBuffer)
@@ -145,6 +149,11 @@ egl::Image *Surface::getDepthStencil()
 	return depthStencil;
 }
 
+void Surface::swapWithDamage(const EGLint *rects, EGLint count)
+{
+	swap();
+}
+
 void Surface::setSwapBehavior(EGLenum swapBehavior)
 {
 	this->swapBehavior = swapBehavior;
@@ -257,6 +266,32 @@ void WindowSurface::swap()
 	}
 }
 
+void WindowSurface::swapWithDamage(const EGLint *rects, EGLint count)
+{
+	if(count == 0)
+	{
+		swap();   // No damage means the whole surface changed
+		return;
+	}
+
+	if(backBuffer && frameBuffer)
+	{
+		std::vector<sw::Rect> damage(count);
+
+		for(int i = 0; i < count; i++)
+		{
+			const EGLint *rect = &rects[4 * i];
+			damage[i] = sw::Rect(rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3]);
+		}
+
+		void *source = backBuffer->lockInternal(0, 0, 0, sw::LOCK_READONLY, sw::PUBLIC);
+		frameBuffer->flipWithDamage(source, backBuffer->sw::Surface::getInternalFormat(), backBuffer->getInternalPitchB(), damage.data(), count);
+		backBuffer->unlockInternal();
+
+		checkForResize();
+	}
+}
+
 EGLNativeWindowType WindowSurface::getWindowHandle() const
 {
 	return window;
@@ -278,11 +313,22 @@ bool WindowSurface::checkForResize()
 		int windowWidth;  window->query(window, NATIVE_WINDOW_WIDTH, &windowWidth);
 		int windowHeight; window->query(window, NATIVE_WINDOW_HEIGHT, &windowHeight);
 	#elif defined(__linux__)
-		XWindowAttributes windowAttributes;
-		libX11->XGetWindowAttributes((::Display*)display->getNativeDisplay(), window, &windowAttributes);
+		int windowWidth;
+		int windowHeight;
+
+		if(display->getNativeDisplay())
+		{
+			XWindowAttributes windowAttributes;
+			libX11->XGetWindowAttributes((::Display*)display->getNativeDisplay(), window, &windowAttributes);
 
-		int windowWidth = windowAttributes.width;
-		int windowHeight = windowAttributes.height;
+			windowWidth = windowAttributes.width;
+			windowHeight = windowAttributes.height;
+		}
+		else   // Headless
+		{
+			windowWidth = ((const EGLHeadlessWindowSW*)window)->width;
+			windowHeight = ((const EGLHeadlessWindowSW*)window)->height;
+		}
 	#elif defined(__APPLE__)
 		int windowWidth;
 		int windowHeight;
@@ -314,6 +360,17 @@ void WindowSurface::deleteResources()
 	Surface::deleteResources();
 }
 
+sw::SharedBackBuffer *WindowSurface::createSharedBackBuffer()
+{
+	// Render straight into the frame buffer's memory when it can present it as-is
+	if(frameBuffer && config->mSamples <= 1)
+	{
+		return frameBuffer->createSharedBackBuffer(config->mRenderTargetFormat);
+	}
+
+	return nullptr;
+}
+
 bool WindowSurface::reset(int backBufferWidth, int backBufferHeight)
 {
 	width = backBufferWidth;
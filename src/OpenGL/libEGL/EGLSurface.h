@@ -36,6 +36,7 @@ class [[clang::lto_visibility_public]] Surface : public gl::Object
 public:
 	virtual bool initialize();
 	virtual void swap() = 0;
+	virtual void swapWithDamage(const EGLint *rects, EGLint count);   // Rectangles as x, y, width, height
 
 	virtual egl::Image *getRenderTarget();
 	virtual egl::Image *getDepthStencil();
@@ -69,6 +70,7 @@ protected:
 	virtual ~Surface();
 
 	virtual void deleteResources();
+	virtual sw::SharedBackBuffer *createSharedBackBuffer() { return nullptr; }
 
 	const Display *const display;
 	Image *depthStencil;
@@ -106,11 +108,13 @@ public:
 
 	bool isWindowSurface() const override { return true; }
 	void swap() override;
+	void swapWithDamage(const EGLint *rects, EGLint count) override;
 
 	EGLNativeWindowType getWindowHandle() const override;
 
 private:
 	void deleteResources() override;
+	sw::SharedBackBuffer *createSharedBackBuffer() override;
 	bool checkForResize();
 	bool reset(int backBufferWidth, int backBufferHeight);
 
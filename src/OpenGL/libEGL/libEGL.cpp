@@ -177,6 +177,7 @@ const char *QueryString(EGLDisplay dpy, EGLint name)
 #if defined(__linux__) && !defined(__ANDROID__)
 			"EGL_KHR_platform_gbm "
 			"EGL_KHR_platform_x11 "
+			"EGL_MESA_platform_surfaceless "
 #endif
 			"EGL_EXT_client_extensions "
 			"EGL_EXT_platform_base");
@@ -200,6 +201,8 @@ const char *QueryString(EGLDisplay dpy, EGLint name)
 		               "EGL_KHR_gl_renderbuffer_image "
 		               "EGL_KHR_fence_sync "
 		               "EGL_KHR_image_base "
+		               "EGL_KHR_surfaceless_context "
+		               "EGL_KHR_swap_buffers_with_damage "
 		               "EGL_ANDROID_framebuffer_target "
 		               "EGL_ANDROID_recordable");
 	case EGL_VENDOR:
@@ -933,6 +936,33 @@ EGLBoolean SwapBuffers(EGLDisplay dpy, EGLSurface surface)
 	return success(EGL_TRUE);
 }
 
+EGLBoolean SwapBuffersWithDamageKHR(EGLDisplay dpy, EGLSurface surface, EGLint *rects, EGLint n_rects)
+{
+	TRACE("(EGLDisplay dpy = %p, EGLSurface surface = %p, EGLint *rects = %p, EGLint n_rects = %d)", dpy, surface, rects, n_rects);
+
+	egl::Display *display = egl::Display::get(dpy);
+	egl::Surface *eglSurface = (egl::Surface*)surface;
+
+	if(!validateSurface(display, eglSurface))
+	{
+		return EGL_FALSE;
+	}
+
+	if(surface == EGL_NO_SURFACE)
+	{
+		return error(EGL_BAD_SURFACE, EGL_FALSE);
+	}
+
+	if(n_rects < 0 || (n_rects > 0 && !rects))
+	{
+		return error(EGL_BAD_PARAMETER, EGL_FALSE);
+	}
+
+	eglSurface->swapWithDamage(rects, n_rects);
+
+	return success(EGL_TRUE);
+}
+
 EGLBoolean CopyBuffers(EGLDisplay dpy, EGLSurface surface, EGLNativePixmapType target)
 {
 	TRACE("(EGLDisplay dpy = %p, EGLSurface surface = %p, EGLNativePixmapType target = %p)", dpy, surface, target);
@@ -1065,6 +1095,7 @@ EGLDisplay GetPlatformDisplayEXT(EGLenum platform, void *native_display, const E
 		{
 		case EGL_PLATFORM_X11_EXT: break;
 		case EGL_PLATFORM_GBM_KHR: break;
+		case EGL_PLATFORM_SURFACELESS_MESA: break;
 		default:
 			return error(EGL_BAD_PARAMETER, EGL_NO_DISPLAY);
 		}
@@ -1081,7 +1112,7 @@ EGLDisplay GetPlatformDisplayEXT(EGLenum platform, void *native_display, const E
 				return error(EGL_BAD_ATTRIBUTE, EGL_NO_DISPLAY);   // Unimplemented
 			}
 		}
-		else if(platform == EGL_PLATFORM_GBM_KHR)
+		else if(platform == EGL_PLATFORM_GBM_KHR || platform == EGL_PLATFORM_SURFACELESS_MESA)
 		{
 			if(native_display != (void*)EGL_DEFAULT_DISPLAY || attrib_list != NULL)
 			{
@@ -1247,6 +1278,7 @@ __eglMustCastToProperFunctionPointerType GetProcAddress(const char *procname)
 		EXTENSION(eglDestroySyncKHR),
 		EXTENSION(eglClientWaitSyncKHR),
 		EXTENSION(eglGetSyncAttribKHR),
+		EXTENSION(eglSwapBuffersWithDamageKHR),
 
 		#undef EXTENSION
 	};
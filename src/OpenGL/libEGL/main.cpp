@@ -369,6 +369,7 @@ EGLSyncKHR CreateSyncKHR(EGLDisplay dpy, EGLenum type, const EGLint *attrib_list
 EGLBoolean DestroySyncKHR(EGLDisplay dpy, EGLSyncKHR sync);
 EGLint ClientWaitSyncKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint flags, EGLTimeKHR timeout);
 EGLBoolean GetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR sync, EGLint attribute, EGLint *value);
+EGLBoolean SwapBuffersWithDamageKHR(EGLDisplay dpy, EGLSurface surface, EGLint *rects, EGLint n_rects);
 __eglMustCastToProperFunctionPointerType GetProcAddress(const char *procname);
 }
 
@@ -584,6 +585,11 @@ EGLAPI EGLBoolean EGLAPIENTRY eglGetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR syn
 	return egl::GetSyncAttribKHR(dpy, sync, attribute, value);
 }
 
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffersWithDamageKHR(EGLDisplay dpy, EGLSurface surface, EGLint *rects, EGLint n_rects)
+{
+	return egl::SwapBuffersWithDamageKHR(dpy, surface, rects, n_rects);
+}
+
 EGLAPI __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(const char *procname)
 {
 	return egl::GetProcAddress(procname);
@@ -632,6 +638,7 @@ LibEGLexports::LibEGLexports()
 	this->eglDestroySyncKHR = egl::DestroySyncKHR;
 	this->eglClientWaitSyncKHR = egl::ClientWaitSyncKHR;
 	this->eglGetSyncAttribKHR = egl::GetSyncAttribKHR;
+	this->eglSwapBuffersWithDamageKHR = egl::SwapBuffersWithDamageKHR;
 
 	this->clientGetCurrentContext = egl::getCurrentContext;
 }
@@ -285,22 +285,27 @@ void Context::makeCurrent(egl::Surface *surface)
 {
 	if(!mHasBeenCurrent)
 	{
+		// Without a surface (EGL_KHR_surfaceless_context) the default framebuffer
+		// has no attachments, and the application sets the viewport for its own
+		int width = surface ? surface->getWidth() : 0;
+		int height = surface ? surface->getHeight() : 0;
+
 		mState.viewportX = 0;
 		mState.viewportY = 0;
-		mState.viewportWidth = surface->getWidth();
-		mState.viewportHeight = surface->getHeight();
+		mState.viewportWidth = width;
+		mState.viewportHeight = height;
 
 		mState.scissorX = 0;
 		mState.scissorY = 0;
-		mState.scissorWidth = surface->getWidth();
-		mState.scissorHeight = surface->getHeight();
+		mState.scissorWidth = width;
+		mState.scissorHeight = height;
 
 		mHasBeenCurrent = true;
 	}
 
 	// Wrap the existing resources into GL objects and assign them to the '0' names
-	egl::Image *defaultRenderTarget = surface->getRenderTarget();
-	egl::Image *depthStencil = surface->getDepthStencil();
+	egl::Image *defaultRenderTarget = surface ? surface->getRenderTarget() : nullptr;
+	egl::Image *depthStencil = surface ? surface->getDepthStencil() : nullptr;
 
 	Colorbuffer *colorbufferZero = new Colorbuffer(defaultRenderTarget);
 	DepthStencilbuffer *depthStencilbufferZero = new DepthStencilbuffer(depthStencil);
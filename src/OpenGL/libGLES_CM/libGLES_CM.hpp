@@ -24,6 +24,7 @@
 namespace sw
 {
 class FrameBuffer;
+class SharedBackBuffer;
 enum Format : unsigned char;
 }
 
@@ -221,7 +222,7 @@ public:
 
 	egl::Context *(*es1CreateContext)(egl::Display *display, const egl::Context *shareContext, const egl::Config *config);
 	__eglMustCastToProperFunctionPointerType (*es1GetProcAddress)(const char *procname);
-	egl::Image *(*createBackBuffer)(int width, int height, const egl::Config *config);
+	egl::Image *(*createBackBuffer)(int width, int height, const egl::Config *config, sw::SharedBackBuffer *sharedBuffer);
 	egl::Image *(*createDepthStencil)(unsigned int width, unsigned int height, sw::Format format, int multiSampleDepth, bool discard);
 	sw::FrameBuffer *(*createFrameBuffer)(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
 };
@@ -332,7 +332,7 @@ void DrawTexfvOES(const GLfloat *coords);
 
 egl::Context *es1CreateContext(egl::Display *display, const egl::Context *shareContext, const egl::Config *config);
 extern "C" __eglMustCastToProperFunctionPointerType es1GetProcAddress(const char *procname);
-egl::Image *createBackBuffer(int width, int height, const egl::Config *config);
+egl::Image *createBackBuffer(int width, int height, const egl::Config *config, sw::SharedBackBuffer *sharedBuffer);
 egl::Image *createDepthStencil(unsigned int width, unsigned int height, sw::Format format, int multiSampleDepth, bool discard);
 sw::FrameBuffer *createFrameBuffer(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
 
@@ -538,6 +538,11 @@ EGLAPI EGLBoolean EGLAPIENTRY eglGetSyncAttribKHR(EGLDisplay dpy, EGLSyncKHR syn
 	return libEGL->eglGetSyncAttribKHR(dpy, sync, attribute, value);
 }
 
+EGLAPI EGLBoolean EGLAPIENTRY eglSwapBuffersWithDamageKHR(EGLDisplay dpy, EGLSurface surface, EGLint *rects, EGLint n_rects)
+{
+	return libEGL->eglSwapBuffersWithDamageKHR(dpy, surface, rects, n_rects);
+}
+
 GL_API void GL_APIENTRY glActiveTexture(GLenum texture)
 {
 	return es1::ActiveTexture(texture);
@@ -36,6 +36,7 @@ COMMON_SRC_FILES := \
 	Renderbuffer.cpp \
 	ResourceManager.cpp \
 	Shader.cpp \
+	ShaderCache.cpp \
 	Texture.cpp \
 	TransformFeedback.cpp \
 	utilities.cpp \
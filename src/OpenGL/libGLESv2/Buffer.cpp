@@ -25,9 +25,13 @@
 namespace es2
 {
 
+const size_t MAX_RETIRED_CONTENTS = 2;   // Per buffer, beyond which renamed contents are freed
+const size_t MAX_PRESERVING_COPY = 64 * 1024;   // Larger contents are only copied for updates of at least a quarter of them
+
 Buffer::Buffer(GLuint name) : NamedObject(name)
 {
 	mContents = 0;
+	mRendererWrites = false;
 	mSize = 0;
 	mUsage = GL_STATIC_DRAW;
 	mIsMapped = false;
@@ -42,6 +46,11 @@ Buffer::~Buffer()
 	{
 		mContents->destruct();
 	}
+
+	for(sw::Resource *contents : mRetired)
+	{
+		contents->destruct();
+	}
 }
 
 void Buffer::bufferData(const void *data, GLsizeiptr size, GLenum usage)
@@ -52,6 +61,13 @@ void Buffer::bufferData(const void *data, GLsizeiptr size, GLenum usage)
 		mContents = 0;
 	}
 
+	for(sw::Resource *contents : mRetired)
+	{
+		contents->destruct();
+	}
+
+	mRetired.clear();
+
 	mSize = size;
 	mUsage = usage;
 
@@ -77,7 +93,14 @@ void Buffer::bufferSubData(const void *data, GLsizeiptr size, GLintptr offset)
 {
 	if(mContents && data)
 	{
-		char *buffer = (char*)mContents->lock(sw::PUBLIC);
+		char *buffer = (char*)mContents->tryLock(sw::PUBLIC);
+
+		if(!buffer)
+		{
+			bool overwrite = (offset == 0 && (size_t)size == mSize);
+			buffer = (char*)rename(!overwrite, size);
+		}
+
 		memcpy(buffer + offset, data, size);
 		mContents->unlock();
 	}
@@ -87,7 +110,29 @@ void* Buffer::mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
 {
 	if(mContents)
 	{
-		char* buffer = (char*)mContents->lock(sw::PUBLIC);
+		char *buffer = nullptr;
+
+		if(access & GL_MAP_UNSYNCHRONIZED_BIT)
+		{
+			// The application guarantees not to modify data used by pending operations
+			buffer = (char*)mContents->data();
+		}
+		else
+		{
+			buffer = (char*)mContents->tryLock(sw::PUBLIC);
+
+			if(!buffer && !(access & GL_MAP_READ_BIT))
+			{
+				bool overwrite = (access & GL_MAP_INVALIDATE_BUFFER_BIT) ||
+				                 ((access & GL_MAP_INVALIDATE_RANGE_BIT) && offset == 0 && (size_t)length == mSize);
+				buffer = (char*)rename(!overwrite, length);
+			}
+			else if(!buffer)
+			{
+				buffer = (char*)mContents->lock(sw::PUBLIC);
+			}
+		}
+
 		mIsMapped = true;
 		mOffset = offset;
 		mLength = length;
@@ -99,7 +144,7 @@ void* Buffer::mapRange(GLintptr offset, GLsizeiptr length, GLbitfield access)
 
 bool Buffer::unmap()
 {
-	if(mContents)
+	if(mContents && !(mAccess & GL_MAP_UNSYNCHRONIZED_BIT))
 	{
 		mContents->unlock();
 	}
@@ -115,4 +160,72 @@ sw::Resource *Buffer::getResource()
 	return mContents;
 }
 
+sw::Resource *Buffer::getOutputResource()
+{
+	mRendererWrites = true;
+
+	return mContents;
+}
+
+void Buffer::sync()
+{
+	if(mContents)
+	{
+		mContents->lock(sw::PUBLIC);
+		mContents->unlock();
+	}
+}
+
+// Replaces contents still in use by pending operations with idle storage, so the application
+// doesn't wait for them. Returns the new contents, locked for application access. When the
+// contents have to be preserved, a small update of large contents waits instead of copying them.
+void *Buffer::rename(bool preserve, size_t updateSize)
+{
+	bool costlyCopy = (mSize > MAX_PRESERVING_COPY) && (updateSize < mSize / 4);
+
+	if(preserve && (mRendererWrites || costlyCopy))
+	{
+		return mContents->lock(sw::PUBLIC);
+	}
+
+	sw::Resource *contents = nullptr;
+	void *buffer = nullptr;
+
+	for(auto retired = mRetired.begin(); retired != mRetired.end(); retired++)
+	{
+		buffer = (*retired)->tryLock(sw::PUBLIC);
+
+		if(buffer)
+		{
+			contents = *retired;
+			mRetired.erase(retired);
+			break;
+		}
+	}
+
+	if(!contents)
+	{
+		contents = new sw::Resource(mContents->size);
+		buffer = contents->lock(sw::PUBLIC);
+	}
+
+	if(preserve)
+	{
+		memcpy(buffer, mContents->data(), mSize);
+	}
+
+	if(mRetired.size() < MAX_RETIRED_CONTENTS)
+	{
+		mRetired.push_back(mContents);
+	}
+	else
+	{
+		mContents->destruct();
+	}
+
+	mContents = contents;
+
+	return buffer;
+}
+
 }
@@ -52,9 +52,15 @@ public:
 	void flushMappedRange(GLintptr offset, GLsizeiptr length) {}
 
 	sw::Resource *getResource();
+	sw::Resource *getOutputResource();   // For renderer writes, like transform feedback and pixel readbacks
+	void sync();   // Waits for pending renderer writes, like asynchronous pixel readbacks
 
 private:
+	void *rename(bool preserve, size_t updateSize);
+
 	sw::Resource *mContents;
+	std::vector<sw::Resource*> mRetired;   // Previous contents used by pending draws, recycled once idle
+	bool mRendererWrites;   // Contents can't be copied while the renderer may still write them
 	size_t mSize;
 	GLenum mUsage;
 	bool mIsMapped;
@@ -172,6 +172,7 @@ Context::Context(egl::Display *display, const Context *shareContext, EGLint clie
 
 	mVertexDataManager = nullptr;
 	mIndexDataManager = nullptr;
+	mShaderCompilerPool = new ShaderCompilerPool();
 
 	mInvalidEnum = false;
 	mInvalidValue = false;
@@ -260,6 +261,7 @@ Context::~Context()
 
 	delete mVertexDataManager;
 	delete mIndexDataManager;
+	delete mShaderCompilerPool;   // Completes the queued compiles
 
 	mResourceManager->release();
 	delete device;
@@ -272,22 +274,27 @@ void Context::makeCurrent(egl::Surface *surface)
 		mVertexDataManager = new VertexDataManager(this);
 		mIndexDataManager = new IndexDataManager();
 
+		// Without a surface (EGL_KHR_surfaceless_context) the default framebuffer
+		// has no attachments, and the application sets the viewport for its own
+		int width = surface ? surface->getWidth() : 0;
+		int height = surface ? surface->getHeight() : 0;
+
 		mState.viewportX = 0;
 		mState.viewportY = 0;
-		mState.viewportWidth = surface->getWidth();
-		mState.viewportHeight = surface->getHeight();
+		mState.viewportWidth = width;
+		mState.viewportHeight = height;
 
 		mState.scissorX = 0;
 		mState.scissorY = 0;
-		mState.scissorWidth = surface->getWidth();
-		mState.scissorHeight = surface->getHeight();
+		mState.scissorWidth = width;
+		mState.scissorHeight = height;
 
 		mHasBeenCurrent = true;
 	}
 
 	// Wrap the existing resources into GL objects and assign them to the '0' names
-	egl::Image *defaultRenderTarget = surface->getRenderTarget();
-	egl::Image *depthStencil = surface->getDepthStencil();
+	egl::Image *defaultRenderTarget = surface ? surface->getRenderTarget() : nullptr;
+	egl::Image *depthStencil = surface ? surface->getDepthStencil() : nullptr;
 
 	Colorbuffer *colorbufferZero = new Colorbuffer(defaultRenderTarget);
 	DepthStencilbuffer *depthStencilbufferZero = new DepthStencilbuffer(depthStencil);
@@ -662,6 +669,11 @@ void Context::setGenerateMipmapHint(GLenum hint)
 	mState.generateMipmapHint = hint;
 }
 
+void Context::setMaxShaderCompilerThreads(GLuint count)
+{
+	mShaderCompilerPool->setMaxThreads(count);
+}
+
 void Context::setFragmentShaderDerivativeHint(GLenum hint)
 {
 	mState.fragmentShaderDerivativeHint = hint;
@@ -1091,9 +1103,16 @@ Shader *Context::getShader(GLuint handle) const
 	return mResourceManager->getShader(handle);
 }
 
-Program *Context::getProgram(GLuint handle) const
+Program *Context::getProgram(GLuint handle, bool resolveLink) const
 {
-	return mResourceManager->getProgram(handle);
+	Program *program = mResourceManager->getProgram(handle);
+
+	if(program && resolveLink)
+	{
+		program->resolveLink();
+	}
+
+	return program;
 }
 
 Texture *Context::getTexture(GLuint handle) const
@@ -1541,6 +1560,12 @@ Buffer *Context::getGenericUniformBuffer() const
 const GLvoid* Context::getPixels(const GLvoid* data) const
 {
 	es2::Buffer* unpackBuffer = getPixelUnpackBuffer();
+
+	if(unpackBuffer)
+	{
+		unpackBuffer->sync();
+	}
+
 	const unsigned char* unpackBufferData = unpackBuffer ? static_cast<const unsigned char*>(unpackBuffer->data()) : nullptr;
 	return unpackBufferData ? unpackBufferData + (ptrdiff_t)(data) : data;
 }
@@ -1611,7 +1636,12 @@ TransformFeedback *Context::getTransformFeedback() const
 
 Program *Context::getCurrentProgram() const
 {
-	return mResourceManager->getProgram(mState.currentProgram);
+	return getProgram(mState.currentProgram);
+}
+
+ShaderCompilerPool *Context::getShaderCompilerPool() const
+{
+	return mShaderCompilerPool;
 }
 
 Texture2D *Context::getTexture2D() const
@@ -1906,6 +1936,7 @@ template<typename T> bool Context::getIntegerv(GLenum pname, T *params) const
 	case GL_MAX_CUBE_MAP_TEXTURE_SIZE:        *params = IMPLEMENTATION_MAX_CUBE_MAP_TEXTURE_SIZE; return true;
 	case GL_NUM_COMPRESSED_TEXTURE_FORMATS:   *params = NUM_COMPRESSED_TEXTURE_FORMATS;           return true;
 	case GL_MAX_SAMPLES_ANGLE:                *params = IMPLEMENTATION_MAX_SAMPLES;               return true;
+	case GL_MAX_SHADER_COMPILER_THREADS_KHR:  *params = mShaderCompilerPool->getMaxThreads();     return true;
 	case GL_SAMPLE_BUFFERS:
 	case GL_SAMPLES:
 		{
@@ -2227,8 +2258,7 @@ template<typename T> bool Context::getIntegerv(GLenum pname, T *params) const
 			*params = mState.pixelUnpackBuffer.name();
 			return true;
 		case GL_PROGRAM_BINARY_FORMATS:
-			// Since NUM_PROGRAM_BINARY_FORMATS is 0, the input
-			// should be a 0 sized array, so don't write to params
+			*params = PROGRAM_BINARY_FORMAT_SWIFTSHADER;
 			return true;
 		case GL_READ_BUFFER:
 			*params = getReadFramebuffer()->getReadBuffer();
@@ -2531,6 +2561,7 @@ bool Context::getQueryParameterInfo(GLenum pname, GLenum *type, unsigned int *nu
 		}
 		break;
 	case GL_MAX_SAMPLES_ANGLE:
+	case GL_MAX_SHADER_COMPILER_THREADS_KHR:
 		{
 			*type = GL_INT;
 			*numParams = 1;
@@ -3208,8 +3239,30 @@ void Context::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
 	GLsizei outputWidth = (mState.packRowLength > 0) ? mState.packRowLength : width;
 	GLsizei outputPitch = egl::ComputePitch(outputWidth, format, type, mState.packAlignment);
 	GLsizei outputHeight = (mState.packImageHeight == 0) ? height : mState.packImageHeight;
-	pixels = getPixelPackBuffer() ? (unsigned char*)getPixelPackBuffer()->data() + (ptrdiff_t)pixels : (unsigned char*)pixels;
-	pixels = ((char*)pixels) + egl::ComputePackingOffset(format, type, outputWidth, outputHeight, mState.packAlignment, mState.packSkipImages, mState.packSkipRows, mState.packSkipPixels);
+	size_t packingOffset = egl::ComputePackingOffset(format, type, outputWidth, outputHeight, mState.packAlignment, mState.packSkipImages, mState.packSkipRows, mState.packSkipPixels);
+
+	Buffer *pixelPackBuffer = getPixelPackBuffer();
+
+	if(pixelPackBuffer)
+	{
+		if(pixelPackBuffer->isMapped())
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+
+		if(width > 0 && height > 0)
+		{
+			size_t requiredSize = (size_t)pixels + packingOffset + (height - 1) * outputPitch + egl::ComputePitch(width, format, type, 1);
+
+			if(requiredSize > pixelPackBuffer->size())
+			{
+				return error(GL_INVALID_OPERATION);
+			}
+		}
+	}
+
+	pixels = pixelPackBuffer ? (unsigned char*)pixelPackBuffer->data() + (ptrdiff_t)pixels : (unsigned char*)pixels;
+	pixels = ((char*)pixels) + packingOffset;
 
 	// Sized query sanity check
 	if(bufSize)
@@ -3244,8 +3297,17 @@ void Context::readPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
 	sw::Surface *externalSurface = sw::Surface::create(width, height, 1, egl::ConvertFormatType(format, type), pixels, outputPitch, outputPitch * outputHeight);
 	sw::SliceRect sliceRect(rect);
 	sw::SliceRect dstSliceRect(dstRect);
-	device->blit(renderTarget, sliceRect, externalSurface, dstSliceRect, false);
-	delete externalSurface;
+
+	if(pixelPackBuffer && pixelPackBuffer->getResource())
+	{
+		// Completes asynchronously. Mapping the buffer or waiting on a fence waits for it.
+		device->readPixels(renderTarget, sliceRect, externalSurface, dstSliceRect, pixelPackBuffer->getOutputResource());
+	}
+	else
+	{
+		device->blit(renderTarget, sliceRect, externalSurface, dstSliceRect, false);
+		delete externalSurface;
+	}
 
 	renderTarget->release();
 }
@@ -4300,6 +4362,7 @@ const GLubyte *Context::getExtensions(GLuint index, GLuint *numExt) const
 		"GL_EXT_texture_filter_anisotropic",
 		"GL_EXT_texture_format_BGRA8888",
 		"GL_EXT_texture_rg",
+		"GL_KHR_parallel_shader_compile",
 		"GL_ANGLE_framebuffer_blit",
 		"GL_ANGLE_framebuffer_multisample",
 		"GL_ANGLE_instanced_arrays",
@@ -48,6 +48,7 @@ struct TranslatedIndexData;
 
 class Device;
 class Shader;
+class ShaderCompilerPool;
 class Program;
 class Texture;
 class Texture2D;
@@ -103,7 +104,7 @@ enum
 	MAX_TRANSFORM_FEEDBACK_SEPARATE_ATTRIBS = 4,
 	MAX_UNIFORM_BUFFER_BINDINGS = sw::MAX_UNIFORM_BUFFER_BINDINGS,
 	UNIFORM_BUFFER_OFFSET_ALIGNMENT = 1,
-	NUM_PROGRAM_BINARY_FORMATS = 0,
+	NUM_PROGRAM_BINARY_FORMATS = 1,
 };
 
 const GLenum compressedTextureFormats[] =
@@ -159,6 +160,9 @@ const GLenum compressedTextureFormats[] =
 
 const GLint NUM_COMPRESSED_TEXTURE_FORMATS = sizeof(compressedTextureFormats) / sizeof(compressedTextureFormats[0]);
 
+// Linked sw::Shader instructions and program tables, only loadable by the same build
+const GLenum PROGRAM_BINARY_FORMAT_SWIFTSHADER = 0x9C50;
+
 const GLint multisampleCount[] = {4, 2, 1};
 const GLint NUM_MULTISAMPLE_COUNTS = sizeof(multisampleCount) / sizeof(multisampleCount[0]);
 const GLint IMPLEMENTATION_MAX_SAMPLES = multisampleCount[0];
@@ -489,6 +493,7 @@ public:
 	void setLineWidth(GLfloat width);
 
 	void setGenerateMipmapHint(GLenum hint);
+	void setMaxShaderCompilerThreads(GLuint count);
 	void setFragmentShaderDerivativeHint(GLenum hint);
 
 	void setViewportParams(GLint x, GLint y, GLsizei width, GLsizei height);
@@ -619,7 +624,7 @@ public:
 	Fence *getFence(GLuint handle) const;
 	FenceSync *getFenceSync(GLsync handle) const;
 	Shader *getShader(GLuint handle) const;
-	Program *getProgram(GLuint handle) const;
+	Program *getProgram(GLuint handle, bool resolveLink = true) const;
 	virtual Texture *getTexture(GLuint handle) const;
 	Framebuffer *getFramebuffer(GLuint handle) const;
 	virtual Renderbuffer *getRenderbuffer(GLuint handle) const;
@@ -642,6 +647,7 @@ public:
 	const GLvoid* getPixels(const GLvoid* data) const;
 	bool getBuffer(GLenum target, es2::Buffer **buffer) const;
 	Program *getCurrentProgram() const;
+	ShaderCompilerPool *getShaderCompilerPool() const;
 	Texture2D *getTexture2D() const;
 	Texture3D *getTexture3D() const;
 	Texture2DArray *getTexture2DArray() const;
@@ -768,6 +774,7 @@ private:
 
 	Device *device;
 	ResourceManager *mResourceManager;
+	ShaderCompilerPool *mShaderCompilerPool;
 };
 }
 
@@ -117,18 +117,36 @@ void Fence::getFenceiv(GLenum pname, GLint *params)
 
 FenceSync::FenceSync(GLuint name, GLenum condition, GLbitfield flags) : NamedObject(name), mCondition(condition), mFlags(flags)
 {
+	mFence = new sw::Fence();
+
+	Device *device = getDevice();
+
+	if(device)
+	{
+		device->addFence(mFence);
+	}
 }
 
 FenceSync::~FenceSync()
 {
+	// The renderer holds its own reference until the fence is signaled
+	mFence->release();
+}
+
+bool FenceSync::isSignaled() const
+{
+	return mFence->isSignaled();
 }
 
 GLenum FenceSync::clientWait(GLbitfield flags, GLuint64 timeout)
 {
-	// The current assumtion is that no matter where the fence is placed, it is
-	// done by the time it is tested, which is similar to Context::flush(), since
-	// we don't queue anything without processing it as fast as possible.
-	return GL_ALREADY_SIGNALED;
+	// Queued operations are processed as fast as possible, so GL_SYNC_FLUSH_COMMANDS_BIT has no effect
+	if(isSignaled())
+	{
+		return GL_ALREADY_SIGNALED;
+	}
+
+	return mFence->wait(timeout) ? GL_CONDITION_SATISFIED : GL_TIMEOUT_EXPIRED;
 }
 
 void FenceSync::serverWait(GLbitfield flags, GLuint64 timeout)
@@ -146,10 +164,7 @@ void FenceSync::getSynciv(GLenum pname, GLsizei *length, GLint *values)
 		}
 		break;
 	case GL_SYNC_STATUS:
-		// The current assumtion is that no matter where the fence is placed, it is
-		// done by the time it is tested, which is similar to Context::flush(), since
-		// we don't queue anything without processing it as fast as possible.
-		values[0] = GL_SIGNALED;
+		values[0] = isSignaled() ? GL_SIGNALED : GL_UNSIGNALED;
 		if(length) {
 			*length = 1;
 		}
@@ -20,6 +20,11 @@
 #include "common/Object.hpp"
 #include <GLES2/gl2.h>
 
+namespace sw
+{
+struct Fence;
+}
+
 namespace es2
 {
 
@@ -55,8 +60,11 @@ public:
 	GLbitfield getFlags() const { return mFlags; }
 
 private:
+	bool isSignaled() const;
+
 	GLenum mCondition;
 	GLbitfield mFlags;
+	sw::Fence *mFence;
 };
 
 }
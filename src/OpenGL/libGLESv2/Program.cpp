@@ -25,6 +25,7 @@
 #include "common/debug.h"
 #include "Shader/PixelShader.hpp"
 #include "Shader/VertexShader.hpp"
+#include "Common/Serializer.hpp"
 
 #include <algorithm>
 #include <string>
@@ -34,11 +35,24 @@ namespace es2
 {
 	unsigned int Program::currentSerial = 1;
 
-	std::string str(int i)
+	namespace
 	{
-		char buffer[20];
-		sprintf(buffer, "%d", i);
-		return buffer;
+		// Precedes the serialized program, to reject binaries from other builds and corrupt data
+		struct BinaryHeader
+		{
+			unsigned int magic;
+			unsigned int build;
+			unsigned int size;       // Payload bytes following the header
+			unsigned int checksum;   // Of the payload
+		};
+
+		const unsigned int binaryMagic = 0x42505753;   // "SWPB"
+
+		// Register indices of -1 denote a uniform which isn't used by the shader
+		bool validRegisterRange(int registerIndex, int registerCount, int maxRegisters)
+		{
+			return registerIndex == -1 || (registerIndex >= 0 && registerIndex + registerCount <= maxRegisters);
+		}
 	}
 
 	Uniform::BlockInfo::BlockInfo(const glsl::Uniform& uniform, int blockIndex)
@@ -61,6 +75,11 @@ namespace es2
 		}
 	}
 
+	Uniform::BlockInfo::BlockInfo(int index, int offset, int arrayStride, int matrixStride, bool isRowMajorMatrix)
+	 : index(index), offset(offset), arrayStride(arrayStride), matrixStride(matrixStride), isRowMajorMatrix(isRowMajorMatrix)
+	{
+	}
+
 	Uniform::Uniform(GLenum type, GLenum precision, const std::string &name, unsigned int arraySize,
 	                 const BlockInfo &blockInfo)
 	 : type(type), precision(precision), name(name), arraySize(arraySize), blockInfo(blockInfo)
@@ -163,6 +182,7 @@ namespace es2
 
 		infoLog = 0;
 		validated = false;
+		linkPending = false;
 
 		resetUniformBlockBindings();
 		unlink();
@@ -174,6 +194,11 @@ namespace es2
 
 	Program::~Program()
 	{
+		if(linkPending)
+		{
+			cancelPendingLink();
+		}
+
 		unlink();
 
 		if(vertexShader)
@@ -1224,7 +1249,7 @@ namespace es2
 				int componentStride = rowCount * colCount * size;
 				int baseOffset = transformFeedback->vertexOffset() * componentStride * sizeof(float);
 				device->VertexProcessor::setTransformFeedbackBuffer(index,
-					transformFeedbackBuffers[index].get()->getResource(),
+					transformFeedbackBuffers[index].get()->getOutputResource(),
 					transformFeedbackBuffers[index].getOffset() + baseOffset,
 					transformFeedbackLinkedVaryings[index].reg * 4 + transformFeedbackLinkedVaryings[index].col,
 					nbRegs, nbComponentsPerReg, componentStride);
@@ -1238,7 +1263,7 @@ namespace es2
 			// In INTERLEAVED_ATTRIBS mode, the values of one or more output variables
 			// written by a vertex shader are written, interleaved, into the buffer object
 			// bound to the first transform feedback binding point (index = 0).
-			sw::Resource* resource = transformFeedbackBuffers[0].get()->getResource();
+			sw::Resource* resource = transformFeedbackBuffers[0].get()->getOutputResource();
 			int componentStride = static_cast<int>(totalLinkedVaryingsComponents);
 			int baseOffset = transformFeedbackBuffers[0].getOffset() + (transformFeedback->vertexOffset() * componentStride * sizeof(float));
 			maxVaryings = sw::min(maxVaryings, (unsigned int)sw::MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS);
@@ -1478,21 +1503,42 @@ namespace es2
 		return true;
 	}
 
-	// Links the code of the vertex and pixel shader by matching up their varyings,
-	// compiling them into binaries, determining the attribute mappings, and collecting
-	// a list of uniforms
+	// Waiting for the shaders to compile is deferred until the program gets used,
+	// so that applications which link many programs don't serialize their compiles
 	void Program::link()
 	{
+		if(linkPending)
+		{
+			cancelPendingLink();
+		}
+
 		unlink();
 
 		resetUniformBlockBindings();
 
-		if(!fragmentShader || !fragmentShader->isCompiled())
+		if(!fragmentShader || !vertexShader)
+		{
+			return;
+		}
+
+		linkPending = true;
+		vertexShader->mPendingLinks.push_back(this);
+		fragmentShader->mPendingLinks.push_back(this);
+	}
+
+	// Links the code of the vertex and pixel shader by matching up their varyings,
+	// compiling them into binaries, determining the attribute mappings, and collecting
+	// a list of uniforms
+	void Program::resolveLink()
+	{
+		if(!linkPending)
 		{
 			return;
 		}
 
-		if(!vertexShader || !vertexShader->isCompiled())
+		cancelPendingLink();
+
+		if(!fragmentShader->isCompiled() || !vertexShader->isCompiled())
 		{
 			return;
 		}
@@ -1534,6 +1580,22 @@ namespace es2
 		linked = true;   // Success
 	}
 
+	bool Program::isLinkCompleted()
+	{
+		return !linkPending || (vertexShader->isCompileCompleted() && fragmentShader->isCompileCompleted());
+	}
+
+	void Program::cancelPendingLink()
+	{
+		std::vector<Program*> &vertexLinks = vertexShader->mPendingLinks;
+		std::vector<Program*> &fragmentLinks = fragmentShader->mPendingLinks;
+
+		vertexLinks.erase(std::find(vertexLinks.begin(), vertexLinks.end(), this));
+		fragmentLinks.erase(std::find(fragmentLinks.begin(), fragmentLinks.end(), this));
+
+		linkPending = false;
+	}
+
 	// Determines the mapping between GL attributes and vertex stream usage indices
 	bool Program::linkAttributes()
 	{
@@ -2461,7 +2523,7 @@ namespace es2
 
 		for(int index = 0; index < MAX_VERTEX_ATTRIBS; index++)
 		{
-			linkedAttribute[index].name.clear();
+			linkedAttribute[index] = glsl::Attribute();
 			attributeStream[index] = -1;
 		}
 
@@ -2508,8 +2570,372 @@ namespace es2
 
 	GLint Program::getBinaryLength() const
 	{
-		UNIMPLEMENTED();
-		return 0;
+		return linked ? (GLint)serialize().size() : 0;
+	}
+
+	bool Program::getBinary(GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) const
+	{
+		ASSERT(linked);
+
+		std::vector<unsigned char> data = serialize();
+
+		if(data.size() > (size_t)bufSize)
+		{
+			return false;
+		}
+
+		memcpy(binary, data.data(), data.size());
+
+		if(length)
+		{
+			*length = (GLsizei)data.size();
+		}
+
+		*binaryFormat = PROGRAM_BINARY_FORMAT_SWIFTSHADER;
+
+		return true;
+	}
+
+	void Program::setBinary(const void *binary, GLsizei length)
+	{
+		unlink();
+		resetInfoLog();
+		resetUniformBlockBindings();
+
+		BinaryHeader header;
+
+		if((size_t)length < sizeof(header))
+		{
+			appendToInfoLog("Program binary is truncated");
+			return;
+		}
+
+		memcpy(&header, binary, sizeof(header));
+		const unsigned char *payload = static_cast<const unsigned char*>(binary) + sizeof(header);
+
+		if(header.magic != binaryMagic || header.build != sw::Shader::getBinaryVersion())
+		{
+			appendToInfoLog("Program binary was produced by a different implementation version");
+			return;
+		}
+
+		if(header.size != length - sizeof(header) || header.checksum != sw::checksum(payload, header.size))
+		{
+			appendToInfoLog("Program binary is corrupt");
+			return;
+		}
+
+		sw::Deserializer stream(payload, header.size);
+
+		if(!deserialize(stream))
+		{
+			unlink();
+			appendToInfoLog("Program binary is corrupt");
+			return;
+		}
+
+		linked = true;
+	}
+
+	// Serializes the result of a successful link, so that linking doesn't have to be redone
+	std::vector<unsigned char> Program::serialize() const
+	{
+		sw::Serializer stream;
+
+		vertexBinary->serialize(stream);
+		pixelBinary->serialize(stream);
+
+		for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
+		{
+			const glsl::Attribute &attribute = linkedAttribute[i];
+
+			stream.write(attribute.type);
+			stream.write(attribute.name);
+			stream.write(attribute.arraySize);
+			stream.write(attribute.location);
+			stream.write(attribute.registerIndex);
+		}
+
+		stream.write(attributeStream);
+
+		for(int i = 0; i < MAX_TEXTURE_IMAGE_UNITS + MAX_VERTEX_TEXTURE_IMAGE_UNITS; i++)
+		{
+			const Sampler &sampler = (i < MAX_TEXTURE_IMAGE_UNITS) ? samplersPS[i] : samplersVS[i - MAX_TEXTURE_IMAGE_UNITS];
+
+			// The other fields of inactive samplers are never initialized
+			stream.write(sampler.active);
+
+			if(sampler.active)
+			{
+				stream.write(sampler.logicalTextureUnit);
+				stream.write(sampler.textureType);
+			}
+		}
+
+		stream.write((unsigned int)uniforms.size());
+
+		for(const Uniform *uniform : uniforms)
+		{
+			stream.write(uniform->type);
+			stream.write(uniform->precision);
+			stream.write(uniform->name);
+			stream.write(uniform->arraySize);
+			stream.write(uniform->blockInfo.index);
+			stream.write(uniform->blockInfo.offset);
+			stream.write(uniform->blockInfo.arrayStride);
+			stream.write(uniform->blockInfo.matrixStride);
+			stream.write(uniform->blockInfo.isRowMajorMatrix);
+			stream.write(uniform->psRegisterIndex);
+			stream.write(uniform->vsRegisterIndex);
+		}
+
+		stream.write((unsigned int)uniformIndex.size());
+
+		for(const UniformLocation &location : uniformIndex)
+		{
+			stream.write(location.name);
+			stream.write(location.element);
+			stream.write(location.index);
+		}
+
+		stream.write((unsigned int)uniformBlocks.size());
+
+		for(const UniformBlock *uniformBlock : uniformBlocks)
+		{
+			stream.write(uniformBlock->name);
+			stream.write(uniformBlock->elementIndex);
+			stream.write(uniformBlock->dataSize);
+			stream.write((unsigned int)uniformBlock->memberUniformIndexes.size());
+
+			for(unsigned int index : uniformBlock->memberUniformIndexes)
+			{
+				stream.write(index);
+			}
+
+			stream.write(uniformBlock->psRegisterIndex);
+			stream.write(uniformBlock->vsRegisterIndex);
+		}
+
+		stream.write((unsigned int)transformFeedbackLinkedVaryings.size());
+
+		for(const LinkedVarying &varying : transformFeedbackLinkedVaryings)
+		{
+			stream.write(varying.name);
+			stream.write(varying.type);
+			stream.write(varying.size);
+			stream.write(varying.reg);
+			stream.write(varying.col);
+		}
+
+		stream.write(transformFeedbackBufferMode);
+		stream.write(totalLinkedVaryingsComponents);
+
+		const std::vector<unsigned char> &payload = stream.data();
+
+		BinaryHeader header;
+		header.magic = binaryMagic;
+		header.build = sw::Shader::getBinaryVersion();
+		header.size = (unsigned int)payload.size();
+		header.checksum = sw::checksum(payload.data(), payload.size());
+
+		std::vector<unsigned char> binary(sizeof(header));
+		memcpy(binary.data(), &header, sizeof(header));
+		binary.insert(binary.end(), payload.begin(), payload.end());
+
+		return binary;
+	}
+
+	bool Program::deserialize(sw::Deserializer &stream)
+	{
+		vertexBinary = new sw::VertexShader();
+		pixelBinary = new sw::PixelShader();
+
+		if(!vertexBinary->deserialize(stream, true) || !pixelBinary->deserialize(stream, true))
+		{
+			return false;
+		}
+
+		for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
+		{
+			glsl::Attribute &attribute = linkedAttribute[i];
+
+			stream.read(attribute.type);
+			stream.read(attribute.name);
+			stream.read(attribute.arraySize);
+			stream.read(attribute.location);
+			stream.read(attribute.registerIndex);
+		}
+
+		stream.read(attributeStream);
+
+		for(int i = 0; i < MAX_TEXTURE_IMAGE_UNITS + MAX_VERTEX_TEXTURE_IMAGE_UNITS; i++)
+		{
+			Sampler &sampler = (i < MAX_TEXTURE_IMAGE_UNITS) ? samplersPS[i] : samplersVS[i - MAX_TEXTURE_IMAGE_UNITS];
+
+			stream.read(sampler.active);
+
+			if(sampler.active)
+			{
+				stream.read(sampler.logicalTextureUnit);
+				stream.read(sampler.textureType);
+			}
+		}
+
+		// The binary is produced by the same build, but its indices are still checked against
+		// the current limits, since they're used to index fixed size arrays without further checks
+		for(int i = 0; i < MAX_VERTEX_ATTRIBS; i++)
+		{
+			if(attributeStream[i] < -1 || attributeStream[i] >= MAX_VERTEX_ATTRIBS)
+			{
+				return false;
+			}
+		}
+
+		for(int i = 0; i < MAX_TEXTURE_IMAGE_UNITS + MAX_VERTEX_TEXTURE_IMAGE_UNITS; i++)
+		{
+			const Sampler &sampler = (i < MAX_TEXTURE_IMAGE_UNITS) ? samplersPS[i] : samplersVS[i - MAX_TEXTURE_IMAGE_UNITS];
+
+			// The texture unit can be any value set with glUniform1i(), and is checked when used
+			if(sampler.active && (sampler.textureType < TEXTURE_2D || sampler.textureType >= TEXTURE_TYPE_COUNT))
+			{
+				return false;
+			}
+		}
+
+		unsigned int uniformCount = stream.readCount(sizeof(GLenum));
+
+		for(unsigned int i = 0; i < uniformCount && stream.isValid(); i++)
+		{
+			GLenum type, precision;
+			std::string name;
+			unsigned int arraySize;
+			int blockIndex, offset, arrayStride, matrixStride;
+			bool isRowMajorMatrix;
+
+			stream.read(type);
+			stream.read(precision);
+			stream.read(name);
+			stream.read(arraySize);
+			stream.read(blockIndex);
+			stream.read(offset);
+			stream.read(arrayStride);
+			stream.read(matrixStride);
+			stream.read(isRowMajorMatrix);
+
+			if(!stream.isValid())
+			{
+				return false;
+			}
+
+			Uniform *uniform = new Uniform(type, precision, name, arraySize, Uniform::BlockInfo(blockIndex, offset, arrayStride, matrixStride, isRowMajorMatrix));
+			uniforms.push_back(uniform);
+
+			stream.read(uniform->psRegisterIndex);
+			stream.read(uniform->vsRegisterIndex);
+
+			if(!validRegisterRange(uniform->psRegisterIndex, uniform->registerCount(), MAX_FRAGMENT_UNIFORM_VECTORS) ||
+			   !validRegisterRange(uniform->vsRegisterIndex, uniform->registerCount(), MAX_VERTEX_UNIFORM_VECTORS))
+			{
+				return false;
+			}
+		}
+
+		unsigned int locationCount = stream.readCount(sizeof(unsigned int));
+
+		for(unsigned int i = 0; i < locationCount && stream.isValid(); i++)
+		{
+			std::string name;
+			unsigned int element, index;
+
+			stream.read(name);
+			stream.read(element);
+			stream.read(index);
+
+			if(index >= uniforms.size() || element >= (unsigned int)uniforms[index]->size())
+			{
+				return false;
+			}
+
+			uniformIndex.push_back(UniformLocation(name, element, index));
+		}
+
+		unsigned int blockCount = stream.readCount(sizeof(unsigned int));
+
+		for(unsigned int i = 0; i < blockCount && stream.isValid(); i++)
+		{
+			std::string name;
+			unsigned int elementIndex, dataSize;
+			std::vector<unsigned int> memberUniformIndexes;
+
+			stream.read(name);
+			stream.read(elementIndex);
+			stream.read(dataSize);
+
+			unsigned int memberCount = stream.readCount(sizeof(unsigned int));
+
+			for(unsigned int j = 0; j < memberCount; j++)
+			{
+				unsigned int index;
+				stream.read(index);
+
+				if(index >= uniforms.size())
+				{
+					return false;
+				}
+
+				memberUniformIndexes.push_back(index);
+			}
+
+			UniformBlock *uniformBlock = new UniformBlock(name, elementIndex, dataSize, memberUniformIndexes);
+			uniformBlocks.push_back(uniformBlock);
+
+			stream.read(uniformBlock->psRegisterIndex);
+			stream.read(uniformBlock->vsRegisterIndex);
+
+			if((uniformBlock->psRegisterIndex != GL_INVALID_INDEX && uniformBlock->psRegisterIndex >= MAX_FRAGMENT_UNIFORM_BLOCKS) ||
+			   (uniformBlock->vsRegisterIndex != GL_INVALID_INDEX && uniformBlock->vsRegisterIndex >= MAX_VERTEX_UNIFORM_BLOCKS))
+			{
+				return false;
+			}
+		}
+
+		if(uniformBlocks.size() > MAX_UNIFORM_BUFFER_BINDINGS)
+		{
+			return false;
+		}
+
+		for(const Uniform *uniform : uniforms)
+		{
+			if(uniform->blockInfo.index < -1 || uniform->blockInfo.index >= (int)uniformBlocks.size())
+			{
+				return false;
+			}
+		}
+
+		unsigned int varyingCount = stream.readCount(sizeof(unsigned int));
+
+		for(unsigned int i = 0; i < varyingCount && stream.isValid(); i++)
+		{
+			LinkedVarying varying;
+
+			stream.read(varying.name);
+			stream.read(varying.type);
+			stream.read(varying.size);
+			stream.read(varying.reg);
+			stream.read(varying.col);
+
+			if(varying.reg < 0 || varying.reg >= sw::MAX_VERTEX_OUTPUTS || varying.col < 0 || varying.col > 3)
+			{
+				return false;
+			}
+
+			transformFeedbackLinkedVaryings.push_back(varying);
+		}
+
+		stream.read(transformFeedbackBufferMode);
+		stream.read(totalLinkedVaryingsComponents);
+
+		return stream.isValid() && stream.remaining() == 0;
 	}
 
 	void Program::release()
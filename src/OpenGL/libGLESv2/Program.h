@@ -40,6 +40,7 @@ namespace es2
 		struct BlockInfo
 		{
 			BlockInfo(const glsl::Uniform& uniform, int blockIndex);
+			BlockInfo(int index, int offset, int arrayStride, int matrixStride, bool isRowMajorMatrix);
 
 			int index;
 			int offset;
@@ -177,6 +178,8 @@ namespace es2
 		void applyTransformFeedback(TransformFeedback* transformFeedback);
 
 		void link();
+		void resolveLink();   // Completes the link, once the program gets used
+		bool isLinkCompleted();   // Doesn't wait for the shaders to compile
 		bool isLinked() const;
 		size_t getInfoLogLength() const;
 		void getInfoLog(GLsizei bufSize, GLsizei *length, char *infoLog);
@@ -216,11 +219,17 @@ namespace es2
 		bool getBinaryRetrievableHint() const { return retrievableBinary; }
 		void setBinaryRetrievable(bool retrievable) { retrievableBinary = retrievable; }
 		GLint getBinaryLength() const;
+		bool getBinary(GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) const;   // Returns false if bufSize is too small
+		void setBinary(const void *binary, GLsizei length);   // Leaves the program unlinked if the binary is rejected
 
 	private:
 		void unlink();
+		void cancelPendingLink();
 		void resetUniformBlockBindings();
 
+		std::vector<unsigned char> serialize() const;
+		bool deserialize(sw::Deserializer &stream);
+
 		bool linkVaryings();
 		bool linkTransformFeedback();
 
@@ -307,6 +316,7 @@ namespace es2
 		LinkedVaryingArray transformFeedbackLinkedVaryings;
 
 		bool linked;
+		bool linkPending;
 		bool orphaned;   // Flag to indicate that the program can be deleted when no longer in use
 		char *infoLog;
 		bool validated;
@@ -20,17 +20,59 @@
 
 #include "main.h"
 #include "utilities.h"
+#include "Program.h"
+#include "ShaderCache.h"
+#include "Common/Configurator.hpp"
+#include "Common/Serializer.hpp"
+#include "Common/CPUID.hpp"
+#include "compiler/PoolAlloc.h"
 
 #include <string>
 #include <algorithm>
+#include <mutex>
+
+namespace
+{
+	const unsigned int MAX_COMPILER_THREADS = 16;
+
+	std::mutex compilerMutex;   // Protects the compile queues and the shaders' compiling state
+	std::condition_variable compileCompleted;
+	int activeCompiles = 0;
+}
 
 namespace es2
 {
 bool Shader::compilerInitialized = false;
 
+static ShBuiltInResources getCompilerResources()
+{
+	ShBuiltInResources resources;
+	resources.MaxVertexAttribs = MAX_VERTEX_ATTRIBS;
+	resources.MaxVertexUniformVectors = MAX_VERTEX_UNIFORM_VECTORS;
+	resources.MaxVaryingVectors = MAX_VARYING_VECTORS;
+	resources.MaxVertexTextureImageUnits = MAX_VERTEX_TEXTURE_IMAGE_UNITS;
+	resources.MaxCombinedTextureImageUnits = MAX_COMBINED_TEXTURE_IMAGE_UNITS;
+	resources.MaxTextureImageUnits = MAX_TEXTURE_IMAGE_UNITS;
+	resources.MaxFragmentUniformVectors = MAX_FRAGMENT_UNIFORM_VECTORS;
+	resources.MaxDrawBuffers = MAX_DRAW_BUFFERS;
+	resources.MaxVertexOutputVectors = MAX_VERTEX_OUTPUT_VECTORS;
+	resources.MaxFragmentInputVectors = MAX_FRAGMENT_INPUT_VECTORS;
+	resources.MinProgramTexelOffset = MIN_PROGRAM_TEXEL_OFFSET;
+	resources.MaxProgramTexelOffset = MAX_PROGRAM_TEXEL_OFFSET;
+	resources.OES_standard_derivatives = 1;
+	resources.OES_fragment_precision_high = 1;
+	resources.OES_EGL_image_external = 1;
+	resources.EXT_draw_buffers = 1;
+	resources.MaxCallStackDepth = 16;
+
+	return resources;
+}
+
 Shader::Shader(ResourceManager *manager, GLuint handle) : mHandle(handle), mResourceManager(manager)
 {
 	mSource = nullptr;
+	mCompileClientVersion = 0;
+	mCompilerPool = nullptr;
 
 	clear();
 
@@ -88,8 +130,10 @@ void Shader::setSource(GLsizei count, const char *const *string, const GLint *le
 	mSource[totalLength] = '\0';
 }
 
-size_t Shader::getInfoLogLength() const
+size_t Shader::getInfoLogLength()
 {
+	waitForCompile();
+
 	if(infoLog.empty())
 	{
 		return 0;
@@ -102,6 +146,8 @@ size_t Shader::getInfoLogLength() const
 
 void Shader::getInfoLog(GLsizei bufSize, GLsizei *length, char *infoLogOut)
 {
+	waitForCompile();
+
 	int index = 0;
 
 	if(bufSize > 0)
@@ -156,33 +202,8 @@ void Shader::getSource(GLsizei bufSize, GLsizei *length, char *source)
 
 TranslatorASM *Shader::createCompiler(GLenum shaderType)
 {
-	if(!compilerInitialized)
-	{
-		InitCompilerGlobals();
-		compilerInitialized = true;
-	}
-
 	TranslatorASM *assembler = new TranslatorASM(this, shaderType);
-
-	ShBuiltInResources resources;
-	resources.MaxVertexAttribs = MAX_VERTEX_ATTRIBS;
-	resources.MaxVertexUniformVectors = MAX_VERTEX_UNIFORM_VECTORS;
-	resources.MaxVaryingVectors = MAX_VARYING_VECTORS;
-	resources.MaxVertexTextureImageUnits = MAX_VERTEX_TEXTURE_IMAGE_UNITS;
-	resources.MaxCombinedTextureImageUnits = MAX_COMBINED_TEXTURE_IMAGE_UNITS;
-	resources.MaxTextureImageUnits = MAX_TEXTURE_IMAGE_UNITS;
-	resources.MaxFragmentUniformVectors = MAX_FRAGMENT_UNIFORM_VECTORS;
-	resources.MaxDrawBuffers = MAX_DRAW_BUFFERS;
-	resources.MaxVertexOutputVectors = MAX_VERTEX_OUTPUT_VECTORS;
-	resources.MaxFragmentInputVectors = MAX_FRAGMENT_INPUT_VECTORS;
-	resources.MinProgramTexelOffset = MIN_PROGRAM_TEXEL_OFFSET;
-	resources.MaxProgramTexelOffset = MAX_PROGRAM_TEXEL_OFFSET;
-	resources.OES_standard_derivatives = 1;
-	resources.OES_fragment_precision_high = 1;
-	resources.OES_EGL_image_external = 1;
-	resources.EXT_draw_buffers = 1;
-	resources.MaxCallStackDepth = 16;
-	assembler->Init(resources);
+	assembler->Init(getCompilerResources());
 
 	return assembler;
 }
@@ -194,23 +215,82 @@ void Shader::clear()
 	varyings.clear();
 	activeUniforms.clear();
 	activeAttributes.clear();
+	activeUniformBlocks.clear();
 }
 
 void Shader::compile()
+{
+	waitForCompile();
+
+	// Links which read the previous compile results have to complete first
+	while(!mPendingLinks.empty())
+	{
+		mPendingLinks.back()->resolveLink();
+	}
+
+	if(!compilerInitialized)
+	{
+		InitCompilerGlobals();
+		compilerInitialized = true;
+
+		// Single pages of destroyed pool allocators are cached up to this many kilobytes
+		sw::Configurator ini("SwiftShader.ini");
+		int pageCacheSize = ini.getInteger("Caches", "CompilerPageCacheSize", 1024);
+		TPoolAllocator::setPageCacheLimit((size_t)std::max(pageCacheSize, 0) * 1024);
+	}
+
+	es2::Context *context = es2::getContext();
+
+	mCompileSource = mSource ? mSource : "";
+	mCompileClientVersion = context->getClientVersion();
+
+	ShaderCompilerPool *compilerPool = context->getShaderCompilerPool();
+
+	if(compilerPool->isEnabled())
+	{
+		compilerPool->schedule(this);
+	}
+	else
+	{
+		compileSource();
+	}
+}
+
+void Shader::compileSource()
 {
 	clear();
 
 	createShader();
-	TranslatorASM *compiler = createCompiler(getType());
 
-	// Ensure we don't pass a nullptr source to the compiler
-	const char *source = "\0";
-	if(mSource)
+	const char *source = mCompileSource.c_str();
+
+	// The compilation result only depends on the shader type, the compiler resources and the source
+	GLenum type = getType();
+	ShBuiltInResources resources = getCompilerResources();
+	std::string key(reinterpret_cast<const char*>(&type), sizeof(type));
+	key.append(reinterpret_cast<const char*>(&resources), sizeof(resources));
+	key.append(source);
+
+	bool success = false;
+	int shaderVersion = 0;
+	std::string compilerLog;
+	std::vector<unsigned char> cached;
+
+	if(!ShaderCache::lookup(key, cached) || !deserialize(cached, success, shaderVersion, compilerLog))
 	{
-		source = mSource;
-	}
+		clear();
+		createShader();
 
-	bool success = compiler->compile(&source, 1, SH_OBJECT_CODE);
+		TranslatorASM *compiler = createCompiler(type);
+
+		success = compiler->compile(&source, 1, SH_OBJECT_CODE);
+		shaderVersion = compiler->getShaderVersion();
+		compilerLog = compiler->getInfoSink().info.c_str();
+
+		delete compiler;
+
+		ShaderCache::insert(key, serialize(success, shaderVersion, compilerLog));
+	}
 
 	if(false)
 	{
@@ -218,16 +298,13 @@ void Shader::compile()
 		char buffer[256];
 		sprintf(buffer, "shader-input-%d-%d.txt", getName(), serial);
 		FILE *file = fopen(buffer, "wt");
-		fprintf(file, "%s", mSource);
+		fprintf(file, "%s", source);
 		fclose(file);
 		getShader()->print("shader-output-%d-%d.txt", getName(), serial);
 		serial++;
 	}
 
-	int shaderVersion = compiler->getShaderVersion();
-	int clientVersion = es2::getContext()->getClientVersion();
-
-	if(shaderVersion >= 300 && clientVersion < 3)
+	if(shaderVersion >= 300 && mCompileClientVersion < 3)
 	{
 		infoLog = "GLSL ES 3.00 is not supported by OpenGL ES 2.0 contexts";
 		success = false;
@@ -237,18 +314,233 @@ void Shader::compile()
 	{
 		deleteShader();
 
-		infoLog += compiler->getInfoSink().info.c_str();
+		infoLog += compilerLog;
 		TRACE("\n%s", infoLog.c_str());
 	}
+}
 
-	delete compiler;
+// Serializes the outcome of a compilation, for the ShaderCache
+std::vector<unsigned char> Shader::serialize(bool success, int shaderVersion, const std::string &compilerLog) const
+{
+	sw::Serializer stream;
+
+	stream.write(success);
+	stream.write(shaderVersion);
+	stream.write(compilerLog);
+
+	if(!success)
+	{
+		return stream.data();
+	}
+
+	if(getType() == GL_VERTEX_SHADER)
+	{
+		getVertexShader()->serialize(stream);
+	}
+	else
+	{
+		getPixelShader()->serialize(stream);
+	}
+
+	stream.write((unsigned int)varyings.size());
+
+	for(const glsl::Varying &varying : varyings)
+	{
+		stream.write(varying.type);
+		stream.write(varying.name);
+		stream.write(varying.arraySize);
+		stream.write(varying.reg);
+		stream.write(varying.col);
+	}
+
+	stream.write((unsigned int)activeUniforms.size());
+
+	for(const glsl::Uniform &uniform : activeUniforms)
+	{
+		stream.write(uniform.type);
+		stream.write(uniform.precision);
+		stream.write(uniform.name);
+		stream.write(uniform.arraySize);
+		stream.write(uniform.registerIndex);
+		stream.write(uniform.blockId);
+		stream.write(uniform.blockInfo);
+	}
+
+	stream.write((unsigned int)activeAttributes.size());
+
+	for(const glsl::Attribute &attribute : activeAttributes)
+	{
+		stream.write(attribute.type);
+		stream.write(attribute.name);
+		stream.write(attribute.arraySize);
+		stream.write(attribute.location);
+		stream.write(attribute.registerIndex);
+	}
+
+	stream.write((unsigned int)activeUniformBlocks.size());
+
+	for(const glsl::UniformBlock &block : activeUniformBlocks)
+	{
+		stream.write(block.name);
+		stream.write(block.dataSize);
+		stream.write(block.arraySize);
+		stream.write(block.layout);
+		stream.write(block.isRowMajorLayout);
+		stream.write(block.registerIndex);
+		stream.write(block.blockId);
+		stream.write((unsigned int)block.fields.size());
+
+		for(int field : block.fields)
+		{
+			stream.write(field);
+		}
+	}
+
+	return stream.data();
+}
+
+bool Shader::deserialize(const std::vector<unsigned char> &data, bool &success, int &shaderVersion, std::string &compilerLog)
+{
+	sw::Deserializer stream(data.data(), data.size());
+
+	stream.read(success);
+	stream.read(shaderVersion);
+	stream.read(compilerLog);
+
+	if(!success)
+	{
+		return stream.isValid();
+	}
+
+	bool valid = (getType() == GL_VERTEX_SHADER) ? getVertexShader()->deserialize(stream, false) :
+	                                               getPixelShader()->deserialize(stream, false);
+
+	unsigned int varyingCount = stream.readCount(sizeof(GLenum));
+
+	for(unsigned int i = 0; i < varyingCount && stream.isValid(); i++)
+	{
+		GLenum type;
+		std::string name;
+		int arraySize, reg, col;
+
+		stream.read(type);
+		stream.read(name);
+		stream.read(arraySize);
+		stream.read(reg);
+		stream.read(col);
+
+		varyings.push_back(glsl::Varying(type, name, arraySize, reg, col));
+	}
+
+	unsigned int uniformCount = stream.readCount(sizeof(GLenum));
+
+	for(unsigned int i = 0; i < uniformCount && stream.isValid(); i++)
+	{
+		GLenum type, precision;
+		std::string name;
+		int arraySize, registerIndex, blockId;
+		glsl::BlockMemberInfo blockInfo;
+
+		stream.read(type);
+		stream.read(precision);
+		stream.read(name);
+		stream.read(arraySize);
+		stream.read(registerIndex);
+		stream.read(blockId);
+		stream.read(blockInfo);
+
+		activeUniforms.push_back(glsl::Uniform(type, precision, name, arraySize, registerIndex, blockId, blockInfo));
+	}
+
+	unsigned int attributeCount = stream.readCount(sizeof(GLenum));
+
+	for(unsigned int i = 0; i < attributeCount && stream.isValid(); i++)
+	{
+		glsl::Attribute attribute;
+
+		stream.read(attribute.type);
+		stream.read(attribute.name);
+		stream.read(attribute.arraySize);
+		stream.read(attribute.location);
+		stream.read(attribute.registerIndex);
+
+		activeAttributes.push_back(attribute);
+	}
+
+	unsigned int blockCount = stream.readCount(sizeof(unsigned int));
+
+	for(unsigned int i = 0; i < blockCount && stream.isValid(); i++)
+	{
+		std::string name;
+		unsigned int dataSize, arraySize;
+		TLayoutBlockStorage layout;
+		bool isRowMajorLayout;
+		int registerIndex, blockId;
+
+		stream.read(name);
+		stream.read(dataSize);
+		stream.read(arraySize);
+		stream.read(layout);
+		stream.read(isRowMajorLayout);
+		stream.read(registerIndex);
+		stream.read(blockId);
+
+		glsl::UniformBlock block(name, dataSize, arraySize, layout, isRowMajorLayout, registerIndex, blockId);
+
+		unsigned int fieldCount = stream.readCount(sizeof(int));
+
+		for(unsigned int j = 0; j < fieldCount; j++)
+		{
+			int field;
+			stream.read(field);
+			block.fields.push_back(field);
+		}
+
+		activeUniformBlocks.push_back(block);
+	}
+
+	return valid && stream.isValid() && stream.remaining() == 0;
 }
 
 bool Shader::isCompiled()
 {
+	waitForCompile();
+
 	return getShader() != 0;
 }
 
+bool Shader::isCompileCompleted()
+{
+	std::lock_guard<std::mutex> lock(compilerMutex);
+
+	return !mCompilerPool;
+}
+
+void Shader::waitForCompile()
+{
+	std::unique_lock<std::mutex> lock(compilerMutex);
+
+	if(!mCompilerPool)
+	{
+		return;
+	}
+
+	if(mCompilerPool->unschedule(this))
+	{
+		lock.unlock();
+		compileSource();
+		lock.lock();
+
+		mCompilerPool = nullptr;
+		activeCompiles--;
+		compileCompleted.notify_all();
+	}
+	else
+	{
+		compileCompleted.wait(lock, [this]() { return !mCompilerPool; });
+	}
+}
+
 void Shader::addRef()
 {
 	mRefCount++;
@@ -281,6 +573,11 @@ void Shader::flagForDeletion()
 
 void Shader::releaseCompiler()
 {
+	{
+		std::unique_lock<std::mutex> lock(compilerMutex);
+		compileCompleted.wait(lock, []() { return activeCompiles == 0; });
+	}
+
 	FreeCompilerGlobals();
 	compilerInitialized = false;
 }
@@ -375,6 +672,8 @@ VertexShader::VertexShader(ResourceManager *manager, GLuint handle) : Shader(man
 
 VertexShader::~VertexShader()
 {
+	waitForCompile();
+
 	delete vertexShader;
 }
 
@@ -428,6 +727,8 @@ FragmentShader::FragmentShader(ResourceManager *manager, GLuint handle) : Shader
 
 FragmentShader::~FragmentShader()
 {
+	waitForCompile();
+
 	delete pixelShader;
 }
 
@@ -458,4 +759,102 @@ void FragmentShader::deleteShader()
 	pixelShader = nullptr;
 }
 
+ShaderCompilerPool::ShaderCompilerPool()
+{
+	maxThreads = 0xFFFFFFFF;   // Chosen by the implementation
+	terminate = false;
+}
+
+ShaderCompilerPool::~ShaderCompilerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(compilerMutex);
+		terminate = true;
+	}
+
+	queued.notify_all();
+
+	for(sw::Thread *thread : threads)
+	{
+		thread->join();
+		delete thread;
+	}
+}
+
+void ShaderCompilerPool::setMaxThreads(GLuint count)
+{
+	maxThreads = count;
+}
+
+GLuint ShaderCompilerPool::getMaxThreads() const
+{
+	return maxThreads;
+}
+
+bool ShaderCompilerPool::isEnabled() const
+{
+	return maxThreads != 0;
+}
+
+void ShaderCompilerPool::schedule(Shader *shader)
+{
+	std::lock_guard<std::mutex> lock(compilerMutex);
+
+	shader->mCompilerPool = this;
+	activeCompiles++;
+	queue.push_back(shader);
+
+	// Threads are created on demand, up to the number of cores
+	unsigned int threadCount = std::min(std::min(maxThreads, MAX_COMPILER_THREADS), (unsigned int)sw::CPUID::coreCount());
+
+	if(threads.size() < std::max(threadCount, 1u))
+	{
+		threads.push_back(new sw::Thread(compilerThread, this));
+	}
+
+	queued.notify_one();
+}
+
+bool ShaderCompilerPool::unschedule(Shader *shader)
+{
+	std::deque<Shader*>::iterator queuedShader = std::find(queue.begin(), queue.end(), shader);
+
+	if(queuedShader == queue.end())
+	{
+		return false;
+	}
+
+	queue.erase(queuedShader);
+
+	return true;
+}
+
+void ShaderCompilerPool::compilerThread(void *parameters)
+{
+	ShaderCompilerPool *pool = static_cast<ShaderCompilerPool*>(parameters);
+
+	std::unique_lock<std::mutex> lock(compilerMutex);
+
+	while(true)
+	{
+		pool->queued.wait(lock, [pool]() { return pool->terminate || !pool->queue.empty(); });
+
+		if(pool->queue.empty())
+		{
+			return;   // Terminated, after completing the queued compiles
+		}
+
+		Shader *shader = pool->queue.front();
+		pool->queue.pop_front();
+
+		lock.unlock();
+		shader->compileSource();
+		lock.lock();
+
+		shader->mCompilerPool = nullptr;
+		activeCompiles--;
+		compileCompleted.notify_all();
+	}
+}
+
 }
@@ -23,12 +23,15 @@
 #include "ResourceManager.h"
 
 #include "compiler/TranslatorASM.h"
+#include "Common/Thread.hpp"
 
 #include <GLES2/gl2.h>
 
 #include <string>
 #include <list>
 #include <vector>
+#include <deque>
+#include <condition_variable>
 
 namespace glsl
 {
@@ -37,10 +40,13 @@ namespace glsl
 
 namespace es2
 {
+class Program;
+class ShaderCompilerPool;
 
 class Shader : public glsl::Shader
 {
 	friend class Program;
+	friend class ShaderCompilerPool;
 
 public:
 	Shader(ResourceManager *manager, GLuint handle);
@@ -52,13 +58,14 @@ public:
 
 	void deleteSource();
 	void setSource(GLsizei count, const char *const *string, const GLint *length);
-	size_t getInfoLogLength() const;
+	size_t getInfoLogLength();
 	void getInfoLog(GLsizei bufSize, GLsizei *length, char *infoLog);
 	size_t getSourceLength() const;
 	void getSource(GLsizei bufSize, GLsizei *length, char *source);
 
-	void compile();
+	void compile();   // Runs on a compiler thread, unless the context disabled them
 	bool isCompiled();
+	bool isCompileCompleted();   // Doesn't wait for the compiler thread
 
 	void addRef();
 	void release();
@@ -69,12 +76,17 @@ public:
 	static void releaseCompiler();
 
 protected:
+	void waitForCompile();   // Derived classes have to wait before destroying their shader
+
 	static bool compilerInitialized;
 	TranslatorASM *createCompiler(GLenum shaderType);
 	void clear();
 
 	static bool compareVarying(const glsl::Varying &x, const glsl::Varying &y);
 
+	std::vector<unsigned char> serialize(bool success, int shaderVersion, const std::string &compilerLog) const;
+	bool deserialize(const std::vector<unsigned char> &data, bool &success, int &shaderVersion, std::string &compilerLog);
+
 	char *mSource;
 	std::string infoLog;
 
@@ -82,6 +94,13 @@ private:
 	virtual void createShader() = 0;
 	virtual void deleteShader() = 0;
 
+	void compileSource();
+
+	std::string mCompileSource;   // Copied, as the source may change while compiling
+	int mCompileClientVersion;
+	ShaderCompilerPool *mCompilerPool;     // Set while compiling, protected by the compiler mutex
+	std::vector<Program*> mPendingLinks;   // Programs whose deferred link reads the compile results
+
 	const GLuint mHandle;
 	unsigned int mRefCount;     // Number of program objects this shader is attached to
 	bool mDeleteStatus;         // Flag to indicate that the shader can be deleted when no longer in use
@@ -129,6 +148,33 @@ private:
 
 	sw::PixelShader *pixelShader;
 };
+
+// Compiles the shaders of a context on up to a given number of threads,
+// as set by glMaxShaderCompilerThreadsKHR. Compiles which haven't started
+// yet are taken over by the thread which waits for them.
+class ShaderCompilerPool
+{
+public:
+	ShaderCompilerPool();
+
+	~ShaderCompilerPool();   // Completes the queued compiles
+
+	void setMaxThreads(GLuint count);
+	GLuint getMaxThreads() const;
+	bool isEnabled() const;
+
+	void schedule(Shader *shader);
+	bool unschedule(Shader *shader);   // Returns false if the compile already started. Requires the compiler mutex.
+
+private:
+	static void compilerThread(void *parameters);
+
+	GLuint maxThreads;
+	std::deque<Shader*> queue;         // Protected by the compiler mutex
+	std::condition_variable queued;
+	std::vector<sw::Thread*> threads;
+	bool terminate;
+};
 }
 
 #endif   // LIBGLESV2_SHADER_H_
@@ -0,0 +1,263 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// ShaderCache.cpp: Implements the ShaderCache class, a process-wide cache of
+// GLSL compilation results with an optional on-disk tier.
+
+#include "ShaderCache.h"
+
+#include "Common/Configurator.hpp"
+#include "Common/MutexLock.hpp"
+#include "Common/Serializer.hpp"
+#include "Common/Thread.hpp"
+#include "Renderer/LRUCache.hpp"
+#include "Shader/Shader.hpp"
+#include "common/debug.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+	struct Key
+	{
+		bool operator==(const Key &key) const
+		{
+			return hash == key.hash && text == key.text;
+		}
+
+		unsigned int hash;
+		std::string text;
+	};
+
+	// Reference counted as required by sw::LRUCache
+	class Entry
+	{
+	public:
+		explicit Entry(const std::vector<unsigned char> &result) : result(result), bindCount(0)
+		{
+		}
+
+		void bind()
+		{
+			bindCount++;
+		}
+
+		void unbind()
+		{
+			if(--bindCount == 0)
+			{
+				delete this;
+			}
+		}
+
+		const std::vector<unsigned char> result;
+
+	private:
+		int bindCount;   // Protected by the cache mutex
+	};
+
+	// Precedes the key and result in files of the on-disk tier
+	struct FileHeader
+	{
+		unsigned int magic;
+		unsigned int build;
+		unsigned int keySize;
+		unsigned int resultSize;
+		unsigned int checksum;   // Of the key and result
+	};
+
+	const unsigned int fileMagic = 0x43535753;   // "SWSC"
+
+	sw::MutexLock mutex;   // Protects all of the below. Not held during file I/O.
+	bool initialized = false;
+	sw::LRUCache<Key, Entry> *cache = nullptr;   // Null when the in-memory tier is disabled
+	std::string directory;   // Empty when the on-disk tier is disabled. Constant after initialization.
+	int tempFileCount = 0;
+
+	void initialize()
+	{
+		if(initialized)
+		{
+			return;
+		}
+
+		sw::Configurator ini("SwiftShader.ini");
+		int size = ini.getInteger("Caches", "ShaderCompileCacheSize", 64);
+		directory = ini.getValue("Caches", "ShaderCompileCacheDirectory", "");
+
+		if(size > 0)
+		{
+			cache = new sw::LRUCache<Key, Entry>(size);
+		}
+
+		if(!directory.empty() && directory.back() != '/' && directory.back() != '\\')
+		{
+			directory += '/';
+		}
+
+		initialized = true;
+	}
+
+	std::string fileName(const Key &key)
+	{
+		char name[32];
+		sprintf(name, "%08X%08X.glsl.bin", key.hash, sw::checksum(key.text.data(), key.text.size(), 0));
+
+		return directory + name;
+	}
+
+	bool readFile(const Key &key, std::vector<unsigned char> &result)
+	{
+		FILE *file = fopen(fileName(key).c_str(), "rb");
+
+		if(!file)
+		{
+			return false;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		FileHeader header;
+		std::string text;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+		             header.magic == fileMagic &&
+		             header.build == sw::Shader::getBinaryVersion() &&
+		             header.keySize == key.text.size() &&
+		             sizeof(header) + header.keySize + (size_t)header.resultSize == (size_t)size;
+
+		if(valid)
+		{
+			text.resize(header.keySize);
+			result.resize(header.resultSize);
+
+			valid = fread(&text[0], 1, text.size(), file) == text.size() &&
+			        fread(result.data(), 1, result.size(), file) == result.size() &&
+			        text == key.text &&
+			        sw::checksum(result.data(), result.size(), sw::checksum(text.data(), text.size())) == header.checksum;
+		}
+
+		fclose(file);
+
+		return valid;
+	}
+
+	// Writes to a temporary file which gets renamed when complete, so that other
+	// threads and processes never read a partially written cache file
+	void writeFile(const Key &key, const std::vector<unsigned char> &result)
+	{
+		char suffix[32];
+		sprintf(suffix, ".%d.%d.tmp", getpid(), sw::atomicIncrement(&tempFileCount));
+
+		const std::string name = fileName(key);
+		const std::string tempName = name + suffix;
+
+		FILE *file = fopen(tempName.c_str(), "wb");
+
+		if(!file)
+		{
+			TRACE("Failed to write shader cache file %s", tempName.c_str());
+			return;
+		}
+
+		FileHeader header;
+		header.magic = fileMagic;
+		header.build = sw::Shader::getBinaryVersion();
+		header.keySize = (unsigned int)key.text.size();
+		header.resultSize = (unsigned int)result.size();
+		header.checksum = sw::checksum(result.data(), result.size(), sw::checksum(key.text.data(), key.text.size()));
+
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		               fwrite(key.text.data(), 1, key.text.size(), file) == key.text.size() &&
+		               fwrite(result.data(), 1, result.size(), file) == result.size();
+
+		written = (fclose(file) == 0) && written;
+
+		// Renaming fails on Windows when another writer already stored the same result
+		if(!written || rename(tempName.c_str(), name.c_str()) != 0)
+		{
+			remove(tempName.c_str());
+		}
+	}
+}
+
+namespace es2
+{
+	bool ShaderCache::lookup(const std::string &text, std::vector<unsigned char> &result)
+	{
+		Key key;
+		key.hash = sw::checksum(text.data(), text.size());
+		key.text = text;
+
+		{
+			LockGuard lock(mutex);
+			initialize();
+
+			if(cache)
+			{
+				const Entry *entry = cache->query(key);
+
+				if(entry)
+				{
+					result = entry->result;
+					return true;
+				}
+			}
+		}
+
+		if(!directory.empty() && readFile(key, result))
+		{
+			LockGuard lock(mutex);
+
+			if(cache)
+			{
+				cache->add(key, new Entry(result));
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void ShaderCache::insert(const std::string &text, const std::vector<unsigned char> &result)
+	{
+		Key key;
+		key.hash = sw::checksum(text.data(), text.size());
+		key.text = text;
+
+		{
+			LockGuard lock(mutex);
+			initialize();
+
+			if(cache)
+			{
+				cache->add(key, new Entry(result));
+			}
+		}
+
+		if(!directory.empty())
+		{
+			writeFile(key, result);
+		}
+	}
+}
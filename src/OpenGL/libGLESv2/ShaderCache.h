@@ -0,0 +1,37 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// ShaderCache.h: Defines the ShaderCache class, a process-wide cache of GLSL
+// compilation results. Results are looked up by content, so compiling the same
+// source again, from any context or shader object, doesn't run the compiler.
+
+#ifndef LIBGLESV2_SHADERCACHE_H_
+#define LIBGLESV2_SHADERCACHE_H_
+
+#include <string>
+#include <vector>
+
+namespace es2
+{
+	class ShaderCache
+	{
+	public:
+		// The key has to capture everything the result depends on: the shader type,
+		// the compiler resources and extensions, and the source text.
+		static bool lookup(const std::string &key, std::vector<unsigned char> &result);
+		static void insert(const std::string &key, const std::vector<unsigned char> &result);
+	};
+}
+
+#endif   // LIBGLESV2_SHADERCACHE_H_
@@ -2014,8 +2014,13 @@ GLenum TextureExternal::getTarget() const
 
 }
 
-egl::Image *createBackBuffer(int width, int height, const egl::Config *config)
+egl::Image *createBackBuffer(int width, int height, const egl::Config *config, sw::SharedBackBuffer *sharedBuffer)
 {
+	if(config && sharedBuffer)
+	{
+		return egl::Image::create(width, height, config->mRenderTargetFormat, sharedBuffer);
+	}
+
 	if(config)
 	{
 		return egl::Image::create(width, height, config->mRenderTargetFormat, config->mSamples, false);
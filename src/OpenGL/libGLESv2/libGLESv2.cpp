@@ -3150,7 +3150,8 @@ void GetProgramiv(GLuint program, GLenum pname, GLint* params)
 
 	if(context)
 	{
-		es2::Program *programObject = context->getProgram(program);
+		// Querying the completion status must not wait for the link
+		es2::Program *programObject = context->getProgram(program, pname != GL_COMPLETION_STATUS_KHR);
 
 		if(!programObject)
 		{
@@ -3174,6 +3175,9 @@ void GetProgramiv(GLuint program, GLenum pname, GLint* params)
 		case GL_LINK_STATUS:
 			*params = programObject->isLinked();
 			return;
+		case GL_COMPLETION_STATUS_KHR:
+			*params = programObject->isLinkCompleted() ? GL_TRUE : GL_FALSE;
+			return;
 		case GL_VALIDATE_STATUS:
 			*params = programObject->isValidated();
 			return;
@@ -3416,6 +3420,9 @@ void GetShaderiv(GLuint shader, GLenum pname, GLint* params)
 		case GL_COMPILE_STATUS:
 			*params = shaderObject->isCompiled() ? GL_TRUE : GL_FALSE;
 			return;
+		case GL_COMPLETION_STATUS_KHR:
+			*params = shaderObject->isCompileCompleted() ? GL_TRUE : GL_FALSE;
+			return;
 		case GL_INFO_LOG_LENGTH:
 			*params = (GLint)shaderObject->getInfoLogLength();
 			return;
@@ -6850,6 +6857,18 @@ void DrawBuffersEXT(GLsizei n, const GLenum *bufs)
 	}
 }
 
+void MaxShaderCompilerThreadsKHR(GLuint count)
+{
+	TRACE("(GLuint count = %u)", count);
+
+	es2::Context *context = es2::getContext();
+
+	if(context)
+	{
+		context->setMaxShaderCompilerThreads(count);
+	}
+}
+
 }
 
 extern "C" __eglMustCastToProperFunctionPointerType es2GetProcAddress(const char *procname)
@@ -6910,6 +6929,7 @@ extern "C" __eglMustCastToProperFunctionPointerType es2GetProcAddress(const char
 		EXTENSION(glGetFramebufferAttachmentParameterivOES),
 		EXTENSION(glGenerateMipmapOES),
 		EXTENSION(glDrawBuffersEXT),
+		EXTENSION(glMaxShaderCompilerThreadsKHR),
 
 		#undef EXTENSION
 	};
@@ -24,6 +24,7 @@
 namespace sw
 {
 class FrameBuffer;
+class SharedBackBuffer;
 enum Format : unsigned char;
 }
 
@@ -241,10 +242,11 @@ public:
 	void (*glGetFramebufferAttachmentParameterivOES)(GLenum target, GLenum attachment, GLenum pname, GLint* params);
 	void (*glGenerateMipmapOES)(GLenum target);
 	void (*glDrawBuffersEXT)(GLsizei n, const GLenum *bufs);
+	void (*glMaxShaderCompilerThreadsKHR)(GLuint count);
 
 	egl::Context *(*es2CreateContext)(egl::Display *display, const egl::Context *shareContext, int clientVersion, const egl::Config *config);
 	__eglMustCastToProperFunctionPointerType (*es2GetProcAddress)(const char *procname);
-	egl::Image *(*createBackBuffer)(int width, int height, const egl::Config *config);
+	egl::Image *(*createBackBuffer)(int width, int height, const egl::Config *config, sw::SharedBackBuffer *sharedBuffer);
 	egl::Image *(*createDepthStencil)(unsigned int width, unsigned int height, sw::Format format, int multiSampleDepth, bool discard);
 	sw::FrameBuffer *(*createFrameBuffer)(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
 };
@@ -1606,6 +1606,12 @@ GL_APICALL void *GL_APIENTRY glMapBufferRange(GLenum target, GLintptr offset, GL
 			error(GL_INVALID_VALUE);
 		}
 
+		if((access & GL_MAP_READ_BIT) && (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT)))
+		{
+			// OpenGL ES 3.0.4 spec, section 2.10.3: reads can't be unsynchronized or invalidate the contents
+			return error(GL_INVALID_OPERATION, nullptr);
+		}
+
 		return buffer->mapRange(offset, length, access);
 	}
 
@@ -2664,6 +2670,7 @@ GL_APICALL void GL_APIENTRY glCopyBufferSubData(GLenum readTarget, GLenum writeT
 			return error(GL_INVALID_VALUE);
 		}
 
+		readBuffer->sync();
 		writeBuffer->bufferSubData(((char*)readBuffer->data()) + readOffset, size, writeOffset);
 	}
 }
@@ -3619,20 +3626,71 @@ GL_APICALL void GL_APIENTRY glGetProgramBinary(GLuint program, GLsizei bufSize,
 		return error(GL_INVALID_VALUE);
 	}
 
-	UNIMPLEMENTED();
+	es2::Context *context = es2::getContext();
+
+	if(context)
+	{
+		es2::Program *programObject = context->getProgram(program);
+
+		if(!programObject)
+		{
+			if(context->getShader(program))
+			{
+				return error(GL_INVALID_OPERATION);
+			}
+			else
+			{
+				return error(GL_INVALID_VALUE);
+			}
+		}
+
+		if(!programObject->isLinked())
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+
+		if(!programObject->getBinary(bufSize, length, binaryFormat, binary))
+		{
+			return error(GL_INVALID_OPERATION);
+		}
+	}
 }
 
 GL_APICALL void GL_APIENTRY glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length)
 {
 	TRACE("(GLuint program = %d, GLenum binaryFormat = 0x%X, const void *binary = %p, GLsizei length = %d)",
-	      program, binaryFormat, binaryFormat, length);
+	      program, binaryFormat, binary, length);
 
 	if(length < 0)
 	{
 		return error(GL_INVALID_VALUE);
 	}
 
-	UNIMPLEMENTED();
+	es2::Context *context = es2::getContext();
+
+	if(context)
+	{
+		es2::Program *programObject = context->getProgram(program);
+
+		if(!programObject)
+		{
+			if(context->getShader(program))
+			{
+				return error(GL_INVALID_OPERATION);
+			}
+			else
+			{
+				return error(GL_INVALID_VALUE);
+			}
+		}
+
+		if(binaryFormat != es2::PROGRAM_BINARY_FORMAT_SWIFTSHADER)
+		{
+			return error(GL_INVALID_ENUM);
+		}
+
+		programObject->setBinary(binary, length);
+	}
 }
 
 GL_APICALL void GL_APIENTRY glProgramParameteri(GLuint program, GLenum pname, GLint value)
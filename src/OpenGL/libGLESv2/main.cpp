@@ -351,6 +351,7 @@ GL_APICALL void FramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum
 GL_APICALL void GetFramebufferAttachmentParameterivOES(GLenum target, GLenum attachment, GLenum pname, GLint* params);
 GL_APICALL void GenerateMipmapOES(GLenum target);
 GL_APICALL void DrawBuffersEXT(GLsizei n, const GLenum *bufs);
+GL_APICALL void MaxShaderCompilerThreadsKHR(GLuint count);
 }
 
 extern "C"
@@ -1332,6 +1333,11 @@ GL_APICALL void GL_APIENTRY glDrawBuffersEXT(GLsizei n, const GLenum *bufs)
 	return es2::DrawBuffersEXT(n, bufs);
 }
 
+GL_APICALL void GL_APIENTRY glMaxShaderCompilerThreadsKHR(GLuint count)
+{
+	return es2::MaxShaderCompilerThreadsKHR(count);
+}
+
 void GL_APIENTRY Register(const char *licenseKey)
 {
 	// Nothing to do, SwiftShader is open-source
@@ -1340,7 +1346,7 @@ void GL_APIENTRY Register(const char *licenseKey)
 
 egl::Context *es2CreateContext(egl::Display *display, const egl::Context *shareContext, int clientVersion, const egl::Config *config);
 extern "C" __eglMustCastToProperFunctionPointerType es2GetProcAddress(const char *procname);
-egl::Image *createBackBuffer(int width, int height, const egl::Config *config);
+egl::Image *createBackBuffer(int width, int height, const egl::Config *config, sw::SharedBackBuffer *sharedBuffer);
 egl::Image *createDepthStencil(unsigned int width, unsigned int height, sw::Format format, int multiSampleDepth, bool discard);
 sw::FrameBuffer *createFrameBuffer(void *nativeDisplay, EGLNativeWindowType window, int width, int height);
 
@@ -1540,6 +1546,7 @@ LibGLESv2exports::LibGLESv2exports()
 	this->glGetFramebufferAttachmentParameterivOES = es2::GetFramebufferAttachmentParameterivOES;
 	this->glGenerateMipmapOES = es2::GenerateMipmapOES;
 	this->glDrawBuffersEXT = es2::DrawBuffersEXT;
+	this->glMaxShaderCompilerThreadsKHR = es2::MaxShaderCompilerThreadsKHR;
 
 	this->es2CreateContext = ::es2CreateContext;
 	this->es2GetProcAddress = ::es2GetProcAddress;
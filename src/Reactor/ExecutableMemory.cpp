@@ -0,0 +1,308 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ExecutableMemory.hpp"
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#if !defined(MAP_ANONYMOUS)
+		#define MAP_ANONYMOUS MAP_ANON
+	#endif
+#endif
+
+#include <map>
+#include <iterator>
+#include <vector>
+#include <mutex>
+#include <cassert>
+#include <stdint.h>
+
+namespace
+{
+	const size_t slabSize = 1024 * 1024;
+
+	struct Slab
+	{
+		uint8_t *base;
+		size_t size;
+		size_t used;
+
+		std::map<size_t, size_t> freeBlocks;   // Offset -> size, kept coalesced
+	};
+
+	std::mutex mutex;   // Protects all of the below
+	std::vector<Slab> &slabs = *new std::vector<Slab>();   // Never destroyed, since static routines may be freed after it
+	size_t usedBytes = 0;
+	size_t reservedBytes = 0;
+	size_t budgetBytes = 0;
+	int allocationCount = 0;
+
+	size_t pageSize()
+	{
+		static size_t size = 0;
+
+		if(size == 0)
+		{
+			#if defined(_WIN32)
+				SYSTEM_INFO systemInfo;
+				GetSystemInfo(&systemInfo);
+				size = systemInfo.dwPageSize;
+			#else
+				size = sysconf(_SC_PAGESIZE);
+			#endif
+		}
+
+		return size;
+	}
+
+	size_t roundToPages(size_t bytes)
+	{
+		size_t page = pageSize();
+
+		return (bytes + page - 1) & ~(page - 1);
+	}
+
+	uint8_t *reserve(size_t bytes)
+	{
+		#if defined(_WIN32)
+			return (uint8_t*)VirtualAlloc(NULL, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		#else
+			void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			return (memory == MAP_FAILED) ? nullptr : (uint8_t*)memory;
+		#endif
+	}
+
+	void release(uint8_t *memory, size_t bytes)
+	{
+		#if defined(_WIN32)
+			VirtualFree(memory, 0, MEM_RELEASE);
+		#else
+			munmap(memory, bytes);
+		#endif
+	}
+
+	void protect(void *memory, size_t bytes, bool executable)
+	{
+		#if defined(_WIN32)
+			DWORD oldProtection;
+			VirtualProtect(memory, bytes, executable ? PAGE_EXECUTE_READ : PAGE_READWRITE, &oldProtection);
+		#else
+			mprotect(memory, bytes, executable ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE));
+		#endif
+	}
+
+	void insertFreeBlock(Slab &slab, size_t offset, size_t size)
+	{
+		auto next = slab.freeBlocks.lower_bound(offset);
+
+		if(next != slab.freeBlocks.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = slab.freeBlocks.erase(next);
+		}
+
+		if(next != slab.freeBlocks.begin())
+		{
+			auto previous = std::prev(next);
+
+			if(previous->first + previous->second == offset)
+			{
+				previous->second += size;
+				return;
+			}
+		}
+
+		slab.freeBlocks[offset] = size;
+	}
+
+	// Must be called with the mutex held
+	void freeBlock(uint8_t *memory, size_t size)
+	{
+		protect(memory, size, false);
+
+		for(Slab &slab : slabs)
+		{
+			if(memory >= slab.base && memory < slab.base + slab.size)
+			{
+				size_t offset = memory - slab.base;
+				assert(offset + size <= slab.size);
+
+				insertFreeBlock(slab, offset, size);
+				slab.used -= size;
+				usedBytes -= size;
+
+				return;
+			}
+		}
+
+		assert(false && "Not allocated from the executable memory pool");
+	}
+
+	// Releases empty slabs to the OS, keeping one around to avoid thrashing
+	void compact()
+	{
+		bool keepOne = true;
+
+		for(size_t i = slabs.size(); i-- > 0;)
+		{
+			if(slabs[i].used == 0)
+			{
+				if(keepOne && slabs[i].size == slabSize)
+				{
+					keepOne = false;
+					continue;
+				}
+
+				release(slabs[i].base, slabs[i].size);
+				reservedBytes -= slabs[i].size;
+				slabs.erase(slabs.begin() + i);
+			}
+		}
+	}
+}
+
+namespace sw
+{
+	void *allocateExecutableMemory(size_t bytes)
+	{
+		size_t size = roundToPages(bytes);
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for(Slab &slab : slabs)
+		{
+			for(auto block = slab.freeBlocks.begin(); block != slab.freeBlocks.end(); block++)
+			{
+				if(block->second >= size)   // First fit
+				{
+					size_t offset = block->first;
+					size_t remaining = block->second - size;
+
+					slab.freeBlocks.erase(block);
+
+					if(remaining > 0)
+					{
+						slab.freeBlocks[offset + size] = remaining;
+					}
+
+					slab.used += size;
+					usedBytes += size;
+					allocationCount++;
+
+					return slab.base + offset;
+				}
+			}
+		}
+
+		Slab slab;
+		slab.size = (size > slabSize) ? size : slabSize;
+		slab.base = reserve(slab.size);
+		slab.used = size;
+
+		if(!slab.base)
+		{
+			return nullptr;
+		}
+
+		if(slab.size > size)
+		{
+			slab.freeBlocks[size] = slab.size - size;
+		}
+
+		slabs.push_back(slab);
+		reservedBytes += slab.size;
+		usedBytes += size;
+		allocationCount++;
+
+		return slab.base;
+	}
+
+	void markExecutableMemory(void *memory, size_t bytes)
+	{
+		protect(memory, roundToPages(bytes), true);
+
+		#if defined(_WIN32)
+			FlushInstructionCache(GetCurrentProcess(), memory, bytes);
+		#else
+			__builtin___clear_cache((char*)memory, (char*)memory + bytes);
+		#endif
+	}
+
+	void deallocateExecutableMemory(void *memory, size_t bytes)
+	{
+		if(!memory)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		freeBlock((uint8_t*)memory, roundToPages(bytes));
+		allocationCount--;
+
+		compact();
+	}
+
+	void shrinkExecutableMemory(void *memory, size_t bytes, size_t newBytes)
+	{
+		size_t size = roundToPages(bytes);
+		size_t newSize = roundToPages(newBytes);
+
+		if(!memory || newSize == 0 || newSize >= size)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		freeBlock((uint8_t*)memory + newSize, size - newSize);
+	}
+
+	ExecutableMemoryStatistics getExecutableMemoryStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		ExecutableMemoryStatistics statistics;
+		statistics.used = usedBytes;
+		statistics.reserved = reservedBytes;
+		statistics.budget = budgetBytes;
+		statistics.allocations = allocationCount;
+		statistics.slabs = (int)slabs.size();
+
+		return statistics;
+	}
+
+	void setExecutableMemoryBudget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		budgetBytes = bytes;
+	}
+
+	bool executableMemoryBudgetExceeded()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		return budgetBytes != 0 && usedBytes > budgetBytes;
+	}
+}
@@ -0,0 +1,47 @@
+// Copyright 2026 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_ExecutableMemory_hpp
+#define sw_ExecutableMemory_hpp
+
+#include <stddef.h>
+
+namespace sw
+{
+	// Routines are packed into large slabs reserved from the OS, instead of each
+	// getting its own allocation. Blocks are page aligned and page granular, so the
+	// code of one routine can be made executable (and no longer writable) without
+	// affecting routines which are still being generated in the same slab.
+	void *allocateExecutableMemory(size_t bytes);   // Writable until markExecutableMemory() is called
+	void markExecutableMemory(void *memory, size_t bytes);
+	void deallocateExecutableMemory(void *memory, size_t bytes);
+	void shrinkExecutableMemory(void *memory, size_t bytes, size_t newBytes);   // Returns the unused tail to the pool
+
+	struct ExecutableMemoryStatistics
+	{
+		size_t used;       // Bytes currently allocated to routines
+		size_t reserved;   // Bytes reserved from the OS for slabs
+		size_t budget;     // 0 means unlimited
+		int allocations;
+		int slabs;
+	};
+
+	ExecutableMemoryStatistics getExecutableMemoryStatistics();
+
+	// Routine caches evict their least recently used entries while the budget is exceeded
+	void setExecutableMemoryBudget(size_t bytes);
+	bool executableMemoryBudgetExceeded();
+}
+
+#endif   // sw_ExecutableMemory_hpp
@@ -14,15 +14,14 @@
 
 #include "LLVMRoutine.hpp"
 
-#include "../Common/Memory.hpp"
-#include "../Common/Thread.hpp"
+#include "ExecutableMemory.hpp"
 #include "../Common/Types.hpp"
 
 namespace sw
 {
 	LLVMRoutine::LLVMRoutine(int bufferSize) : bufferSize(bufferSize)
 	{
-		void *memory = allocateExecutable(bufferSize);
+		void *memory = allocateExecutableMemory(bufferSize);
 
 		buffer = memory;
 		entry = memory;
@@ -31,7 +30,7 @@ namespace sw
 
 	LLVMRoutine::~LLVMRoutine()
 	{
-		deallocateExecutable(buffer, bufferSize);
+		deallocateExecutableMemory(buffer, bufferSize);
 	}
 
 	const void *LLVMRoutine::getEntry()
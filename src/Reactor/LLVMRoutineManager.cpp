@@ -15,6 +15,7 @@
 #include "LLVMRoutineManager.hpp"
 
 #include "LLVMRoutine.hpp"
+#include "ExecutableMemory.hpp"
 #include "llvm/Function.h"
 #include "../Common/Memory.hpp"
 #include "../Common/Thread.hpp"
@@ -77,6 +78,16 @@ namespace sw
 	void LLVMRoutineManager::endFunctionBody(const llvm::Function *function, uint8_t *functionStart, uint8_t *functionEnd)
 	{
 		routine->functionSize = static_cast<int>(static_cast<ptrdiff_t>(functionEnd - functionStart));
+
+		// Return the pages beyond the estimated size to the executable memory pool
+		size_t pageSize = memoryPageSize();
+		int usedSize = static_cast<int>((routine->functionSize + pageSize - 1) & ~(pageSize - 1));
+
+		if(usedSize < routine->bufferSize)
+		{
+			shrinkExecutableMemory(routine->buffer, routine->bufferSize, usedSize);
+			routine->bufferSize = usedSize;
+		}
 	}
 
 	uint8_t *LLVMRoutineManager::startExceptionTable(const llvm::Function* F, uintptr_t &ActualSize)
@@ -128,7 +139,7 @@ namespace sw
 
 	void LLVMRoutineManager::setMemoryExecutable()
 	{
-		markExecutable(routine->buffer, routine->bufferSize);
+		markExecutableMemory(routine->buffer, routine->bufferSize);
 	}
 
 	void LLVMRoutineManager::setPoisonMemory(bool poison)
@@ -18,6 +18,7 @@
 #include "Routine.hpp"
 
 #include "Optimizer.hpp"
+#include "ExecutableMemory.hpp"
 
 #include "src/IceTypes.h"
 #include "src/IceCfg.h"
@@ -421,20 +422,12 @@ namespace sw
 
 		T *allocate(size_type n)
 		{
-			#if defined(_WIN32)
-				return (T*)VirtualAlloc(NULL, sizeof(T) * n, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-			#else
-				return (T*)mmap(nullptr, sizeof(T) * n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-			#endif
+			return (T*)sw::allocateExecutableMemory(sizeof(T) * n);
 		}
 
 		void deallocate(T *p, size_type n)
 		{
-			#if defined(_WIN32)
-				VirtualFree(p, 0, MEM_RELEASE);
-			#else
-				munmap(p, sizeof(T) * n);
-			#endif
+			sw::deallocateExecutableMemory(p, sizeof(T) * n);
 		}
 	};
 
@@ -452,13 +445,6 @@ namespace sw
 
 		virtual ~ELFMemoryStreamer()
 		{
-			#if defined(_WIN32)
-				if(buffer.size() != 0)
-				{
-					DWORD exeProtection;
-					VirtualProtect(&buffer[0], buffer.size(), oldProtection, &exeProtection);
-				}
-			#endif
 		}
 
 		void write8(uint8_t Value) override
@@ -497,13 +483,7 @@ namespace sw
 				size_t codeSize = 0;
 				entry = loadImage(&buffer[0], codeSize);
 
-				#if defined(_WIN32)
-					VirtualProtect(&buffer[0], buffer.size(), PAGE_EXECUTE_READ, &oldProtection);
-					FlushInstructionCache(GetCurrentProcess(), NULL, 0);
-				#else
-					mprotect(&buffer[0], buffer.size(), PROT_READ | PROT_EXEC);
-					__builtin___clear_cache((char*)entry, (char*)entry + codeSize);
-				#endif
+				sw::markExecutableMemory(&buffer[0], buffer.size());
 			}
 
 			return entry;
@@ -513,10 +493,6 @@ namespace sw
 		void *entry;
 		std::vector<uint8_t, ExecutableAllocator<uint8_t>> buffer;
 		std::size_t position;
-
-		#if defined(_WIN32)
-		DWORD oldProtection;
-		#endif
 	};
 
 	Nucleus::Nucleus()
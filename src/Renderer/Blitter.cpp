@@ -17,6 +17,7 @@
 #include "Reactor/Reactor.hpp"
 #include "Common/Memory.hpp"
 #include "Common/Debug.hpp"
+#include "Common/Trace.hpp"
 
 namespace sw
 {
@@ -34,6 +35,8 @@ namespace sw
 
 	void Blitter::clear(void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
 	{
+		TraceScope trace("Clear");
+
 		if(fastClear(pixel, format, dest, dRect, rgbaMask))
 		{
 			return;
@@ -47,7 +50,7 @@ namespace sw
 		delete color;
 	}
 
-	bool Blitter::fastClear(void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
+	bool Blitter::packClearColor(uint32_t &packed, void* pixel, sw::Format format, sw::Format destFormat, unsigned int rgbaMask)
 	{
 		if(format != FORMAT_A32B32G32R32F)
 		{
@@ -60,9 +63,7 @@ namespace sw
 		float b = color[2];
 		float a = color[3];
 
-		uint32_t packed;
-
-		switch(dest->getFormat())
+		switch(destFormat)
 		{
 		case FORMAT_R5G6B5:
 			if((rgbaMask & 0x7) != 0x7) return false;
@@ -102,6 +103,18 @@ namespace sw
 			return false;
 		}
 
+		return true;
+	}
+
+	bool Blitter::fastClear(void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
+	{
+		uint32_t packed;
+
+		if(!packClearColor(packed, pixel, format, dest->getFormat(), rgbaMask))
+		{
+			return false;
+		}
+
 		uint8_t *d = (uint8_t*)dest->lockInternal(dRect.x0, dRect.y0, dRect.slice, sw::LOCK_WRITEONLY, sw::PUBLIC);
 
 		switch(Surface::bytes(dest->getFormat()))
@@ -145,6 +158,10 @@ namespace sw
 
 	void Blitter::blit(Surface *source, const SliceRect &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options& options)
 	{
+		TraceScope trace("Blit");
+		ProfilerTimer timer(&profiler.blitTime);
+		atomicAdd(&profiler.blits, (int64_t)1);
+
 		if(dest->getInternalFormat() == FORMAT_NULL)
 		{
 			return;
@@ -202,6 +219,10 @@ namespace sw
 
 	void Blitter::blit3D(Surface *source, Surface *dest)
 	{
+		TraceScope trace("Blit 3D");
+		ProfilerTimer timer(&profiler.blitTime);
+		atomicAdd(&profiler.blits, (int64_t)1);
+
 		source->lockInternal(0, 0, 0, sw::LOCK_READONLY, sw::PUBLIC);
 		dest->lockInternal(0, 0, 0, sw::LOCK_WRITEONLY, sw::PUBLIC);
 
@@ -1308,6 +1329,119 @@ namespace sw
 	}
 
 	bool Blitter::blitReactor(Surface *source, const SliceRect &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options& options)
+	{
+		Operation operation;
+
+		if(!prepare(operation, source, sourceRect, dest, destRect, options, sw::PUBLIC))
+		{
+			return false;
+		}
+
+		execute(operation, 0, 1);
+		finish(operation);
+
+		return true;
+	}
+
+	bool Blitter::prepareClear(Operation &operation, void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
+	{
+		if(dest->getInternalFormat() == FORMAT_NULL || dest->isExternalDirty())
+		{
+			return false;
+		}
+
+		if(packClearColor(operation.packed, pixel, format, dest->getInternalFormat(), rgbaMask))
+		{
+			operation.routine = nullptr;
+			operation.source = nullptr;
+			operation.dest = dest;
+			operation.isStencil = false;
+			operation.useSourceInternal = false;
+			operation.useDestInternal = true;
+			operation.ownsSource = false;
+			operation.ownsDest = false;
+
+			BlitData &data = operation.data;
+			data.dest = dest->lockInternal(0, 0, dRect.slice, sw::LOCK_WRITEONLY, sw::MANAGED);
+			data.dPitchB = dest->getInternalPitchB();
+			data.x0d = dRect.x0;
+			data.x1d = dRect.x1;
+			data.y0d = dRect.y0;
+			data.y1d = dRect.y1;
+
+			return true;
+		}
+
+		int bytes = sw::Surface::bytes(format);
+		ASSERT(bytes <= (int)sizeof(operation.color));
+		memcpy(operation.color, pixel, bytes);
+
+		sw::Surface *color = sw::Surface::create(1, 1, 1, format, operation.color, bytes, bytes);
+		Blitter::Options clearOptions = static_cast<sw::Blitter::Options>((rgbaMask & 0xF) | CLEAR_OPERATION);
+		SliceRect sRect(dRect);
+		sRect.slice = 0;
+
+		if(!prepare(operation, color, sRect, dest, dRect, clearOptions, sw::MANAGED))
+		{
+			delete color;
+			return false;
+		}
+
+		operation.ownsSource = true;
+		atomicAdd(&profiler.blits, (int64_t)1);
+
+		return true;
+	}
+
+	bool Blitter::prepareBlit(Operation &operation, Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil)
+	{
+		// Multisampled sources are resolved when locked by the application, so can't be deferred
+		if(dest->getInternalFormat() == FORMAT_NULL || source->getMultiSampleCount() > 1 ||
+		   source->isExternalDirty() || dest->isExternalDirty())
+		{
+			return false;
+		}
+
+		Blitter::Options options = WRITE_RGBA;
+		if(filter)
+		{
+			options = static_cast<Blitter::Options>(options | FILTER_LINEAR);
+		}
+		if(isStencil)
+		{
+			options = static_cast<Blitter::Options>(options | USE_STENCIL);
+		}
+
+		if(!prepare(operation, source, sRect, dest, dRect, options, sw::MANAGED))
+		{
+			return false;
+		}
+
+		atomicAdd(&profiler.blits, (int64_t)1);
+
+		return true;
+	}
+
+	bool Blitter::prepareReadback(Operation &operation, Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect)
+	{
+		// The destination only wraps client memory, so its external buffer is written directly
+		if(source->getMultiSampleCount() > 1 || source->isExternalDirty())
+		{
+			return false;
+		}
+
+		if(!prepare(operation, source, sRect, dest, dRect, WRITE_RGBA, sw::MANAGED))
+		{
+			return false;
+		}
+
+		operation.ownsDest = true;
+		atomicAdd(&profiler.blits, (int64_t)1);
+
+		return true;
+	}
+
+	bool Blitter::prepare(Operation &operation, Surface *source, const SliceRect &sourceRect, Surface *dest, const SliceRect &destRect, const Blitter::Options& options, Accessor client)
 	{
 		ASSERT(!(options & CLEAR_OPERATION) || ((source->getWidth() == 1) && (source->getHeight() == 1) && (source->getDepth() == 1)));
 
@@ -1334,35 +1468,30 @@ namespace sw
 		state.destFormat = isStencil ? dest->getStencilFormat() : dest->getFormat(useDestInternal);
 		state.options = options;
 
-		criticalSection.lock();
-		Routine *blitRoutine = blitCache->query(state);
+		operation.routine = getRoutine(state);
 
-		if(!blitRoutine)
+		if(!operation.routine)
 		{
-			blitRoutine = generate(state);
-
-			if(!blitRoutine)
-			{
-				criticalSection.unlock();
-				return false;
-			}
-
-			blitCache->add(state, blitRoutine);
+			return false;
 		}
 
-		criticalSection.unlock();
+		operation.source = source;
+		operation.dest = dest;
+		operation.isStencil = isStencil;
+		operation.useSourceInternal = useSourceInternal;
+		operation.useDestInternal = useDestInternal;
+		operation.ownsSource = false;
+		operation.ownsDest = false;
 
-		void (*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))blitRoutine->getEntry();
-
-		BlitData data;
+		BlitData &data = operation.data;
 
 		bool isRGBA = ((options & WRITE_RGBA) == WRITE_RGBA);
 		bool isEntireDest = dest->isEntire(destRect);
 
-		data.source = isStencil ? source->lockStencil(0, 0, 0, sw::PUBLIC) :
-		                          source->lock(0, 0, sourceRect.slice, sw::LOCK_READONLY, sw::PUBLIC, useSourceInternal);
-		data.dest = isStencil ? dest->lockStencil(0, 0, 0, sw::PUBLIC) :
-		                        dest->lock(0, 0, destRect.slice, isRGBA ? (isEntireDest ? sw::LOCK_DISCARD : sw::LOCK_WRITEONLY) : sw::LOCK_READWRITE, sw::PUBLIC, useDestInternal);
+		data.source = isStencil ? source->lockStencil(0, 0, 0, client) :
+		                          source->lock(0, 0, sourceRect.slice, sw::LOCK_READONLY, client, useSourceInternal);
+		data.dest = isStencil ? dest->lockStencil(0, 0, 0, client) :
+		                        dest->lock(0, 0, destRect.slice, isRGBA ? (isEntireDest ? sw::LOCK_DISCARD : sw::LOCK_WRITEONLY) : sw::LOCK_READWRITE, client, useDestInternal);
 		data.sPitchB = isStencil ? source->getStencilPitchB() : source->getPitchB(useSourceInternal);
 		data.dPitchB = isStencil ? dest->getStencilPitchB() : dest->getPitchB(useDestInternal);
 
@@ -1379,19 +1508,107 @@ namespace sw
 		data.sWidth = source->getWidth();
 		data.sHeight = source->getHeight();
 
-		blitFunction(&data);
+		return true;
+	}
 
-		if(isStencil)
+	Routine *Blitter::getRoutine(BlitState &state)
+	{
+		criticalSection.lock();
+		Routine *blitRoutine = blitCache->query(state);
+
+		if(!blitRoutine)
 		{
-			source->unlockStencil();
-			dest->unlockStencil();
+			int64_t startTime = Timer::counter();
+			blitRoutine = generate(state);
+
+			if(!blitRoutine)
+			{
+				criticalSection.unlock();
+				return nullptr;
+			}
+
+			blitCache->add(state, blitRoutine);
+			profiler.routineCompiled(ROUTINE_BLIT, Timer::counter() - startTime);
 		}
 		else
 		{
-			source->unlock(useSourceInternal);
-			dest->unlock(useDestInternal);
+			atomicAdd(&profiler.routineHits[ROUTINE_BLIT], (int64_t)1);
 		}
 
-		return true;
+		blitRoutine->bind();   // Keep alive in case it gets evicted by another thread
+		criticalSection.unlock();
+
+		return blitRoutine;
+	}
+
+	void Blitter::execute(const Operation &operation, int band, int bandCount)
+	{
+		BlitData data = operation.data;
+
+		int rows = operation.rows();
+		data.y0d = operation.data.y0d + rows * band / bandCount;
+		data.y1d = operation.data.y0d + rows * (band + 1) / bandCount;
+
+		if(operation.routine)
+		{
+			// Step to the band's first row the same way the routine does, so results don't depend on the banding
+			for(int j = operation.data.y0d; j < data.y0d; j++)
+			{
+				data.y0 += data.h;
+			}
+			void (*blitFunction)(const BlitData *data) = (void(*)(const BlitData*))operation.routine->getEntry();
+
+			blitFunction(&data);
+		}
+		else   // Packed clear color
+		{
+			int bytes = Surface::bytes(operation.dest->getInternalFormat());
+			uint8_t *d = (uint8_t*)data.dest + data.y0d * data.dPitchB + data.x0d * bytes;
+
+			for(int i = data.y0d; i < data.y1d; i++)
+			{
+				switch(bytes)
+				{
+				case 2: sw::clear((uint16_t*)d, operation.packed, data.x1d - data.x0d); break;
+				case 4: sw::clear((uint32_t*)d, operation.packed, data.x1d - data.x0d); break;
+				default: ASSERT(false);
+				}
+
+				d += data.dPitchB;
+			}
+		}
+	}
+
+	void Blitter::finish(Operation &operation)
+	{
+		if(operation.routine)
+		{
+			operation.routine->unbind();
+		}
+
+		if(operation.isStencil)
+		{
+			operation.source->unlockStencil();
+			operation.dest->unlockStencil();
+		}
+		else
+		{
+			if(operation.source)
+			{
+				operation.source->unlock(operation.useSourceInternal);
+			}
+
+			operation.dest->unlock(operation.useDestInternal);
+		}
+
+		if(operation.ownsSource)
+		{
+			delete operation.source;
+		}
+
+		if(operation.ownsDest)
+		{
+			delete operation.dest;
+		}
 	}
 }
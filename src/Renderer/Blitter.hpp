@@ -72,6 +72,24 @@ namespace sw
 		};
 
 	public:
+		// A blit or clear whose surfaces are locked by the renderer, executed in row bands
+		struct Operation
+		{
+			int rows() const { return data.y1d - data.y0d; }
+
+			Routine *routine;   // Null when filling with a packed clear color
+			BlitData data;
+			Surface *source;
+			Surface *dest;
+			bool isStencil;
+			bool useSourceInternal;
+			bool useDestInternal;
+			bool ownsSource;   // Temporary surface holding the clear color
+			bool ownsDest;     // Temporary surface wrapping client memory
+			unsigned char color[16];
+			uint32_t packed;
+		};
+
 		Blitter();
 
 		virtual ~Blitter();
@@ -80,8 +98,16 @@ namespace sw
 		void blit(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil = false);
 		void blit3D(Surface *source, Surface *dest);
 
+		// Deferred execution. Returns false when the operation has to be performed synchronously.
+		bool prepareClear(Operation &operation, void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
+		bool prepareBlit(Operation &operation, Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil);
+		bool prepareReadback(Operation &operation, Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect);   // Takes ownership of dest on success
+		void execute(const Operation &operation, int band, int bandCount);
+		void finish(Operation &operation);
+
 	private:
 		bool fastClear(void* pixel, sw::Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
+		static bool packClearColor(uint32_t &packed, void* pixel, sw::Format format, sw::Format destFormat, unsigned int rgbaMask);
 
 		bool read(Float4 &color, Pointer<Byte> element, Format format);
 		bool write(Float4 &color, Pointer<Byte> element, Format format, const Blitter::Options& options);
@@ -92,6 +118,8 @@ namespace sw
 		static Int ComputeOffset(Int& x, Int& y, Int& pitchB, int bytes, bool quadLayout);
 		void blit(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, const Blitter::Options& options);
 		bool blitReactor(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, const Blitter::Options& options);
+		bool prepare(Operation &operation, Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, const Blitter::Options& options, Accessor client);
+		Routine *getRoutine(BlitState &state);
 		Routine *generate(BlitState &state);
 
 		RoutineCache<BlitState> *blitCache;
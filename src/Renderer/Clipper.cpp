@@ -17,6 +17,7 @@
 #include "Polygon.hpp"
 #include "Renderer.hpp"
 #include "Debug.hpp"
+#include "Thread.hpp"
 
 namespace sw
 {
@@ -42,6 +43,11 @@ namespace sw
 
 	bool Clipper::clip(Polygon &polygon, int clipFlagsOr, const DrawCall &draw)
 	{
+		if(draw.profile)
+		{
+			atomicAdd(&draw.data->counters[PERF_CLIPPED], (int64_t)1);
+		}
+
 		if(clipFlagsOr & CLIP_FRUSTUM)
 		{
 			if(clipFlagsOr & CLIP_NEAR)   clipNear(polygon);
@@ -39,6 +39,7 @@ namespace sw
 
 			CLIP_FRUSTUM = 0x003F,
 
+			CLIP_GUARD = 1 << 6,    // Outside the guard band, so the sides of the frustum can't be left to scissoring
 			CLIP_FINITE = 1 << 7,   // All position coordinates are finite
 
 			// User-defined clipping planes
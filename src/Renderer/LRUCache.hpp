@@ -29,6 +29,7 @@ namespace sw
 
 		Data *query(const Key &key) const;
 		Data *add(const Key &key, Data *data);
+		bool evict();   // Removes the least recently used entry, but never the most recent one
 	
 		int getSize() {return size;}
 		Key &getKey(int i) {return key[i];}
@@ -140,6 +141,27 @@ namespace sw
 
 		return data;
 	}
+
+	template<class Key, class Data>
+	bool LRUCache<Key, Data>::evict()
+	{
+		if(fill <= 1)
+		{
+			return false;
+		}
+
+		int j = (top - fill + 1) & mask;
+
+		if(data[j])
+		{
+			data[j]->unbind();
+			data[j] = 0;
+		}
+
+		fill--;
+
+		return true;
+	}
 }
 
 #endif   // sw_LRUCache_hpp
@@ -21,6 +21,7 @@
 #include "Primitive.hpp"
 #include "Constants.hpp"
 #include "Debug.hpp"
+#include "Trace.hpp"
 
 #include <string.h>
 
@@ -929,6 +930,7 @@ namespace sw
 		if(context->pixelShader)
 		{
 			state.shaderID = context->pixelShader->getSerialID();
+			context->pixelShader->specialize(state.specialization, c, i, b);
 		}
 		else
 		{
@@ -937,6 +939,7 @@ namespace sw
 
 		state.depthOverride = context->pixelShader && context->pixelShader->depthOverride();
 		state.shaderContainsKill = context->pixelShader ? context->pixelShader->containsKill() : false;
+		state.profile = profiler.enabled;
 
 		if(context->alphaTestActive())
 		{
@@ -1154,6 +1157,9 @@ namespace sw
 
 		if(!routine)
 		{
+			TraceScope trace("Compile pixel routine");
+			int64_t startTime = Timer::counter();
+
 			const bool integerPipeline = (context->pixelShaderVersion() <= 0x0104);
 			QuadRasterizer *generator = nullptr;
 
@@ -1171,6 +1177,11 @@ namespace sw
 			delete generator;
 
 			routineCache->add(state, routine);
+			profiler.routineCompiled(ROUTINE_PIXEL, Timer::counter() - startTime);
+		}
+		else
+		{
+			atomicAdd(&profiler.routineHits[ROUTINE_PIXEL], (int64_t)1);
 		}
 
 		return routine;
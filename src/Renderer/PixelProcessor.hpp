@@ -17,6 +17,7 @@
 
 #include "Context.hpp"
 #include "RoutineCache.hpp"
+#include "Shader/Shader.hpp"
 
 namespace sw
 {
@@ -33,9 +34,11 @@ namespace sw
 			unsigned int computeHash();
 
 			int shaderID;
+			Shader::Specialization specialization;
 
 			bool depthOverride                        : 1;
 			bool shaderContainsKill                   : 1;
+			bool profile                              : 1;   // Measures time and counts operations
 
 			DepthCompareMode depthCompareMode         : BITS(DEPTH_LAST);
 			AlphaCompareMode alphaCompareMode         : BITS(ALPHA_LAST);
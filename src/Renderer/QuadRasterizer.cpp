@@ -23,7 +23,6 @@
 namespace sw
 {
 	extern bool veryEarlyDepthTest;
-	extern bool complementaryDepthBuffer;
 	extern bool fullPixelPositionRegister;
 
 	extern int clusterCount;
@@ -38,14 +37,18 @@ namespace sw
 
 	void QuadRasterizer::generate()
 	{
-		#if PERF_PROFILE
+		Long pixelTime;
+
+		if(state.profile)
+		{
 			for(int i = 0; i < PERF_TIMERS; i++)
 			{
 				cycles[i] = 0;
 			}
 
-			Long pixelTime = Ticks();
-		#endif
+			quads = 0;
+			pixelTime = Ticks();
+		}
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 		occlusion = 0;
@@ -77,18 +80,29 @@ namespace sw
 			*Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster) = clusterOcclusion;
 		}
 
-		#if PERF_PROFILE
+		if(state.profile)
+		{
 			cycles[PERF_PIXEL] = Ticks() - pixelTime;
 
 			for(int i = 0; i < PERF_TIMERS; i++)
 			{
 				*Pointer<Long>(data + OFFSET(DrawData,cycles[i]) + 8 * cluster) += cycles[i];
 			}
-		#endif
+
+			addCounter(PERF_QUADS, quads);
+		}
 
 		Return();
 	}
 
+	void QuadRasterizer::addCounter(int counter, RValue<Int> n)
+	{
+		if(state.profile)
+		{
+			AddAtomic(Pointer<Long>(data + OFFSET(DrawData,counters) + 8 * counter), Long(n));
+		}
+	}
+
 	void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 	{
 		Pointer<Byte> cBuffer[RENDERTARGETS];
@@ -158,80 +172,33 @@ namespace sw
 				}
 			}
 
-			if(veryEarlyDepthTest && state.multiSample == 1)
+			if(earlyDepthRejection() || earlyStencilRejection())
 			{
-				if(!state.stencilActive && state.depthTestActive && (state.depthCompareMode == DEPTH_LESSEQUAL || state.depthCompareMode == DEPTH_LESS))   // FIXME: Both modes ok?
-				{
-					Float4 xxxx = Float4(Float(x0)) + *Pointer<Float4>(primitive + OFFSET(Primitive,xQuad), 16);
+				// Skip leading quads of the span which are hidden for all samples
+				Float4 xxxx = Float4(Float(x0)) + *Pointer<Float4>(primitive + OFFSET(Primitive,xQuad), 16);
 
-					Pointer<Byte> buffer;
-					Int pitch;
-
-					if(!state.quadLayoutDepthBuffer)
+				For(Int x = x0, x < x1, x += 2)
+				{
+					If(occluded(zBuffer, sBuffer, x, xxxx))
 					{
-						buffer = zBuffer + 4 * x0;
-						pitch = *Pointer<Int>(data + OFFSET(DrawData,depthPitchB));
+						x0 += 2;
 					}
-					else
+					Else
 					{
-						buffer = zBuffer + 8 * x0;
+						x = x1;
 					}
 
-					For(Int x = x0, x < x1, x += 2)
-					{
-						Float4 z = interpolate(xxxx, Dz[0], z, primitive + OFFSET(Primitive,z), false, false);
-
-						Float4 zValue;
-
-						if(!state.quadLayoutDepthBuffer)
-						{
-							// FIXME: Properly optimizes?
-							zValue.xy = *Pointer<Float4>(buffer);
-							zValue.zw = *Pointer<Float4>(buffer + pitch - 8);
-						}
-						else
-						{
-							zValue = *Pointer<Float4>(buffer, 16);
-						}
-
-						Int4 zTest;
-
-						if(complementaryDepthBuffer)
-						{
-							zTest = CmpLE(zValue, z);
-						}
-						else
-						{
-							zTest = CmpNLT(zValue, z);
-						}
-
-						Int zMask = SignMask(zTest);
-
-						If(zMask == 0)
-						{
-							x0 += 2;
-						}
-						Else
-						{
-							x = x1;
-						}
-
-						xxxx += Float4(2);
-
-						if(!state.quadLayoutDepthBuffer)
-						{
-							buffer += 8;
-						}
-						else
-						{
-							buffer += 16;
-						}
-					}
+					xxxx += Float4(2);
 				}
 			}
 
 			If(x0 < x1)
 			{
+				if(state.profile)
+				{
+					quads += (x1 - x0 + 1) >> 1;
+				}
+
 				if(interpolateW())
 				{
 					Dw = *Pointer<Float4>(primitive + OFFSET(Primitive,w.C), 16) + yyyy * *Pointer<Float4>(primitive + OFFSET(Primitive,w.B), 16);
@@ -339,4 +306,30 @@ namespace sw
 	{
 		return state.perspective || (shader && shader->isVPosDeclared() && fullPixelPositionRegister);
 	}
+
+	bool QuadRasterizer::earlyStencilRejection() const
+	{
+		// Pixels failing the stencil test must leave the stencil buffer unchanged
+		return veryEarlyDepthTest && state.stencilActive &&
+		       (state.stencilFailOperation == OPERATION_KEEP || state.stencilWriteMasked) &&
+		       (state.stencilFailOperationCCW == OPERATION_KEEP || state.stencilWriteMaskedCCW);
+	}
+
+	bool QuadRasterizer::earlyDepthRejection() const
+	{
+		if(!veryEarlyDepthTest || !state.depthTestActive || state.depthOverride)
+		{
+			return false;
+		}
+
+		if(state.stencilActive)
+		{
+			// Pixels failing either test must leave the stencil buffer unchanged
+			return earlyStencilRejection() &&
+			       (state.stencilZFailOperation == OPERATION_KEEP || state.stencilWriteMasked) &&
+			       (state.stencilZFailOperationCCW == OPERATION_KEEP || state.stencilWriteMaskedCCW);
+		}
+
+		return true;
+	}
 }
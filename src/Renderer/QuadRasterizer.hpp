@@ -41,14 +41,18 @@ namespace sw
 
 		UInt occlusion;
 
-#if PERF_PROFILE
-		Long cycles[PERF_TIMERS];
-#endif
+		Long cycles[PERF_TIMERS];   // Only used when profiling
+		Int quads;
+
+		void addCounter(int counter, RValue<Int> n);   // Adds to the draw's counter when profiling
 
 		virtual void quad(Pointer<Byte> cBuffer[4], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x, Int &y) = 0;
+		virtual Bool occluded(Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int &x, Float4 &xxxx) = 0;   // No sample of the quad passes the enabled early tests
 
 		bool interpolateZ() const;
 		bool interpolateW() const;
+		bool earlyDepthRejection() const;     // Quads failing the depth test can be skipped
+		bool earlyStencilRejection() const;   // Quads failing the stencil test can be skipped
 		Float4 interpolate(Float4 &x, Float4 &D, Float4 &rhw, Pointer<Byte> planeEquation, bool flat, bool perspective);
 
 		const PixelProcessor::State &state;
@@ -18,6 +18,7 @@
 #include "Math.hpp"
 #include "FrameBuffer.hpp"
 #include "Timer.hpp"
+#include "Trace.hpp"
 #include "Surface.hpp"
 #include "Half.hpp"
 #include "Primitive.hpp"
@@ -30,6 +31,14 @@
 #include "Constants.hpp"
 #include "Debug.hpp"
 #include "Reactor/Reactor.hpp"
+#include "Reactor/ExecutableMemory.hpp"
+
+#include <stdio.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+	#include <xmmintrin.h>
+	#include <emmintrin.h>
+#endif
 
 #undef max
 
@@ -80,14 +89,12 @@ namespace sw
 	DrawCall::DrawCall()
 	{
 		queries = 0;
+		fences = 0;
+		blit = false;
+		pixelBuffer = nullptr;
 
-		vsDirtyConstF = VERTEX_UNIFORM_VECTORS + 1;
-		vsDirtyConstI = 16;
-		vsDirtyConstB = 16;
-
-		psDirtyConstF = FRAGMENT_UNIFORM_VECTORS;
-		psDirtyConstI = 16;
-		psDirtyConstB = 16;
+		vsConstantSerial = 0;
+		psConstantSerial = 0;
 
 		references = -1;
 
@@ -98,6 +105,7 @@ namespace sw
 	DrawCall::~DrawCall()
 	{
 		delete queries;
+		delete fences;
 
 		deallocate(data);
 	}
@@ -120,9 +128,7 @@ namespace sw
 		updateProjectionMatrix = true;
 		updateClipPlanes = true;
 
-		#if PERF_HUD
-			resetTimers();
-		#endif
+		resetTimers();
 
 		for(int i = 0; i < 16; i++)
 		{
@@ -138,6 +144,7 @@ namespace sw
 
 		currentDraw = 0;
 		nextDraw = 0;
+		followsBlit = false;
 
 		qHead = 0;
 		qSize = 0;
@@ -150,10 +157,18 @@ namespace sw
 
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
-			drawCall[draw] = new DrawCall();
-			drawList[draw] = drawCall[draw];
+			drawCall.push_back(new DrawCall());
 		}
 
+		for(int draw = 0; draw < MAX_DRAW_COUNT; draw++)
+		{
+			drawList[draw] = drawCall[draw % DRAW_COUNT];
+		}
+
+		maxDrawCount = DRAW_COUNT;
+		freeDraw = 0;
+		constantSerial = 1;
+
 		for(int unit = 0; unit < 16; unit++)
 		{
 			primitiveProgress[unit].init();
@@ -182,9 +197,9 @@ namespace sw
 		terminateThreads();
 		delete resumeApp;
 
-		for(int draw = 0; draw < DRAW_COUNT; draw++)
+		for(DrawCall *draw : drawCall)
 		{
-			delete drawCall[draw];
+			delete draw;
 		}
 
 		delete swiftConfig;
@@ -204,12 +219,46 @@ namespace sw
 
 	void Renderer::clear(void *pixel, Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask)
 	{
-		blitter.clear(pixel, format, dest, dRect, rgbaMask);
+		updateConfiguration();
+
+		sync->lock(sw::PRIVATE);
+
+		DrawCall *draw = acquireDrawCall();
+
+		if(!blitter.prepareClear(draw->blitOperation, pixel, format, dest, dRect, rgbaMask))
+		{
+			sync->unlock();
+
+			blitter.clear(pixel, format, dest, dRect, rgbaMask);
+
+			return;
+		}
+
+		TraceScope trace("Clear", nextDraw);
+
+		queueBlit(draw);
 	}
 
 	void Renderer::blit(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil)
 	{
-		blitter.blit(source, sRect, dest, dRect, filter, isStencil);
+		updateConfiguration();
+
+		sync->lock(sw::PRIVATE);
+
+		DrawCall *draw = acquireDrawCall();
+
+		if(!blitter.prepareBlit(draw->blitOperation, source, sRect, dest, dRect, filter, isStencil))
+		{
+			sync->unlock();
+
+			blitter.blit(source, sRect, dest, dRect, filter, isStencil);
+
+			return;
+		}
+
+		TraceScope trace("Blit", nextDraw);
+
+		queueBlit(draw);
 	}
 
 	void Renderer::blit3D(Surface *source, Surface *dest)
@@ -217,6 +266,34 @@ namespace sw
 		blitter.blit3D(source, dest);
 	}
 
+	void Renderer::readPixels(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, Resource *pixelBuffer)
+	{
+		updateConfiguration();
+
+		sync->lock(sw::PRIVATE);
+
+		DrawCall *draw = acquireDrawCall();
+
+		pixelBuffer->lock(sw::MANAGED);
+
+		if(!blitter.prepareReadback(draw->blitOperation, source, sRect, dest, dRect))
+		{
+			pixelBuffer->unlock();
+			sync->unlock();
+
+			blitter.blit(source, sRect, dest, dRect, false);
+			delete dest;
+
+			return;
+		}
+
+		TraceScope trace("Read pixels", nextDraw);
+
+		draw->pixelBuffer = pixelBuffer;
+
+		queueBlit(draw);
+	}
+
 	void Renderer::draw(DrawType drawType, unsigned int indexOffset, unsigned int count, bool update)
 	{
 		#ifndef NDEBUG
@@ -228,9 +305,13 @@ namespace sw
 
 		context->drawType = drawType;
 
+		bool profiling = profiler.enabled;
+
 		updateConfiguration();
 		updateClipper();
 
+		update = update || (profiler.enabled != profiling);   // Selects (un)instrumented routines
+
 		int ss = context->getSuperSampleCount();
 		int ms = context->getMultiSampleCount();
 
@@ -246,6 +327,8 @@ namespace sw
 
 			sync->lock(sw::PRIVATE);
 
+			TraceScope trace("Draw", nextDraw);
+
 			if(update || oldMultiSampleMask != context->multiSampleMask)
 			{
 				vertexState = VertexProcessor::update(drawType);
@@ -255,6 +338,17 @@ namespace sw
 				vertexRoutine = VertexProcessor::routine(vertexState);
 				setupRoutine = SetupProcessor::routine(setupState);
 				pixelRoutine = PixelProcessor::routine(pixelState);
+
+				if((context->vertexShader && context->vertexShader->isSpecializable()) ||
+				   (context->pixelShader && context->pixelShader->isSpecializable()))
+				{
+					profiler.specializableDraws++;
+
+					if(vertexState.specialization.active() || pixelState.specialization.active())
+					{
+						profiler.specializedDraws++;
+					}
+				}
 			}
 
 			int batch = batchSize / ms;
@@ -290,28 +384,7 @@ namespace sw
 				setupPrimitives = &Renderer::setupPoints;
 			}
 
-			DrawCall *draw = 0;
-
-			do
-			{
-				for(int i = 0; i < DRAW_COUNT; i++)
-				{
-					if(drawCall[i]->references == -1)
-					{
-						draw = drawCall[i];
-						drawList[nextDraw % DRAW_COUNT] = draw;
-
-						break;
-					}
-				}
-
-				if(!draw)
-				{
-					resumeApp->wait();
-				}
-			}
-			while(!draw);
-
+			DrawCall *draw = acquireDrawCall();
 			DrawData *data = draw->data;
 
 			if(queries.size() != 0)
@@ -329,6 +402,7 @@ namespace sw
 				}
 			}
 
+			draw->blit = false;
 			draw->drawType = drawType;
 			draw->batchSize = batch;
 
@@ -344,6 +418,7 @@ namespace sw
 			draw->pixelPointer = (PixelProcessor::RoutinePointer)pixelRoutine->getEntry();
 			draw->setupPrimitives = setupPrimitives;
 			draw->setupState = setupState;
+			draw->profile = pixelState.profile;
 
 			for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
 			{
@@ -382,25 +457,30 @@ namespace sw
 
 			if(context->pixelShader)
 			{
-				if(draw->psDirtyConstF)
+				int count = 0;
+
+				for(int first = 0; psConstantVersionF.next(draw->psConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->ps.cW, PixelProcessor::cW, sizeof(word4) * 4 * (draw->psDirtyConstF < 8 ? draw->psDirtyConstF : 8));
-					memcpy(&data->ps.c, PixelProcessor::c, sizeof(float4) * draw->psDirtyConstF);
-					draw->psDirtyConstF = 0;
+					if(first < 8)
+					{
+						memcpy(&data->ps.cW[first], PixelProcessor::cW[first], sizeof(word4) * 4 * min(count, 8 - first));
+					}
+
+					memcpy(&data->ps.c[first], &PixelProcessor::c[first], sizeof(float4) * count);
 				}
 
-				if(draw->psDirtyConstI)
+				for(int first = 0; psConstantVersionI.next(draw->psConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->ps.i, PixelProcessor::i, sizeof(int4) * draw->psDirtyConstI);
-					draw->psDirtyConstI = 0;
+					memcpy(&data->ps.i[first], &PixelProcessor::i[first], sizeof(int4) * count);
 				}
 
-				if(draw->psDirtyConstB)
+				for(int first = 0; psConstantVersionB.next(draw->psConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->ps.b, PixelProcessor::b, sizeof(bool) * draw->psDirtyConstB);
-					draw->psDirtyConstB = 0;
+					memcpy(&data->ps.b[first], &PixelProcessor::b[first], sizeof(bool) * count);
 				}
 
+				draw->psConstantSerial = constantSerial;
+
 				PixelProcessor::lockUniformBuffers(data->ps.u, draw->pUniformBuffers);
 			}
 			else
@@ -439,24 +519,25 @@ namespace sw
 					}
 				}
 
-				if(draw->vsDirtyConstF)
+				int count = 0;
+
+				for(int first = 0; vsConstantVersionF.next(draw->vsConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->vs.c, VertexProcessor::c, sizeof(float4) * draw->vsDirtyConstF);
-					draw->vsDirtyConstF = 0;
+					memcpy(&data->vs.c[first], &VertexProcessor::c[first], sizeof(float4) * count);
 				}
 
-				if(draw->vsDirtyConstI)
+				for(int first = 0; vsConstantVersionI.next(draw->vsConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->vs.i, VertexProcessor::i, sizeof(int4) * draw->vsDirtyConstI);
-					draw->vsDirtyConstI = 0;
+					memcpy(&data->vs.i[first], &VertexProcessor::i[first], sizeof(int4) * count);
 				}
 
-				if(draw->vsDirtyConstB)
+				for(int first = 0; vsConstantVersionB.next(draw->vsConstantSerial, first, count); first += count)
 				{
-					memcpy(&data->vs.b, VertexProcessor::b, sizeof(bool) * draw->vsDirtyConstB);
-					draw->vsDirtyConstB = 0;
+					memcpy(&data->vs.b[first], &VertexProcessor::b[first], sizeof(bool) * count);
 				}
 
+				draw->vsConstantSerial = constantSerial;
+
 				if(context->vertexShader->isInstanceIdDeclared())
 				{
 					data->instanceID = context->instanceID;
@@ -469,9 +550,7 @@ namespace sw
 			{
 				data->ff = ff;
 
-				draw->vsDirtyConstF = VERTEX_UNIFORM_VECTORS + 1;
-				draw->vsDirtyConstI = 16;
-				draw->vsDirtyConstB = 16;
+				draw->vsConstantSerial = 0;   // Fixed-function data overlaps the vertex shader constants
 
 				for(int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; i++)
 				{
@@ -532,7 +611,8 @@ namespace sw
 				}
 			}
 
-			#if PERF_PROFILE
+			if(pixelState.profile)
+			{
 				for(int cluster = 0; cluster < clusterCount; cluster++)
 				{
 					for(int i = 0; i < PERF_TIMERS; i++)
@@ -540,7 +620,12 @@ namespace sw
 						data->cycles[i][cluster] = 0;
 					}
 				}
-			#endif
+
+				for(int i = 0; i < PERF_COUNTERS; i++)
+				{
+					data->counters[i] = 0;
+				}
+			}
 
 			// Viewport
 			{
@@ -591,6 +676,8 @@ namespace sw
 				data->YYYY = replicate(Y[s][q] / H);
 				data->halfPixelX = replicate(0.5f / W);
 				data->halfPixelY = replicate(0.5f / H);
+				data->guardBandX = replicate(max(GUARD_BAND / abs(W), 1.0f));
+				data->guardBandY = replicate(max(GUARD_BAND / abs(H), 1.0f));
 				data->viewportHeight = abs(viewport.height);
 				data->slopeDepthBias = slopeDepthBias;
 				data->depthRange = Z;
@@ -640,12 +727,15 @@ namespace sw
 				}
 			}
 
-			// Scissor
+			// Scissor, confined to the viewport since primitives within the guard band aren't clipped to its sides
 			{
-				data->scissorX0 = scissor.x0;
-				data->scissorX1 = scissor.x1;
-				data->scissorY0 = scissor.y0;
-				data->scissorY1 = scissor.y1;
+				float viewportY0 = min(viewport.y0, viewport.y0 + viewport.height);
+				float viewportY1 = max(viewport.y0, viewport.y0 + viewport.height);
+
+				data->scissorX0 = max(scissor.x0, (int)floor(viewport.x0));
+				data->scissorX1 = min(scissor.x1, (int)ceil(viewport.x0 + viewport.width));
+				data->scissorY0 = max(scissor.y0, (int)floor(viewportY0));
+				data->scissorY1 = min(scissor.y1, (int)ceil(viewportY1));
 			}
 
 			draw->primitive = 0;
@@ -653,30 +743,92 @@ namespace sw
 
 			draw->references = (count + batch - 1) / batch;
 
-			schedulerMutex.lock();
-			nextDraw++;
-			schedulerMutex.unlock();
+			atomicIncrement(&profiler.drawsQueued);
+
+			queueDrawCall();
+		}
+	}
+
+	DrawCall *Renderer::acquireDrawCall()
+	{
+		DrawCall *draw = 0;
 
-			#ifndef NDEBUG
-			if(threadCount == 1)   // Use main thread for draw execution
+		do
+		{
+			// Draw calls complete in order, so the one after the most recently acquired is usually free
+			for(size_t i = 0; i < drawCall.size(); i++)
 			{
-				threadsAwake = 1;
-				task[0].type = Task::RESUME;
+				size_t index = (freeDraw + i) % drawCall.size();
+
+				if(drawCall[index]->references == -1)
+				{
+					draw = drawCall[index];
+					freeDraw = index + 1;
+
+					break;
+				}
+			}
 
-				taskLoop(0);
+			if(!draw && drawCall.size() < maxDrawCount)
+			{
+				draw = new DrawCall();
+				drawCall.push_back(draw);
+				freeDraw = drawCall.size();
+			}
+
+			if(draw)
+			{
+				drawList[nextDraw % MAX_DRAW_COUNT] = draw;
 			}
 			else
-			#endif
 			{
-				if(!threadsAwake)
-				{
-					suspend[0]->wait();
+				resumeApp->wait();
+			}
+		}
+		while(!draw);
 
-					threadsAwake = 1;
-					task[0].type = Task::RESUME;
+		return draw;
+	}
 
-					resume[0]->signal();
-				}
+	void Renderer::queueBlit(DrawCall *draw)
+	{
+		// Split into bands of at least 16 rows, each executed as a separate task
+		int bands = sw::max(1, sw::min((draw->blitOperation.rows() + 15) / 16, 2 * threadCount));
+
+		draw->blit = true;
+		draw->batchSize = 1;
+		draw->primitive = 0;
+		draw->count = bands;
+		draw->references = bands;
+
+		queueDrawCall();
+	}
+
+	void Renderer::queueDrawCall()
+	{
+		schedulerMutex.lock();
+		nextDraw++;
+		schedulerMutex.unlock();
+
+		#ifndef NDEBUG
+		if(threadCount == 1)   // Use main thread for draw execution
+		{
+			threadsAwake = 1;
+			task[0].type = Task::RESUME;
+
+			taskLoop(0);
+		}
+		else
+		#endif
+		{
+			if(!threadsAwake)
+			{
+				suspend[0]->wait();
+
+				threadsAwake = 1;
+				task[0].type = Task::RESUME;
+
+				resume[0]->signal();
 			}
 		}
 	}
@@ -686,6 +838,10 @@ namespace sw
 		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
 		int threadIndex = static_cast<Parameters*>(parameters)->threadIndex;
 
+		char name[16];
+		sprintf(name, "Worker %d", threadIndex);
+		Trace::nameThread(name);
+
 		if(logPrecision < IEEE)
 		{
 			CPUID::setFlushToZero(true);
@@ -711,7 +867,10 @@ namespace sw
 		while(task[threadIndex].type != Task::SUSPEND)
 		{
 			scheduleTask(threadIndex);
+
+			int64_t startTime = Timer::counter();
 			executeTask(threadIndex);
+			atomicAdd(&profiler.threadBusy[threadIndex], Timer::counter() - startTime);
 		}
 	}
 
@@ -730,6 +889,24 @@ namespace sw
 						{
 							if(pixelProgress[cluster].processedPrimitives == primitiveProgress[unit].firstPrimitive)   // Previous primitives have been rendered
 							{
+								// Batches which don't cover any of the cluster's rows are passed over without creating a task,
+								// so the cluster can move on to later batches. The last reference is left to finishRendering().
+								if(!(primitiveProgress[unit].clusters & (1 << cluster)) && releaseReference(unit))
+								{
+									DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
+
+									pixelProgress[cluster].processedPrimitives = primitiveProgress[unit].firstPrimitive + primitiveProgress[unit].primitiveCount;
+
+									if(pixelProgress[cluster].processedPrimitives >= draw.count)
+									{
+										pixelProgress[cluster].drawCall++;
+										pixelProgress[cluster].processedPrimitives = 0;
+									}
+
+									unit = -1;   // Look for the next batch
+									continue;
+								}
+
 								Task &task = taskQueue[qHead];
 								task.type = Task::PIXELS;
 								task.primitiveUnit = unit;
@@ -757,18 +934,12 @@ namespace sw
 
 		for(int unit = 0; unit < unitCount; unit++)
 		{
-			DrawCall *draw = drawList[currentDraw % DRAW_COUNT];
+			DrawCall *draw = drawList[currentDraw % MAX_DRAW_COUNT];
 
-			if(draw->primitive >= draw->count)
+			// Blits are ordered with respect to draw calls by waiting for the preceding operations to complete
+			if(draw->primitive == 0 && (draw->blit || followsBlit) && !isPipelineIdle())
 			{
-				currentDraw++;
-
-				if(currentDraw == nextDraw)
-				{
-					return;   // No more primitives to process
-				}
-
-				draw = drawList[currentDraw % DRAW_COUNT];
+				return;
 			}
 
 			if(!primitiveProgress[unit].references)   // Task not already being executed and not still in use by a pixel unit
@@ -784,7 +955,7 @@ namespace sw
 				draw->primitive += batch;
 
 				Task &task = taskQueue[qHead];
-				task.type = Task::PRIMITIVES;
+				task.type = draw->blit ? Task::BLIT : Task::PRIMITIVES;
 				task.primitiveUnit = unit;
 
 				primitiveProgress[unit].references = -1;
@@ -792,6 +963,18 @@ namespace sw
 				// Commit to the task queue
 				qHead = (qHead + 1) % 32;
 				qSize++;
+
+				// Move on as soon as all primitives are issued, because a completed draw call can get recycled
+				if(draw->primitive >= draw->count)
+				{
+					followsBlit = draw->blit;
+					currentDraw++;
+
+					if(currentDraw == nextDraw)
+					{
+						return;   // No more primitives to process
+					}
+				}
 			}
 		}
 	}
@@ -840,9 +1023,7 @@ namespace sw
 
 	void Renderer::executeTask(int threadIndex)
 	{
-		#if PERF_HUD
-			int64_t startTick = Timer::ticks();
-		#endif
+		int64_t startTick = profiler.enabled ? Timer::ticks() : 0;
 
 		switch(task[threadIndex].type)
 		{
@@ -852,42 +1033,53 @@ namespace sw
 
 				int input = primitiveProgress[unit].firstPrimitive;
 				int count = primitiveProgress[unit].primitiveCount;
-				DrawCall *draw = drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+				DrawCall *draw = drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
+				TraceScope trace("Primitives", primitiveProgress[unit].drawCall, unit);
 				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
 
 				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
 
-				#if PERF_HUD
+				if(profiler.enabled)
+				{
 					int64_t time = Timer::ticks();
 					vertexTime[threadIndex] += time - startTick;
 					startTick = time;
-				#endif
+				}
 
 				int visible = 0;
 
 				if(!draw->setupState.rasterizerDiscard)
 				{
 					visible = (this->*setupPrimitives)(unit, count);
+
+					if(draw->profile)
+					{
+						atomicAdd(&draw->data->counters[PERF_PRIMITIVES], (int64_t)count);
+						atomicAdd(&draw->data->counters[PERF_CULLED], (int64_t)(count - visible));
+					}
 				}
 
 				primitiveProgress[unit].visible = visible;
+				primitiveProgress[unit].clusters = coveredClusters(unit, visible);
 				primitiveProgress[unit].references = clusterCount;
 
-				#if PERF_HUD
+				if(profiler.enabled)
+				{
 					setupTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
+				}
 			}
 			break;
 		case Task::PIXELS:
 			{
 				int unit = task[threadIndex].primitiveUnit;
+				int cluster = task[threadIndex].pixelCluster;
 				int visible = primitiveProgress[unit].visible;
+				TraceScope trace("Pixels", primitiveProgress[unit].drawCall, unit, cluster);
 
-				if(visible > 0)
+				if(primitiveProgress[unit].clusters & (1 << cluster))   // Otherwise only releases the last reference
 				{
-					int cluster = task[threadIndex].pixelCluster;
 					Primitive *primitive = primitiveBatch[unit];
-					DrawCall *draw = drawList[pixelProgress[cluster].drawCall % DRAW_COUNT];
+					DrawCall *draw = drawList[pixelProgress[cluster].drawCall % MAX_DRAW_COUNT];
 					DrawData *data = draw->data;
 					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
 
@@ -896,11 +1088,15 @@ namespace sw
 
 				finishRendering(task[threadIndex]);
 
-				#if PERF_HUD
+				if(profiler.enabled)
+				{
 					pixelTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
+				}
 			}
 			break;
+		case Task::BLIT:
+			executeBlit(task[threadIndex].primitiveUnit);
+			break;
 		case Task::RESUME:
 			break;
 		case Task::SUSPEND:
@@ -910,6 +1106,99 @@ namespace sw
 		}
 	}
 
+	void Renderer::executeBlit(int unit)
+	{
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
+		int band = primitiveProgress[unit].firstPrimitive;
+
+		{
+			TraceScope trace("Blit band", primitiveProgress[unit].drawCall, unit);
+			ProfilerTimer timer(&profiler.blitTime);
+
+			blitter.execute(draw.blitOperation, band, draw.count);
+		}
+
+		if(atomicDecrement(&draw.references) == 0)
+		{
+			blitter.finish(draw.blitOperation);
+
+			if(draw.pixelBuffer)
+			{
+				draw.pixelBuffer->unlock();
+				draw.pixelBuffer = nullptr;
+			}
+
+			// No pixel tasks are generated for blits, so advance the clusters past it
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				pixelProgress[cluster].drawCall++;
+			}
+
+			finishDrawCall(draw);
+		}
+
+		primitiveProgress[unit].references = 0;
+	}
+
+	void Renderer::finishDrawCall(DrawCall &draw)
+	{
+		sync->unlock();
+
+		// Fences are attached under the scheduler lock, so they can't be added to a completed draw call
+		schedulerMutex.lock();
+
+		if(draw.fences)
+		{
+			for(std::list<Fence*>::iterator fence = draw.fences->begin(); fence != draw.fences->end(); fence++)
+			{
+				(*fence)->removePending();
+				(*fence)->release();
+			}
+
+			delete draw.fences;
+			draw.fences = 0;
+		}
+
+		draw.references = -1;
+
+		schedulerMutex.unlock();
+
+		resumeApp->signal();
+	}
+
+	bool Renderer::isPipelineIdle()
+	{
+		for(int cluster = 0; cluster < clusterCount; cluster++)
+		{
+			if(pixelProgress[cluster].drawCall != currentDraw || pixelProgress[cluster].executing)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Renderer::releaseReference(int unit)
+	{
+		// Never releases the last reference, so the batch can't complete without a pixel task
+		int references = primitiveProgress[unit].references;
+
+		while(references > 1)
+		{
+			int previous = atomicCompareExchange(&primitiveProgress[unit].references, references - 1, references);
+
+			if(previous == references)
+			{
+				return true;
+			}
+
+			references = previous;
+		}
+
+		return false;
+	}
+
 	void Renderer::synchronize()
 	{
 		sync->lock(sw::PUBLIC);
@@ -921,7 +1210,7 @@ namespace sw
 		int unit = pixelTask.primitiveUnit;
 		int cluster = pixelTask.pixelCluster;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		DrawData &data = *draw.data;
 		int primitive = primitiveProgress[unit].firstPrimitive;
 		int count = primitiveProgress[unit].primitiveCount;
@@ -943,7 +1232,10 @@ namespace sw
 
 			if(ref == 0)
 			{
-				#if PERF_PROFILE
+				atomicDecrement(&profiler.drawsQueued);
+
+				if(draw.profile)
+				{
 					for(int cluster = 0; cluster < clusterCount; cluster++)
 					{
 						for(int i = 0; i < PERF_TIMERS; i++)
@@ -951,7 +1243,12 @@ namespace sw
 							profiler.cycles[i] += data.cycles[i][cluster];
 						}
 					}
-				#endif
+
+					for(int i = 0; i < PERF_COUNTERS; i++)
+					{
+						atomicAdd(&profiler.counters[i], data.counters[i]);
+					}
+				}
 
 				if(draw.queries)
 				{
@@ -1044,10 +1341,7 @@ namespace sw
 				draw.setupRoutine->unbind();
 				draw.pixelRoutine->unbind();
 
-				sync->unlock();
-
-				draw.references = -1;
-				resumeApp->signal();
+				finishDrawCall(draw);
 			}
 		}
 
@@ -1057,7 +1351,7 @@ namespace sw
 	void Renderer::processPrimitiveVertices(int unit, unsigned int start, unsigned int triangleCount, unsigned int loop, int thread)
 	{
 		Triangle *triangle = triangleBatch[unit];
-		DrawCall *draw = drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall *draw = drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		DrawData *data = draw->data;
 		VertexTask *task = vertexTask[thread];
 
@@ -1487,7 +1781,7 @@ namespace sw
 		Triangle *triangle = triangleBatch[unit];
 		Primitive *primitive = primitiveBatch[unit];
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		SetupProcessor::State &state = draw.setupState;
 		const SetupProcessor::RoutinePointer &setupRoutine = draw.setupPointer;
 
@@ -1496,18 +1790,29 @@ namespace sw
 		const DrawData *data = draw.data;
 		int visible = 0;
 
-		for(int i = 0; i < count; i++, triangle++)
+		for(int first = 0; first < count; first += 16)
 		{
-			Vertex &v0 = triangle->v0;
-			Vertex &v1 = triangle->v1;
-			Vertex &v2 = triangle->v2;
+			int survivor[16];
+			int survivors = cullTriangles(&triangle[first], min(count - first, 16), draw, survivor);
 
-			if((v0.clipFlags & v1.clipFlags & v2.clipFlags) == Clipper::CLIP_FINITE)
+			for(int i = 0; i < survivors; i++)
 			{
+				Triangle *t = &triangle[first + survivor[i]];
+
+				Vertex &v0 = t->v0;
+				Vertex &v1 = t->v1;
+				Vertex &v2 = t->v2;
+
 				Polygon polygon(&v0.v[pos], &v1.v[pos], &v2.v[pos]);
 
 				int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
 
+				// Inside the guard band, scissoring takes care of the sides of the viewport
+				if(!(clipFlagsOr & Clipper::CLIP_GUARD))
+				{
+					clipFlagsOr &= ~(Clipper::CLIP_LEFT | Clipper::CLIP_RIGHT | Clipper::CLIP_TOP | Clipper::CLIP_BOTTOM);
+				}
+
 				if(clipFlagsOr != Clipper::CLIP_FINITE)
 				{
 					if(!clipper->clip(polygon, clipFlagsOr, draw))
@@ -1516,7 +1821,7 @@ namespace sw
 					}
 				}
 
-				if(setupRoutine(primitive, triangle, &polygon, data))
+				if(setupRoutine(primitive, t, &polygon, data))
 				{
 					primitive += ms;
 					visible++;
@@ -1527,13 +1832,211 @@ namespace sw
 		return visible;
 	}
 
+	#if defined(__i386__) || defined(__x86_64__)
+		static inline __m128i min4i(__m128i a, __m128i b)
+		{
+			__m128i greater = _mm_cmpgt_epi32(a, b);
+
+			return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+		}
+
+		static inline __m128i max4i(__m128i a, __m128i b)
+		{
+			__m128i greater = _mm_cmpgt_epi32(a, b);
+
+			return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+		}
+	#endif
+
+	// Performs the rejection tests of the setup routine up front, four triangles at a time, so that
+	// triangles which are outside the frustum, back-facing, degenerate, or don't cover any pixel rows
+	// don't pay for the routine call. Writes the indices of the remaining triangles to 'survivor'.
+	int Renderer::cullTriangles(const Triangle *triangle, int count, const DrawCall &draw, int *survivor)
+	{
+		const SetupProcessor::State &state = draw.setupState;
+		const DrawData *data = draw.data;
+
+		int pos = state.positionRegister;
+		int yMinRound = state.multiSample > 1 ? 0x0A : 0x0F;
+		int yMaxRound = state.multiSample > 1 ? 0x14 : 0x0F;
+		int sides = Clipper::CLIP_LEFT | Clipper::CLIP_RIGHT | Clipper::CLIP_TOP | Clipper::CLIP_BOTTOM;
+
+		int survivors = 0;
+		int i = 0;
+
+		#if defined(__i386__) || defined(__x86_64__)
+			if(CPUID::supportsSSE2())
+			{
+				for(; i + 4 <= count; i += 4)
+				{
+					const Triangle *t = &triangle[i];
+
+					#define GATHER(member) _mm_setr_epi32(t[0].member, t[1].member, t[2].member, t[3].member)
+					#define GATHER_PS(member) _mm_setr_ps(t[0].member, t[1].member, t[2].member, t[3].member)
+
+					__m128i X0 = GATHER(v0.X);
+					__m128i X1 = GATHER(v1.X);
+					__m128i X2 = GATHER(v2.X);
+					__m128i Y0 = GATHER(v0.Y);
+					__m128i Y1 = GATHER(v1.Y);
+					__m128i Y2 = GATHER(v2.Y);
+					__m128i C0 = GATHER(v0.clipFlags);
+					__m128i C1 = GATHER(v1.clipFlags);
+					__m128i C2 = GATHER(v2.clipFlags);
+					__m128 W012 = _mm_xor_ps(_mm_xor_ps(GATHER_PS(v0.v[pos].w), GATHER_PS(v1.v[pos].w)), GATHER_PS(v2.v[pos].w));
+
+					#undef GATHER
+					#undef GATHER_PS
+
+					// Entirely outside one of the frustum planes, or not finite
+					__m128i clipAnd = _mm_and_si128(_mm_and_si128(C0, C1), _mm_and_si128(C2, _mm_set1_epi32(~Clipper::CLIP_GUARD)));
+					__m128i inside = _mm_cmpeq_epi32(clipAnd, _mm_set1_epi32(Clipper::CLIP_FINITE));
+
+					// Area, negated when an odd number of vertices is behind the viewer
+					__m128 x0 = _mm_cvtepi32_ps(X0);
+					__m128 x1 = _mm_cvtepi32_ps(X1);
+					__m128 x2 = _mm_cvtepi32_ps(X2);
+					__m128 y0 = _mm_cvtepi32_ps(Y0);
+					__m128 y1 = _mm_cvtepi32_ps(Y1);
+					__m128 y2 = _mm_cvtepi32_ps(Y2);
+
+					__m128 A = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(y2, y0), x1), _mm_mul_ps(_mm_sub_ps(y1, y2), x0)), _mm_mul_ps(_mm_sub_ps(y0, y1), x2));
+					A = _mm_xor_ps(A, _mm_and_ps(W012, _mm_castsi128_ps(_mm_set1_epi32(0x80000000))));
+
+					__m128 culled;
+
+					switch(state.cullMode)
+					{
+					case CULL_CLOCKWISE:        culled = _mm_cmpge_ps(A, _mm_setzero_ps()); break;
+					case CULL_COUNTERCLOCKWISE: culled = _mm_cmple_ps(A, _mm_setzero_ps()); break;
+					default:                    culled = _mm_cmpeq_ps(A, _mm_setzero_ps()); break;
+					}
+
+					// Triangles which don't need clipping have to cover a pixel row within the scissor rectangle
+					__m128i clipOr = _mm_or_si128(_mm_or_si128(C0, C1), _mm_or_si128(C2, _mm_set1_epi32(draw.clipFlags)));
+					__m128i guard = _mm_cmpeq_epi32(_mm_and_si128(clipOr, _mm_set1_epi32(Clipper::CLIP_GUARD)), _mm_setzero_si128());
+					clipOr = _mm_andnot_si128(_mm_and_si128(guard, _mm_set1_epi32(sides)), clipOr);
+					__m128i unclipped = _mm_cmpeq_epi32(clipOr, _mm_set1_epi32(Clipper::CLIP_FINITE));
+
+					__m128i yMin = _mm_srai_epi32(_mm_add_epi32(min4i(min4i(Y0, Y1), Y2), _mm_set1_epi32(yMinRound)), 4);
+					__m128i yMax = _mm_srai_epi32(_mm_add_epi32(max4i(max4i(Y0, Y1), Y2), _mm_set1_epi32(yMaxRound)), 4);
+					yMin = max4i(yMin, _mm_set1_epi32(data->scissorY0));
+					yMax = min4i(yMax, _mm_set1_epi32(data->scissorY1));
+					__m128i empty = _mm_and_si128(unclipped, _mm_cmpgt_epi32(_mm_add_epi32(yMin, _mm_set1_epi32(1)), yMax));
+
+					__m128i visible = _mm_andnot_si128(_mm_or_si128(_mm_castps_si128(culled), empty), inside);
+					int mask = _mm_movemask_ps(_mm_castsi128_ps(visible));
+
+					for(int j = 0; j < 4; j++)
+					{
+						if(mask & (1 << j))
+						{
+							survivor[survivors++] = i + j;
+						}
+					}
+				}
+			}
+		#endif
+
+		for(; i < count; i++)
+		{
+			const Vertex &v0 = triangle[i].v0;
+			const Vertex &v1 = triangle[i].v1;
+			const Vertex &v2 = triangle[i].v2;
+
+			if((v0.clipFlags & v1.clipFlags & v2.clipFlags & ~Clipper::CLIP_GUARD) != Clipper::CLIP_FINITE)
+			{
+				continue;
+			}
+
+			float x0 = (float)v0.X;
+			float x1 = (float)v1.X;
+			float x2 = (float)v2.X;
+			float y0 = (float)v0.Y;
+			float y1 = (float)v1.Y;
+			float y2 = (float)v2.Y;
+
+			float A = (y2 - y0) * x1 + (y1 - y2) * x0 + (y0 - y1) * x2;
+
+			int w0, w1, w2;
+			memcpy(&w0, &v0.v[pos].w, sizeof(int));
+			memcpy(&w1, &v1.v[pos].w, sizeof(int));
+			memcpy(&w2, &v2.v[pos].w, sizeof(int));
+
+			if((w0 ^ w1 ^ w2) < 0)
+			{
+				A = -A;
+			}
+
+			switch(state.cullMode)
+			{
+			case CULL_CLOCKWISE:        if(A >= 0.0f) continue; break;
+			case CULL_COUNTERCLOCKWISE: if(A <= 0.0f) continue; break;
+			default:                    if(A == 0.0f) continue; break;
+			}
+
+			int clipFlagsOr = v0.clipFlags | v1.clipFlags | v2.clipFlags | draw.clipFlags;
+
+			if(!(clipFlagsOr & Clipper::CLIP_GUARD))
+			{
+				clipFlagsOr &= ~sides;
+			}
+
+			if(clipFlagsOr == Clipper::CLIP_FINITE)
+			{
+				int yMin = (min(min(v0.Y, v1.Y), v2.Y) + yMinRound) >> 4;
+				int yMax = (max(max(v0.Y, v1.Y), v2.Y) + yMaxRound) >> 4;
+
+				if(max(yMin, data->scissorY0) >= min(yMax, data->scissorY1))
+				{
+					continue;
+				}
+			}
+
+			survivor[survivors++] = i;
+		}
+
+		return survivors;
+	}
+
+	unsigned int Renderer::coveredClusters(int unit, int visible)
+	{
+		const Primitive *primitive = primitiveBatch[unit];
+		const DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
+		int ms = draw.setupState.multiSample;
+
+		unsigned int all = (1 << clusterCount) - 1;
+		unsigned int clusters = 0;
+
+		// Each cluster rasterizes every clusterCount'th pair of rows, starting with the pair containing yMin
+		for(int i = 0; i < visible && clusters != all; i++)
+		{
+			int first = primitive->yMin >> 1;
+			int last = (primitive->yMax + 1) >> 1;
+
+			if(last - first >= clusterCount)
+			{
+				return all;
+			}
+
+			for(int pair = first; pair < last; pair++)
+			{
+				clusters |= 1 << (pair & (clusterCount - 1));
+			}
+
+			primitive += ms;
+		}
+
+		return clusters;
+	}
+
 	int Renderer::setupWireframeTriangle(int unit, int count)
 	{
 		Triangle *triangle = triangleBatch[unit];
 		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		SetupProcessor::State &state = draw.setupState;
 
 		const Vertex &v0 = triangle[0].v0;
@@ -1590,7 +2093,7 @@ namespace sw
 		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		SetupProcessor::State &state = draw.setupState;
 
 		const Vertex &v0 = triangle[0].v0;
@@ -1634,7 +2137,7 @@ namespace sw
 		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		SetupProcessor::State &state = draw.setupState;
 
 		int ms = state.multiSample;
@@ -1659,7 +2162,7 @@ namespace sw
 		Primitive *primitive = primitiveBatch[unit];
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % DRAW_COUNT];
+		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall % MAX_DRAW_COUNT];
 		SetupProcessor::State &state = draw.setupState;
 
 		int ms = state.multiSample;
@@ -2452,13 +2955,7 @@ namespace sw
 
 	void Renderer::setPixelShaderConstantF(int index, const float value[4], int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->psDirtyConstF < index + count)
-			{
-				drawCall[i]->psDirtyConstF = index + count;
-			}
-		}
+		psConstantVersionF.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2469,13 +2966,7 @@ namespace sw
 
 	void Renderer::setPixelShaderConstantI(int index, const int value[4], int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->psDirtyConstI < index + count)
-			{
-				drawCall[i]->psDirtyConstI = index + count;
-			}
-		}
+		psConstantVersionI.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2486,13 +2977,7 @@ namespace sw
 
 	void Renderer::setPixelShaderConstantB(int index, const int *boolean, int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->psDirtyConstB < index + count)
-			{
-				drawCall[i]->psDirtyConstB = index + count;
-			}
-		}
+		psConstantVersionB.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2503,13 +2988,7 @@ namespace sw
 
 	void Renderer::setVertexShaderConstantF(int index, const float value[4], int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->vsDirtyConstF < index + count)
-			{
-				drawCall[i]->vsDirtyConstF = index + count;
-			}
-		}
+		vsConstantVersionF.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2520,13 +2999,7 @@ namespace sw
 
 	void Renderer::setVertexShaderConstantI(int index, const int value[4], int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->vsDirtyConstI < index + count)
-			{
-				drawCall[i]->vsDirtyConstI = index + count;
-			}
-		}
+		vsConstantVersionI.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2537,13 +3010,7 @@ namespace sw
 
 	void Renderer::setVertexShaderConstantB(int index, const int *boolean, int count)
 	{
-		for(int i = 0; i < DRAW_COUNT; i++)
-		{
-			if(drawCall[i]->vsDirtyConstB < index + count)
-			{
-				drawCall[i]->vsDirtyConstB = index + count;
-			}
-		}
+		vsConstantVersionB.set(index, count, ++constantSerial);
 
 		for(int i = 0; i < count; i++)
 		{
@@ -2585,37 +3052,114 @@ namespace sw
 		queries.remove(query);
 	}
 
-	#if PERF_HUD
-		int Renderer::getThreadCount()
+	void Fence::addRef()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		references++;
+	}
+
+	void Fence::release()
+	{
+		bool last;
+
 		{
-			return threadCount;
+			std::lock_guard<std::mutex> lock(mutex);
+			last = (--references == 0);
 		}
 
-		int64_t Renderer::getVertexTime(int thread)
+		if(last)
 		{
-			return vertexTime[thread];
+			delete this;
 		}
+	}
+
+	void Fence::addPending()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending++;
+	}
+
+	void Fence::removePending()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
 
-		int64_t Renderer::getSetupTime(int thread)
+		if(--pending == 0)
 		{
-			return setupTime[thread];
+			signaled.notify_all();
 		}
+	}
+
+	bool Fence::isSignaled()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending == 0;
+	}
+
+	bool Fence::wait(uint64_t timeout)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
 
-		int64_t Renderer::getPixelTime(int thread)
+		// Timeouts beyond a year, like GL_TIMEOUT_IGNORED, would overflow the clock
+		if(timeout >= 1000000000ull * 3600 * 24 * 365)
 		{
-			return pixelTime[thread];
+			signaled.wait(lock, [this]() { return pending == 0; });
+			return true;
 		}
 
-		void Renderer::resetTimers()
+		return signaled.wait_for(lock, std::chrono::nanoseconds(timeout), [this]() { return pending == 0; });
+	}
+
+	void Renderer::addFence(Fence *fence)
+	{
+		schedulerMutex.lock();
+
+		// Operations complete in queue order, so it suffices to wait for the last one
+		DrawCall *draw = drawList[(nextDraw + MAX_DRAW_COUNT - 1) % MAX_DRAW_COUNT];
+
+		if(draw->references != -1)
 		{
-			for(int thread = 0; thread < threadCount; thread++)
+			if(!draw->fences)
 			{
-				vertexTime[thread] = 0;
-				setupTime[thread] = 0;
-				pixelTime[thread] = 0;
+				draw->fences = new std::list<Fence*>();
 			}
+
+			fence->addRef();
+			fence->addPending();
+			draw->fences->push_back(fence);
 		}
-	#endif
+
+		schedulerMutex.unlock();
+	}
+
+	int Renderer::getThreadCount()
+	{
+		return threadCount;
+	}
+
+	int64_t Renderer::getVertexTime(int thread)
+	{
+		return vertexTime[thread];
+	}
+
+	int64_t Renderer::getSetupTime(int thread)
+	{
+		return setupTime[thread];
+	}
+
+	int64_t Renderer::getPixelTime(int thread)
+	{
+		return pixelTime[thread];
+	}
+
+	void Renderer::resetTimers()
+	{
+		for(int thread = 0; thread < threadCount; thread++)
+		{
+			vertexTime[thread] = 0;
+			setupTime[thread] = 0;
+			pixelTime[thread] = 0;
+		}
+	}
 
 	void Renderer::setViewport(const Viewport &viewport)
 	{
@@ -2661,6 +3205,11 @@ namespace sw
 			VertexProcessor::setRoutineCacheSize(configuration.vertexRoutineCacheSize);
 			PixelProcessor::setRoutineCacheSize(configuration.pixelRoutineCacheSize);
 			SetupProcessor::setRoutineCacheSize(configuration.setupRoutineCacheSize);
+			setExecutableMemoryBudget((size_t)configuration.codeMemoryBudget * 1024 * 1024);
+
+			size_t drawQueueMemory = (size_t)configuration.drawQueueMemory * 1024 * 1024;
+			maxDrawCount = max<size_t>(DRAW_COUNT, min<size_t>(drawQueueMemory / (sizeof(DrawCall) + sizeof(DrawData)), MAX_DRAW_COUNT));
+			Shader::setSpecializationLimit(configuration.shaderSpecialization);
 
 			switch(configuration.textureSampleQuality)
 			{
@@ -2750,6 +3299,18 @@ namespace sw
 			exactColorRounding = configuration.exactColorRounding;
 			forceClearRegisters = configuration.forceClearRegisters;
 
+			profiler.enabled = configuration.profiling || configuration.perfHUD;
+			profiler.hud = configuration.perfHUD;
+
+			if(configuration.tracing)
+			{
+				Trace::enable(configuration.traceFile);
+			}
+			else
+			{
+				Trace::disable();
+			}
+
 		#ifndef NDEBUG
 			minPrimitives = configuration.minPrimitives;
 			maxPrimitives = configuration.maxPrimitives;
@@ -24,7 +24,10 @@
 #include "Common/Thread.hpp"
 #include "Main/Config.hpp"
 
+#include <condition_variable>
 #include <list>
+#include <mutex>
+#include <vector>
 
 namespace sw
 {
@@ -113,6 +116,39 @@ namespace sw
 		const Type type;
 	};
 
+	// Signaled when the operations queued before it have completed. The creator holds
+	// the initial reference, and the renderer holds one while operations are pending,
+	// so the creator can release it at any time.
+	struct Fence
+	{
+		Fence() : references(1), pending(0)
+		{
+		}
+
+		void addRef();
+		void release();   // Deletes the fence when the last reference is released
+
+		void addPending();
+		void removePending();   // Wakes up waiting threads when no operations are pending anymore
+
+		bool isSignaled();
+
+		// Returns false if the timeout, in nanoseconds, expired before the fence was signaled.
+		// The caller must hold a reference.
+		bool wait(uint64_t timeout);
+
+	private:
+		~Fence()
+		{
+		}
+
+		int references;
+		int pending;   // Operations queued before the fence which haven't completed
+
+		std::mutex mutex;   // Protects the counts, so that waiters can't miss the last pending operation
+		std::condition_variable signaled;
+	};
+
 	struct DrawData
 	{
 		const Constants *constants;
@@ -163,9 +199,8 @@ namespace sw
 		PixelProcessor::Factor factor;
 		unsigned int occlusion[16];   // Number of pixels passing depth test
 
-		#if PERF_PROFILE
-			int64_t cycles[PERF_TIMERS][16];
-		#endif
+		int64_t cycles[PERF_TIMERS][16];   // Only updated when profiling
+		int64_t counters[PERF_COUNTERS];
 
 		TextureStage::Uniforms textureStage[8];
 
@@ -177,6 +212,8 @@ namespace sw
 		float4 YYYY;
 		float4 halfPixelX;
 		float4 halfPixelY;
+		float4 guardBandX;   // Extent of the guard band, relative to the viewport
+		float4 guardBandY;
 		float viewportHeight;
 		float slopeDepthBias;
 		float depthRange;
@@ -204,6 +241,59 @@ namespace sw
 		float4 a2c3;
 	};
 
+	// Records when each constant was last modified, so draw calls only copy constants changed since they last used them
+	template<int N>
+	class ConstantVersions
+	{
+	public:
+		ConstantVersions()
+		{
+			for(int i = 0; i < N; i++)
+			{
+				version[i] = 1;   // Newer than any draw call's copy
+			}
+
+			for(int g = 0; g < GROUPS; g++)
+			{
+				latest[g] = 1;
+			}
+		}
+
+		void set(int index, int count, uint64_t serial)
+		{
+			for(int i = index; i < index + count && i < N; i++)
+			{
+				version[i] = serial;
+				latest[i / 32] = serial;
+			}
+		}
+
+		// Finds the next run of constants modified after 'since', at or beyond 'first'
+		bool next(uint64_t since, int &first, int &count) const
+		{
+			while(first < N && version[first] <= since)
+			{
+				first = (latest[first / 32] <= since) ? (first / 32 + 1) * 32 : first + 1;
+			}
+
+			if(first >= N)
+			{
+				return false;
+			}
+
+			for(count = 1; first + count < N && version[first + count] > since; count++)
+			{
+			}
+
+			return true;
+		}
+
+	private:
+		enum {GROUPS = (N + 31) / 32};
+		uint64_t version[N];
+		uint64_t latest[GROUPS];   // Most recent modification within each group of 32 constants
+	};
+
 	struct DrawCall
 	{
 		DrawCall();
@@ -223,6 +313,7 @@ namespace sw
 
 		int (Renderer::*setupPrimitives)(int batch, int count);
 		SetupProcessor::State setupState;
+		bool profile;   // Routines update DrawData's timers and counters
 
 		Resource *vertexStream[MAX_VERTEX_INPUTS];
 		Resource *indexBuffer;
@@ -234,18 +325,18 @@ namespace sw
 		Resource* vUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
 		Resource* transformFeedbackBuffers[MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS];
 
-		int vsDirtyConstF;
-		int vsDirtyConstI;
-		int vsDirtyConstB;
-
-		int psDirtyConstF;
-		int psDirtyConstI;
-		int psDirtyConstB;
+		uint64_t vsConstantSerial;   // Constants modified later than this have to be copied, 0 copies all
+		uint64_t psConstantSerial;
 
 		std::list<Query*> *queries;
+		std::list<Fence*> *fences;   // Signaled on completion
 
 		int clipFlags;
 
+		bool blit;   // Executes blitOperation in row bands instead of the pipeline
+		Blitter::Operation blitOperation;
+		Resource *pixelBuffer;   // Holds the blit's destination memory
+
 		volatile int primitive;    // Current primitive to enter pipeline
 		volatile int count;        // Number of primitives to render
 		volatile int references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
@@ -271,6 +362,7 @@ namespace sw
 			{
 				PRIMITIVES,
 				PIXELS,
+				BLIT,
 
 				RESUME,
 				SUSPEND
@@ -289,6 +381,7 @@ namespace sw
 				firstPrimitive = 0;
 				primitiveCount = 0;
 				visible = 0;
+				clusters = 0;
 				references = 0;
 			}
 
@@ -296,6 +389,7 @@ namespace sw
 			volatile int firstPrimitive;
 			volatile int primitiveCount;
 			volatile int visible;
+			volatile unsigned int clusters;   // Bit mask of the pixel clusters which have rows covered by the batch
 			volatile int references;
 		};
 
@@ -324,6 +418,7 @@ namespace sw
 		void clear(void* pixel, Format format, Surface *dest, const SliceRect &dRect, unsigned int rgbaMask);
 		void blit(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, bool filter, bool isStencil = false);
 		void blit3D(Surface *source, Surface *dest);
+		void readPixels(Surface *source, const SliceRect &sRect, Surface *dest, const SliceRect &dRect, Resource *pixelBuffer);   // Takes ownership of dest
 		void draw(DrawType drawType, unsigned int indexOffset, unsigned int count, bool update = true);
 
 		void setIndexBuffer(Resource *indexBuffer);
@@ -388,17 +483,16 @@ namespace sw
 
 		void addQuery(Query *query);
 		void removeQuery(Query *query);
+		void addFence(Fence *fence);
 
 		void synchronize();
 
-		#if PERF_HUD
-			// Performance timers
-			int getThreadCount();
-			int64_t getVertexTime(int thread);
-			int64_t getSetupTime(int thread);
-			int64_t getPixelTime(int thread);
-			void resetTimers();
-		#endif
+		// Performance timers, only updated when profiling
+		int getThreadCount();
+		int64_t getVertexTime(int thread);
+		int64_t getSetupTime(int thread);
+		int64_t getPixelTime(int thread);
+		void resetTimers();
 
 	private:
 		static void threadFunction(void *parameters);
@@ -408,6 +502,14 @@ namespace sw
 		void scheduleTask(int threadIndex);
 		void executeTask(int threadIndex);
 		void finishRendering(Task &pixelTask);
+		void executeBlit(int unit);
+		void finishDrawCall(DrawCall &draw);
+		bool isPipelineIdle();
+		bool releaseReference(int unit);
+
+		DrawCall *acquireDrawCall();
+		void queueBlit(DrawCall *draw);
+		void queueDrawCall();
 
 		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
 
@@ -417,6 +519,9 @@ namespace sw
 		int setupLines(int batch, int count);
 		int setupPoints(int batch, int count);
 
+		int cullTriangles(const Triangle *triangle, int count, const DrawCall &draw, int *survivor);
+		unsigned int coveredClusters(int unit, int visible);
+
 		bool setupLine(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 		bool setupPoint(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 
@@ -454,12 +559,24 @@ namespace sw
 		PixelProgress pixelProgress[16];
 		Task task[16];   // Current tasks for threads
 
-		enum {DRAW_COUNT = 16};   // Number of draw calls buffered
-		DrawCall *drawCall[DRAW_COUNT];
-		DrawCall *drawList[DRAW_COUNT];
+		enum {DRAW_COUNT = 16};         // Number of draw calls preallocated
+		enum {MAX_DRAW_COUNT = 1024};   // Upper limit of draw calls buffered, a power of two
+		std::vector<DrawCall*> drawCall;   // Grows on demand, up to maxDrawCount
+		DrawCall *drawList[MAX_DRAW_COUNT];
+		size_t maxDrawCount;   // Limited by the draw queue memory budget
+		size_t freeDraw;       // Where to start looking for an available draw call
+
+		uint64_t constantSerial;   // Incremented on each constant update
+		ConstantVersions<VERTEX_UNIFORM_VECTORS + 1> vsConstantVersionF;
+		ConstantVersions<16> vsConstantVersionI;
+		ConstantVersions<16> vsConstantVersionB;
+		ConstantVersions<FRAGMENT_UNIFORM_VECTORS> psConstantVersionF;
+		ConstantVersions<16> psConstantVersionI;
+		ConstantVersions<16> psConstantVersionB;
 
 		volatile int currentDraw;
 		volatile int nextDraw;
+		bool followsBlit;   // The current draw call can't start before the preceding blit has completed
 
 		Task taskQueue[32];
 		unsigned int qHead;
@@ -467,11 +584,9 @@ namespace sw
 
 		MutexLock schedulerMutex;
 
-		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
-		#endif
+		int64_t vertexTime[16];
+		int64_t setupTime[16];
+		int64_t pixelTime[16];
 
 		VertexTask *vertexTask[16];
 
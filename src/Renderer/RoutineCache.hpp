@@ -18,6 +18,7 @@
 #include "LRUCache.hpp"
 
 #include "Reactor/Reactor.hpp"
+#include "Reactor/ExecutableMemory.hpp"
 
 namespace sw
 {
@@ -28,6 +29,8 @@ namespace sw
 		RoutineCache(int n, const char *precache = 0);
 		~RoutineCache();
 
+		Routine *add(const State &state, Routine *routine);
+
 	private:
 		const char *precache;
 		#if defined(_WIN32)
@@ -44,6 +47,21 @@ namespace sw
 	RoutineCache<State>::~RoutineCache()
 	{
 	}
+
+	template<class State>
+	Routine *RoutineCache<State>::add(const State &state, Routine *routine)
+	{
+		LRUCache<State, Routine>::add(state, routine);
+
+		// Evicted routines are only freed once no longer bound by pending draw calls,
+		// so evict gradually instead of until the budget is met.
+		for(int i = 0; i < 2 && executableMemoryBudgetExceeded(); i++)
+		{
+			LRUCache<State, Routine>::evict();
+		}
+
+		return routine;
+	}
 }
 
 #endif   // sw_RoutineCache_hpp
@@ -97,10 +97,7 @@ namespace sw
 			state.swizzleG = swizzleG;
 			state.swizzleB = swizzleB;
 			state.swizzleA = swizzleA;
-
-			#if PERF_PROFILE
-				state.compressedFormat = Surface::isCompressed(externalTextureFormat);
-			#endif
+			state.compressedFormat = profiler.enabled && Surface::isCompressed(externalTextureFormat);
 		}
 
 		return state;
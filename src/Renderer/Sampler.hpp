@@ -141,9 +141,7 @@ namespace sw
 			SwizzleType swizzleB           : BITS(SWIZZLE_LAST);
 			SwizzleType swizzleA           : BITS(SWIZZLE_LAST);
 
-			#if PERF_PROFILE
-			bool compressedFormat          : 1;
-			#endif
+			bool compressedFormat          : 1;   // Only set when profiling
 		};
 
 		Sampler();
@@ -21,6 +21,7 @@
 #include "Renderer.hpp"
 #include "Constants.hpp"
 #include "Debug.hpp"
+#include "Trace.hpp"
 
 namespace sw
 {
@@ -229,12 +230,20 @@ namespace sw
 
 		if(!routine)
 		{
+			TraceScope trace("Compile setup routine");
+			int64_t startTime = Timer::counter();
+
 			SetupRoutine *generator = new SetupRoutine(state);
 			generator->generate();
 			routine = generator->getRoutine();
 			delete generator;
 
 			routineCache->add(state, routine);
+			profiler.routineCompiled(ROUTINE_SETUP, Timer::counter() - startTime);
+		}
+		else
+		{
+			atomicAdd(&profiler.routineHits[ROUTINE_SETUP], (int64_t)1);
 		}
 
 		return routine;
@@ -23,6 +23,7 @@
 #include "Common/CPUID.hpp"
 #include "Common/Resource.hpp"
 #include "Common/Debug.hpp"
+#include "Common/Trace.hpp"
 #include "Reactor/Reactor.hpp"
 
 #if defined(__i386__) || defined(__x86_64__)
@@ -1202,6 +1203,7 @@ namespace sw
 		resource = new Resource(0);
 		hasParent = false;
 		ownExternal = false;
+		ownInternal = true;
 		depth = max(1, depth);
 
 		external.buffer = pixels;
@@ -1252,6 +1254,7 @@ namespace sw
 		resource = texture ? texture : new Resource(0);
 		hasParent = texture != 0;
 		ownExternal = true;
+		ownInternal = true;
 		depth = max(1, depth);
 
 		external.buffer = 0;
@@ -1310,21 +1313,33 @@ namespace sw
 
 		if(ownExternal)
 		{
-			deallocate(external.buffer);
+			deallocateBuffer(external);
 		}
 
-		if(internal.buffer != external.buffer)
+		if(ownInternal && internal.buffer != external.buffer)
 		{
-			deallocate(internal.buffer);
+			deallocateBuffer(internal);
 		}
 
-		deallocate(stencil.buffer);
+		deallocateBuffer(stencil);
 
 		external.buffer = 0;
 		internal.buffer = 0;
 		stencil.buffer = 0;
 	}
 
+	void Surface::setClientBuffer(void *pixels, int pitchB)
+	{
+		ASSERT(!internal.buffer && internal.depth == 1);
+
+		internal.buffer = pixels;
+		internal.pitchB = pitchB;
+		internal.pitchP = pitchB / internal.bytes;
+		internal.sliceB = pitchB * internal.height;
+		internal.sliceP = internal.pitchP * internal.height;
+		ownInternal = false;
+	}
+
 	void *Surface::lockExternal(int x, int y, int z, Lock lock, Accessor client)
 	{
 		resource->lock(client);
@@ -3108,6 +3123,23 @@ namespace sw
 	}
 
 	void *Surface::allocateBuffer(int width, int height, int depth, Format format)
+	{
+		size_t bytes = bufferSize(width, height, depth, format);
+		atomicAdd(&profiler.surfaceMemory, (int64_t)bytes);
+
+		return allocateZero(bytes);
+	}
+
+	void Surface::deallocateBuffer(Buffer &buffer)
+	{
+		if(buffer.buffer)
+		{
+			atomicAdd(&profiler.surfaceMemory, -(int64_t)bufferSize(buffer.width, buffer.height, buffer.depth, buffer.format));
+			deallocate(buffer.buffer);
+		}
+	}
+
+	size_t Surface::bufferSize(int width, int height, int depth, Format format)
 	{
 		// Render targets require 2x2 quads
 		int width2 = (width + 1) & ~1;
@@ -3116,7 +3148,7 @@ namespace sw
 		// FIXME: Unpacking byte4 to short4 in the sampler currently involves reading 8 bytes,
 		// and stencil operations also read 8 bytes per four 8-bit stencil values,
 		// so we have to allocate 4 extra bytes to avoid buffer overruns.
-		return allocateZero(size(width2, height2, depth, format) + 4);
+		return size(width2, height2, depth, format) + 4;
 	}
 
 	void Surface::memfill4(void *buffer, int pattern, int bytes)
@@ -3782,6 +3814,10 @@ namespace sw
 			return;
 		}
 
+		TraceScope trace("Resolve");
+		ProfilerTimer timer(&profiler.resolveTime);
+		atomicAdd(&profiler.resolves, (int64_t)1);
+
 		void *source = internal.lockRect(0, 0, 0, LOCK_READWRITE);
 
 		int width = internal.width;
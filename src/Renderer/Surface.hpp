@@ -254,6 +254,10 @@ namespace sw
 		Surface(int width, int height, int depth, Format format, void *pixels, int pitch, int slice);
 		Surface(Resource *texture, int width, int height, int depth, Format format, bool lockable, bool renderTarget, int pitchP = 0);
 
+		// Makes the internal buffer use client memory, which must outlive the surface.
+		// A negative pitch denotes rows stored bottom-up.
+		void setClientBuffer(void *pixels, int pitchB);
+
 	public:
 		static Surface *create(int width, int height, int depth, Format format, void *pixels, int pitch, int slice);
 		static Surface *create(Resource *texture, int width, int height, int depth, Format format, bool lockable, bool renderTarget, int pitchP = 0);
@@ -454,6 +458,8 @@ namespace sw
 		static void update(Buffer &destination, Buffer &source);
 		static void genericUpdate(Buffer &destination, Buffer &source);
 		static void *allocateBuffer(int width, int height, int depth, Format format);
+		static void deallocateBuffer(Buffer &buffer);
+		static size_t bufferSize(int width, int height, int depth, Format format);
 		static void memfill4(void *buffer, int pattern, int bytes);
 
 		bool identicalFormats() const;
@@ -476,6 +482,7 @@ namespace sw
 
 		bool hasParent;
 		bool ownExternal;
+		bool ownInternal;
 	};
 }
 
@@ -21,6 +21,7 @@
 #include "PixelShader.hpp"
 #include "Constants.hpp"
 #include "Debug.hpp"
+#include "Trace.hpp"
 
 #include <string.h>
 
@@ -901,6 +902,7 @@ namespace sw
 		if(context->vertexShader)
 		{
 			state.shaderID = context->vertexShader->getSerialID();
+			context->vertexShader->specialize(state.specialization, c, i, b);
 		}
 		else
 		{
@@ -909,6 +911,7 @@ namespace sw
 
 		state.fixedFunction = !context->vertexShader && context->pixelShaderVersion() < 0x0300;
 		state.textureSampling = context->vertexShader ? context->vertexShader->containsTextureSampling() : false;
+		state.profile = profiler.enabled;
 		state.positionRegister = context->vertexShader ? context->vertexShader->getPositionRegister() : Pos;
 		state.pointSizeRegister = context->vertexShader ? context->vertexShader->getPointSizeRegister() : Pts;
 
@@ -1068,6 +1071,9 @@ namespace sw
 
 		if(!routine)   // Create one
 		{
+			TraceScope trace("Compile vertex routine");
+			int64_t startTime = Timer::counter();
+
 			VertexRoutine *generator = nullptr;
 
 			if(state.fixedFunction)
@@ -1084,6 +1090,11 @@ namespace sw
 			delete generator;
 
 			routineCache->add(state, routine);
+			profiler.routineCompiled(ROUTINE_VERTEX, Timer::counter() - startTime);
+		}
+		else
+		{
+			atomicAdd(&profiler.routineHits[ROUTINE_VERTEX], (int64_t)1);
 		}
 
 		return routine;
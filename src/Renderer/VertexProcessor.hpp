@@ -49,9 +49,11 @@ namespace sw
 			unsigned int computeHash();
 
 			uint64_t shaderID;
+			Shader::Specialization specialization;
 
 			bool fixedFunction             : 1;
 			bool textureSampling           : 1;
+			bool profile                   : 1;   // Counts operations
 			unsigned int positionRegister  : BITS(MAX_VERTEX_OUTPUTS);
 			unsigned int pointSizeRegister : BITS(MAX_VERTEX_OUTPUTS);
 
@@ -96,6 +96,10 @@ namespace sw
 		dword minY[16];
 		dword minZ[16];
 		dword fini[16];
+		dword guard[16];
+
+		unsigned char spanLeft[256];    // Index of the first set bit of an 8-bit coverage mask
+		unsigned char spanRight[256];   // Index past the last set bit
 
 		dword4 maxPos;
 
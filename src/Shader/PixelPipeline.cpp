@@ -1227,9 +1227,12 @@ namespace sw
 
 	void PixelPipeline::sampleTexture(Vector4s &c, int stage, Float4 &u, Float4 &v, Float4 &w, Float4 &q, bool project)
 	{
-		#if PERF_PROFILE
-			Long texTime = Ticks();
-		#endif
+		Long texTime;
+
+		if(state.profile)
+		{
+			texTime = Ticks();
+		}
 
 		Vector4f dsx;
 		Vector4f dsy;
@@ -1251,9 +1254,17 @@ namespace sw
 			sampler[stage]->sampleTexture(texture, c, u_q, v_q, w_q, q, dsx, dsy);
 		}
 
-		#if PERF_PROFILE
+		if(state.profile)
+		{
 			cycles[PERF_TEX] += Ticks() - texTime;
-		#endif
+
+			addCounter(PERF_TEXTURE_OPERATIONS, 4);
+
+			if(state.sampler[stage].compressedFormat)
+			{
+				addCounter(PERF_COMPRESSED_TEXTURE_OPERATIONS, 4);
+			}
+		}
 	}
 
 	Short4 PixelPipeline::convertFixed12(RValue<Float4> cf)
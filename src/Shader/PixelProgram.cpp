@@ -710,16 +710,27 @@ namespace sw
 
 	void PixelProgram::sampleTexture(Vector4f &c, int samplerIndex, Vector4f &uvwq, Vector4f &dsx, Vector4f &dsy, Vector4f &offset, SamplerFunction function)
 	{
-		#if PERF_PROFILE
-			Long texTime = Ticks();
-		#endif
+		Long texTime;
+
+		if(state.profile)
+		{
+			texTime = Ticks();
+		}
 
 		Pointer<Byte> texture = data + OFFSET(DrawData, mipmap) + samplerIndex * sizeof(Texture);
 		sampler[samplerIndex]->sampleTexture(texture, c, uvwq.x, uvwq.y, uvwq.z, uvwq.w, dsx, dsy, offset, function);
 
-		#if PERF_PROFILE
+		if(state.profile)
+		{
 			cycles[PERF_TEX] += Ticks() - texTime;
-		#endif
+
+			addCounter(PERF_TEXTURE_OPERATIONS, 4);
+
+			if(state.sampler[samplerIndex].compressedFormat)
+			{
+				addCounter(PERF_COMPRESSED_TEXTURE_OPERATIONS, 4);
+			}
+		}
 	}
 
 	void PixelProgram::clampColor(Vector4f oC[RENDERTARGETS])
@@ -952,6 +963,34 @@ namespace sw
 		return uniformAddress(bufferIndex, index) + offset * sizeof(float4);
 	}
 
+	RValue<Bool> PixelProgram::readBoolean(const Src &boolRegister)
+	{
+		const Shader::Specialization &specialization = state.specialization;
+
+		if(boolRegister.type == Shader::PARAMETER_CONST)   // Specialized 'if' condition
+		{
+			return Bool((specialization.conditionValues & (1 << shader->getConditionIndex(boolRegister))) != 0);
+		}
+		else if(specialization.booleanMask & (1 << boolRegister.index))
+		{
+			return Bool((specialization.booleanValues & (1 << boolRegister.index)) != 0);
+		}
+
+		return *Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0);   // FIXME
+	}
+
+	RValue<Int> PixelProgram::readInteger(const Src &integerRegister, int component)
+	{
+		const Shader::Specialization &specialization = state.specialization;
+
+		if(specialization.integerMask & (1 << integerRegister.index))
+		{
+			return Int(specialization.integer[integerRegister.index][component]);
+		}
+
+		return *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][component]));
+	}
+
 	Vector4f PixelProgram::readConstant(const Src &src, unsigned int offset)
 	{
 		Vector4f c;
@@ -1352,7 +1391,7 @@ namespace sw
 
 	void PixelProgram::CALLNZb(int labelIndex, int callSiteIndex, const Src &boolRegister)
 	{
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = readBoolean(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1513,6 +1552,8 @@ namespace sw
 
 	void PixelProgram::IF(const Src &src)
 	{
+		int conditionIndex = shader->getConditionIndex(src);
+
 		if(src.type == Shader::PARAMETER_CONSTBOOL)
 		{
 			IFb(src);
@@ -1521,6 +1562,10 @@ namespace sw
 		{
 			IFp(src);
 		}
+		else if(conditionIndex != -1 && (state.specialization.conditionMask & (1 << conditionIndex)))   // Uniform folded into the routine
+		{
+			IFb(src);
+		}
 		else
 		{
 			Int4 condition = As<Int4>(fetchRegister(src).x);
@@ -1532,7 +1577,7 @@ namespace sw
 	{
 		ASSERT(ifDepth < 24 + 4);
 
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData, ps.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = readBoolean(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1617,9 +1662,9 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][0]));
-		aL[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][1]));
-		increment[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][2]));
+		iteration[loopDepth] = readInteger(integerRegister, 0);
+		aL[loopDepth] = readInteger(integerRegister, 1);
+		increment[loopDepth] = readInteger(integerRegister, 2);
 
 		//	If(increment[loopDepth] == 0)
 		//	{
@@ -1650,7 +1695,7 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData, ps.i[integerRegister.index][0]));
+		iteration[loopDepth] = readInteger(integerRegister, 0);
 		aL[loopDepth] = aL[loopDepth - 1];
 
 		BasicBlock *loopBlock = Nucleus::createBasicBlock();
@@ -53,9 +53,12 @@ namespace sw
 
 	void PixelRoutine::quad(Pointer<Byte> cBuffer[RENDERTARGETS], Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int cMask[4], Int &x, Int &y)
 	{
-		#if PERF_PROFILE
-			Long pipeTime = Ticks();
-		#endif
+		Long pipeTime;
+
+		if(state.profile)
+		{
+			pipeTime = Ticks();
+		}
 
 		for(int i = 0; i < TEXTURE_IMAGE_UNITS; i++)
 		{
@@ -110,9 +113,12 @@ namespace sw
 
 		If(depthPass || Bool(!earlyDepthTest))
 		{
-			#if PERF_PROFILE
-				Long interpTime = Ticks();
-			#endif
+			Long interpTime;
+
+			if(state.profile)
+			{
+				interpTime = Ticks();
+			}
 
 			Float4 yyyy = Float4(Float(y)) + *Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16);
 
@@ -198,23 +204,28 @@ namespace sw
 
 			setBuiltins(x, y, z, w);
 
-			#if PERF_PROFILE
+			if(state.profile)
+			{
 				cycles[PERF_INTERP] += Ticks() - interpTime;
-			#endif
+			}
 
 			Bool alphaPass = true;
 
 			if(colorUsed())
 			{
-				#if PERF_PROFILE
-					Long shaderTime = Ticks();
-				#endif
+				Long shaderTime;
+
+				if(state.profile)
+				{
+					shaderTime = Ticks();
+				}
 
 				applyShader(cMask);
 
-				#if PERF_PROFILE
+				if(state.profile)
+				{
 					cycles[PERF_SHADER] += Ticks() - shaderTime;
-				#endif
+				}
 
 				alphaPass = alphaTest(cMask);
 
@@ -238,9 +249,12 @@ namespace sw
 					}
 				}
 
-				#if PERF_PROFILE
-					Long ropTime = Ticks();
-				#endif
+				Long ropTime;
+
+				if(state.profile)
+				{
+					ropTime = Ticks();
+				}
 
 				If(depthPass || Bool(earlyDepthTest))
 				{
@@ -259,17 +273,16 @@ namespace sw
 
 					if(colorUsed())
 					{
-						#if PERF_PROFILE
-							AddAtomic(Pointer<Long>(&profiler.ropOperations), 4);
-						#endif
+						addCounter(PERF_RASTER_OPERATIONS, 4);
 
 						rasterOperation(f, cBuffer, x, sMask, zMask, cMask);
 					}
 				}
 
-				#if PERF_PROFILE
+				if(state.profile)
+				{
 					cycles[PERF_ROP] += Ticks() - ropTime;
-				#endif
+				}
 			}
 		}
 
@@ -281,9 +294,10 @@ namespace sw
 			}
 		}
 
-		#if PERF_PROFILE
+		if(state.profile)
+		{
 			cycles[PERF_PIPE] += Ticks() - pipeTime;
-		#endif
+		}
 	}
 
 	Float4 PixelRoutine::interpolateCentroid(Float4 &x, Float4 &y, Float4 &rhw, Pointer<Byte> planeEquation, bool flat, bool perspective)
@@ -304,6 +318,42 @@ namespace sw
 		return interpolant;
 	}
 
+	Bool PixelRoutine::occluded(Pointer<Byte> &zBuffer, Pointer<Byte> &sBuffer, Int &x, Float4 &xxxx)
+	{
+		Int pass = 0;
+
+		for(unsigned int q = 0; q < state.multiSample; q++)
+		{
+			Int cMask = 0xF;   // Also tests the pixels not covered by the primitive
+			Int sMask = cMask;
+			Int zMask = cMask;
+
+			if(earlyStencilRejection())
+			{
+				stencilTest(sBuffer, q, x, sMask, cMask);
+				zMask = sMask;
+			}
+
+			if(earlyDepthRejection())
+			{
+				Float4 X = xxxx;
+
+				if(state.multiSample > 1)
+				{
+					X -= *Pointer<Float4>(constants + OFFSET(Constants,X) + q * sizeof(float4));
+				}
+
+				Float4 Z = interpolate(X, Dz[q], Z, primitive + OFFSET(Primitive,z), false, false);
+
+				depthTest(zBuffer, q, x, Z, sMask, zMask, cMask);
+			}
+
+			pass |= zMask;
+		}
+
+		return pass == 0;
+	}
+
 	void PixelRoutine::stencilTest(Pointer<Byte> &sBuffer, int q, Int &x, Int &sMask, Int &cMask)
 	{
 		if(!state.stencilActive)
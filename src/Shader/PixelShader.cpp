@@ -15,6 +15,7 @@
 #include "PixelShader.hpp"
 
 #include "Debug.hpp"
+#include "Serializer.hpp"
 
 #include <string.h>
 
@@ -22,6 +23,7 @@ namespace sw
 {
 	PixelShader::PixelShader(const PixelShader *ps) : Shader()
 	{
+		shaderType = SHADER_PIXEL;
 		version = 0x0300;
 		vPosDeclared = false;
 		vFaceDeclared = false;
@@ -151,6 +153,38 @@ namespace sw
 		return input[inputIdx][component];
 	}
 
+	void PixelShader::serialize(Serializer &stream) const
+	{
+		serializeInstructions(stream);
+
+		stream.write(input);
+		stream.write(vPosDeclared);
+		stream.write(vFaceDeclared);
+	}
+
+	bool PixelShader::deserialize(Deserializer &stream, bool optimized)
+	{
+		ASSERT(getLength() == 0);
+
+		deserializeInstructions(stream);
+
+		stream.read(input);
+		stream.read(vPosDeclared);
+		stream.read(vFaceDeclared);
+
+		if(!stream.isValid())
+		{
+			return false;
+		}
+
+		if(optimized)
+		{
+			analyze();
+		}
+
+		return true;
+	}
+
 	void PixelShader::analyze()
 	{
 		analyzeZOverride();
@@ -161,6 +195,7 @@ namespace sw
 		analyzeSamplers();
 		analyzeCallSites();
 		analyzeDynamicIndexing();
+		analyzeSpecialization();
 	}
 
 	void PixelShader::analyzeZOverride()
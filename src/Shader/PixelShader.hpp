@@ -39,6 +39,9 @@ namespace sw
 		void setInput(int inputIdx, int nbComponents, const Semantic& semantic);
 		const Semantic& getInput(int inputIdx, int component) const;
 
+		void serialize(Serializer &stream) const;
+		bool deserialize(Deserializer &stream, bool optimized);   // Optimized shaders also get analyzed, as on construction
+
 		void declareVPos() { vPosDeclared = true; }
 		void declareVFace() { vFaceDeclared = true; }
 		bool isVPosDeclared() const { return vPosDeclared; }
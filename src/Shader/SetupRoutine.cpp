@@ -197,6 +197,19 @@ namespace sw
 			yMin = Max(yMin, *Pointer<Int>(data + OFFSET(DrawData,scissorY0)));
 			yMax = Min(yMax, *Pointer<Int>(data + OFFSET(DrawData,scissorY1)));
 
+			// Small triangles within the scissor rectangle get their outline from edge functions
+			Bool small = false;
+			Int xMin;
+
+			if(solidTriangle && state.multiSample == 1)
+			{
+				xMin = (Min(Min(X[0], X[1]), X[2]) + 0x0F) >> 4;
+				Int xMax = (Max(Max(X[0], X[1]), X[2]) + 0x0F) >> 4;
+
+				small = n == 3 && xMax - xMin <= SMALL_TRIANGLE && yMax - yMin <= SMALL_TRIANGLE &&
+				        xMin >= *Pointer<Int>(data + OFFSET(DrawData,scissorX0)) && xMax <= *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+			}
+
 			For(Int q = 0, q < state.multiSample, q++)
 			{
 				Array<Int> Xq(16);
@@ -237,6 +250,33 @@ namespace sw
 				Yq[n] = Yq[0];
 
 				// Rasterize
+				If(small)
+				{
+					// Compute the coverage of all columns of each row at once, instead of stepping along each edge
+					Int4 E0[3];
+					Int4 E1[3];
+					Int4 step[3];
+
+					for(int i = 0; i < 3; i++)
+					{
+						edgeFunction(Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], xMin, yMin, E0[i], E1[i], step[i]);
+					}
+
+					For(Int y = yMin, y < yMax, y++)
+					{
+						Int mask = SignMask(~(E0[0] | E0[1] | E0[2])) | (SignMask(~(E1[0] | E1[1] | E1[2])) << 4);
+
+						*Pointer<Short>(leftEdge + y * sizeof(Primitive::Span)) = Short(xMin + Int(*Pointer<Byte>(constants + OFFSET(Constants,spanLeft) + mask)));
+						*Pointer<Short>(rightEdge + y * sizeof(Primitive::Span)) = Short(xMin + Int(*Pointer<Byte>(constants + OFFSET(Constants,spanRight) + mask)));
+
+						for(int i = 0; i < 3; i++)
+						{
+							E0[i] += step[i];
+							E1[i] += step[i];
+						}
+					}
+				}
+				Else
 				{
 					Int i = 0;
 
@@ -620,6 +660,26 @@ namespace sw
 		}
 	}
 
+	void SetupRoutine::edgeFunction(const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, const Int &x, const Int &y, Int4 &E0, Int4 &E1, Int4 &step)
+	{
+		// Non-negative for covered pixels. Matches the outline's rule of including pixels
+		// exactly on a left edge, but not those on a right edge.
+		Int DX = Xb - Xa;
+		Int DY = Yb - Ya;
+
+		Int A = DY << 4;
+		Int B = -(DX << 4);
+		Int C = DX * Ya - DY * Xa + (DY >> 31);
+
+		// Horizontal edges are already accounted for by the vertical range
+		B = IfThenElse(DY != 0, B, Int(0));
+		C = IfThenElse(DY != 0, C, Int(0));
+
+		E0 = Int4(A * x + B * y + C) + Int4(A) * Int4(0, 1, 2, 3);
+		E1 = E0 + Int4(A << 2);
+		step = Int4(B);
+	}
+
 	void SetupRoutine::conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2)
 	{
 		#if 0   // Rely on LLVM optimization
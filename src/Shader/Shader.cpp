@@ -18,15 +18,367 @@
 #include "PixelShader.hpp"
 #include "Math.hpp"
 #include "Debug.hpp"
+#include "Serializer.hpp"
+#include "Thread.hpp"
+#include "Version.h"
 
 #include <set>
 #include <fstream>
 #include <sstream>
+#include <cmath>
+#include <cfloat>
 #include <stdarg.h>
+#include <string.h>
+
+namespace
+{
+	using sw::Shader;
+
+	// Each component of the result only depends on the same component of the (swizzled) sources
+	bool isComponentWise(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_MOV:
+		case Shader::OPCODE_NEG:
+		case Shader::OPCODE_ADD:
+		case Shader::OPCODE_SUB:
+		case Shader::OPCODE_MUL:
+		case Shader::OPCODE_MAD:
+		case Shader::OPCODE_MIN:
+		case Shader::OPCODE_MAX:
+		case Shader::OPCODE_SLT:
+		case Shader::OPCODE_SGE:
+		case Shader::OPCODE_LRP:
+		case Shader::OPCODE_FRC:
+		case Shader::OPCODE_TRUNC:
+		case Shader::OPCODE_FLOOR:
+		case Shader::OPCODE_ROUND:
+		case Shader::OPCODE_ROUNDEVEN:
+		case Shader::OPCODE_CEIL:
+		case Shader::OPCODE_ABS:
+		case Shader::OPCODE_SQRT:
+		case Shader::OPCODE_CMP0:
+		case Shader::OPCODE_SELECT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool isControlFlow(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_CALL:
+		case Shader::OPCODE_CALLNZ:
+		case Shader::OPCODE_LABEL:
+		case Shader::OPCODE_RET:
+		case Shader::OPCODE_LEAVE:
+		case Shader::OPCODE_LOOP:
+		case Shader::OPCODE_ENDLOOP:
+		case Shader::OPCODE_REP:
+		case Shader::OPCODE_ENDREP:
+		case Shader::OPCODE_WHILE:
+		case Shader::OPCODE_ENDWHILE:
+		case Shader::OPCODE_IF:
+		case Shader::OPCODE_IFC:
+		case Shader::OPCODE_ELSE:
+		case Shader::OPCODE_ENDIF:
+		case Shader::OPCODE_BREAK:
+		case Shader::OPCODE_BREAKC:
+		case Shader::OPCODE_BREAKP:
+		case Shader::OPCODE_CONTINUE:
+		case Shader::OPCODE_TEST:
+		case Shader::OPCODE_SWITCH:
+		case Shader::OPCODE_ENDSWITCH:
+		case Shader::OPCODE_PHASE:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Number of consecutive registers read by the second operand of matrix instructions
+	int matrixRows(Shader::Opcode opcode)
+	{
+		switch(opcode)
+		{
+		case Shader::OPCODE_M4X4: return 4;
+		case Shader::OPCODE_M4X3: return 3;
+		case Shader::OPCODE_M3X4: return 4;
+		case Shader::OPCODE_M3X3: return 3;
+		case Shader::OPCODE_M3X2: return 2;
+		default:                  return 1;
+		}
+	}
+
+	bool isLiteral(const Shader::Parameter &parameter)
+	{
+		return parameter.type == Shader::PARAMETER_FLOAT4LITERAL ||
+		       parameter.type == Shader::PARAMETER_BOOL1LITERAL ||
+		       parameter.type == Shader::PARAMETER_INT4LITERAL;
+	}
+
+	bool isRelative(const Shader::Parameter &parameter)
+	{
+		// The relative addressing fields overlap with the value of literals
+		return !isLiteral(parameter) && parameter.rel.type != Shader::PARAMETER_VOID;
+	}
+
+	bool writesTemporary(const Shader::Instruction &instruction)
+	{
+		return instruction.dst.type == Shader::PARAMETER_TEMP &&
+		       instruction.opcode != Shader::OPCODE_TEXKILL &&   // Takes destination as input
+		       instruction.opcode != Shader::OPCODE_NULL &&
+		       !isControlFlow(instruction.opcode);
+	}
+
+	// Components of the source register which affect the written components
+	int readMask(const Shader::Instruction &instruction, int i)
+	{
+		int mask = isComponentWise(instruction.opcode) ? instruction.dst.mask : 0xF;
+		int swizzle = instruction.src[i].swizzle;
+		int read = 0;
+
+		for(int c = 0; c < 4; c++)
+		{
+			if(mask & (1 << c))
+			{
+				read |= 1 << ((swizzle >> (2 * c)) & 0x3);
+			}
+		}
+
+		return read;
+	}
+
+	void markTemporaryReads(const Shader::Instruction &instruction, std::vector<unsigned char> &live)
+	{
+		if(instruction.opcode == Shader::OPCODE_NULL)
+		{
+			return;
+		}
+
+		if(instruction.dst.type == Shader::PARAMETER_TEMP && !writesTemporary(instruction))
+		{
+			live[instruction.dst.index] = 0xF;
+		}
+
+		if(isRelative(instruction.dst) && instruction.dst.rel.type == Shader::PARAMETER_TEMP)
+		{
+			live[instruction.dst.rel.index] = 0xF;
+		}
+
+		for(int i = 0; i < 5; i++)
+		{
+			const Shader::SourceParameter &src = instruction.src[i];
+
+			if(src.type == Shader::PARAMETER_TEMP)
+			{
+				int rows = (i == 1) ? matrixRows(instruction.opcode) : 1;
+
+				for(int row = 0; row < rows; row++)
+				{
+					live[src.index + row] |= readMask(instruction, i);
+				}
+			}
+
+			if(isRelative(src) && src.rel.type == Shader::PARAMETER_TEMP)
+			{
+				live[src.rel.index] = 0xF;
+			}
+		}
+	}
+
+	// Values of a literal or DEF constant operand, after swizzling and modifiers
+	bool constantValue(const std::vector<Shader::Instruction*> &instruction, const Shader::SourceParameter &src, float value[4])
+	{
+		const float *reg = nullptr;
+
+		if(src.type == Shader::PARAMETER_FLOAT4LITERAL)
+		{
+			reg = src.value;
+		}
+		else if(src.type == Shader::PARAMETER_CONST && !isRelative(src) && src.bufferIndex == -1)
+		{
+			for(size_t i = 0; i < instruction.size(); i++)   // Must match PixelProgram/VertexProgram::readConstant()
+			{
+				if(instruction[i]->opcode == Shader::OPCODE_DEF && instruction[i]->dst.index == src.index)
+				{
+					reg = instruction[i]->src[0].value;
+					break;
+				}
+			}
+		}
+
+		if(!reg)
+		{
+			return false;
+		}
+
+		for(int c = 0; c < 4; c++)
+		{
+			float x = reg[(src.swizzle >> (2 * c)) & 0x3];
+
+			switch(src.modifier)
+			{
+			case Shader::MODIFIER_NONE:                             break;
+			case Shader::MODIFIER_NEGATE:     x = -x;               break;
+			case Shader::MODIFIER_ABS:        x = std::fabs(x);     break;
+			case Shader::MODIFIER_ABS_NEGATE: x = -std::fabs(x);    break;
+			default:
+				return false;
+			}
+
+			value[c] = x;
+		}
+
+		return true;
+	}
+
+	bool isKnownOpcode(Shader::Opcode opcode)
+	{
+		return (opcode >= Shader::OPCODE_NOP && opcode <= Shader::OPCODE_DEFI) ||
+		       (opcode >= Shader::OPCODE_TEXCOORD && opcode <= Shader::OPCODE_TEXSIZE) ||
+		       (opcode >= Shader::OPCODE_NULL && opcode <= Shader::OPCODE_UMAX);
+	}
+
+	// Number of registers of the given type addressable by VertexProgram/PixelProgram, 0 if unsupported
+	unsigned int registerCount(Shader::ShaderType shaderType, Shader::ParameterType type, int bufferIndex)
+	{
+		bool vertex = (shaderType == Shader::SHADER_VERTEX);
+
+		switch(type)
+		{
+		case Shader::PARAMETER_TEMP:      return 4096;
+		case Shader::PARAMETER_INPUT:     return vertex ? sw::MAX_VERTEX_INPUTS : sw::MAX_FRAGMENT_INPUTS;
+		case Shader::PARAMETER_CONST:
+			if(bufferIndex != -1)
+			{
+				return sw::MAX_UNIFORM_BLOCK_SIZE;   // Byte offset into the uniform buffer
+			}
+			return vertex ? sw::VERTEX_UNIFORM_VECTORS : sw::FRAGMENT_UNIFORM_VECTORS;
+		case Shader::PARAMETER_ADDR:      return vertex ? 1 : sw::MAX_FRAGMENT_INPUTS - 2;   // PARAMETER_TEXTURE for pixel shaders
+		case Shader::PARAMETER_OUTPUT:    return vertex ? sw::MAX_VERTEX_OUTPUTS : 0;
+		case Shader::PARAMETER_COLOROUT:  return vertex ? 0 : sw::RENDERTARGETS;
+		case Shader::PARAMETER_DEPTHOUT:  return vertex ? 0 : 1;
+		case Shader::PARAMETER_SAMPLER:   return vertex ? sw::VERTEX_TEXTURE_IMAGE_UNITS : sw::TEXTURE_IMAGE_UNITS;
+		case Shader::PARAMETER_CONSTINT:  return 16;
+		case Shader::PARAMETER_CONSTBOOL: return 16;
+		case Shader::PARAMETER_LOOP:      return 1;
+		case Shader::PARAMETER_MISCTYPE:  return 2;
+		case Shader::PARAMETER_LABEL:     return 2048;
+		case Shader::PARAMETER_PREDICATE: return 1;
+		default:                          return 0;
+		}
+	}
+
+	// Checks that the operand only addresses registers which the JIT allocates
+	bool isValidParameter(Shader::ShaderType shaderType, const Shader::Parameter &parameter, int bufferIndex, unsigned int rows)
+	{
+		if(isLiteral(parameter) || parameter.type == Shader::PARAMETER_VOID)
+		{
+			return true;
+		}
+
+		unsigned int count = registerCount(shaderType, parameter.type, bufferIndex);
+
+		if(parameter.type == Shader::PARAMETER_LABEL)
+		{
+			return parameter.label < count;
+		}
+
+		if(parameter.index >= count || rows > count - parameter.index)
+		{
+			return false;
+		}
+
+		switch(parameter.rel.type)
+		{
+		case Shader::PARAMETER_VOID:
+		case Shader::PARAMETER_ADDR:
+		case Shader::PARAMETER_LOOP:
+			return true;
+		case Shader::PARAMETER_TEMP:
+		case Shader::PARAMETER_INPUT:
+		case Shader::PARAMETER_OUTPUT:
+		case Shader::PARAMETER_CONST:
+			return parameter.rel.index < registerCount(shaderType, parameter.rel.type, bufferIndex);
+		default:
+			return false;
+		}
+	}
+
+	// Enumerations and booleans are serialized as a single byte, and rejected when out of range
+	template<class T>
+	T readByte(sw::Deserializer &stream, unsigned int maximum)
+	{
+		unsigned char value = 0;
+		stream.read(value);
+
+		if(value > maximum)
+		{
+			stream.invalidate();
+			value = 0;
+		}
+
+		return (T)value;
+	}
+
+	// Only the fields meaningful for the parameter's type are written, to keep padding and stale union members out of binaries
+	void writeParameter(sw::Serializer &stream, const Shader::Parameter &parameter)
+	{
+		stream.write((unsigned char)parameter.type);
+
+		if(isLiteral(parameter))
+		{
+			stream.write(parameter.integer);
+		}
+		else if(parameter.type == Shader::PARAMETER_LABEL)
+		{
+			stream.write(parameter.label);
+			stream.write(parameter.callSite);
+		}
+		else
+		{
+			stream.write(parameter.index);
+			stream.write((unsigned char)parameter.rel.type);
+			stream.write(parameter.rel.index);
+			stream.write((unsigned char)parameter.rel.swizzle);
+			stream.write(parameter.rel.scale);
+			stream.write((unsigned char)parameter.rel.deterministic);
+		}
+	}
+
+	void readParameter(sw::Deserializer &stream, Shader::Parameter &parameter)
+	{
+		parameter.type = readByte<Shader::ParameterType>(stream, Shader::PARAMETER_VOID);
+
+		if(isLiteral(parameter))
+		{
+			stream.read(parameter.integer);
+		}
+		else if(parameter.type == Shader::PARAMETER_LABEL)
+		{
+			stream.read(parameter.label);
+			stream.read(parameter.callSite);
+		}
+		else
+		{
+			stream.read(parameter.index);
+			parameter.rel.type = readByte<Shader::ParameterType>(stream, Shader::PARAMETER_VOID);
+			stream.read(parameter.rel.index);
+			parameter.rel.swizzle = readByte<unsigned char>(stream, 0xFF);
+			stream.read(parameter.rel.scale);
+			parameter.rel.deterministic = readByte<bool>(stream, 1);
+		}
+	}
+}
 
 namespace sw
 {
 	volatile int Shader::serialCounter = 1;
+	int Shader::specializationLimit = 0;
 
 	Shader::Opcode Shader::OPCODE_DP(int i)
 	{
@@ -1109,9 +1461,14 @@ namespace sw
 		       analysisLeave;
 	}
 
-	Shader::Shader() : serialID(serialCounter++)
+	Shader::Shader() : serialID(atomicIncrement(&serialCounter))   // Shaders may be compiled concurrently
 	{
 		usedSamplers = 0;
+		statistics = Statistics();
+
+		specializableBooleans = 0;
+		specializableIntegers = 0;
+		conditionConstants = 0;
 	}
 
 	Shader::~Shader()
@@ -1466,121 +1823,793 @@ namespace sw
 
 	void Shader::optimize()
 	{
+		statistics.instructions = (unsigned int)instruction.size();
+
 		optimizeLeave();
 		optimizeCall();
+		optimizeTemporaries();
 		removeNull();
+
+		statistics.optimizedInstructions = (unsigned int)instruction.size();
 	}
 
-	void Shader::optimizeLeave()
+	const Shader::Statistics &Shader::getStatistics() const
 	{
-		// A return (leave) right before the end of a function or the shader can be removed
-		for(unsigned int i = 0; i < instruction.size(); i++)
+		return statistics;
+	}
+
+	unsigned int Shader::getBinaryVersion()
+	{
+		const unsigned int revision = 2;   // Increment when serialized fields change meaning but not size
+		const unsigned int layout = (revision << 24) ^ ((unsigned int)sizeof(Instruction) << 16) ^ ((unsigned int)sizeof(SourceParameter) << 8) ^ (unsigned int)sizeof(DestinationParameter);
+		const char version[] = VERSION_STRING;
+
+		return checksum(version, sizeof(version), layout);
+	}
+
+	void Shader::serializeInstructions(Serializer &stream) const
+	{
+		stream.write(version);
+		stream.write(usedSamplers);
+		stream.write((unsigned int)instruction.size());
+
+		for(const Instruction *inst : instruction)
 		{
-			if(instruction[i]->opcode == OPCODE_LEAVE)
+			stream.write(inst->opcode);
+			stream.write((unsigned char)inst->control);
+			stream.write((unsigned char)inst->predicate);
+			stream.write((unsigned char)inst->predicateNot);
+			stream.write(inst->predicateSwizzle);
+			stream.write((unsigned char)inst->coissue);
+			stream.write((unsigned char)inst->samplerType);
+			stream.write((unsigned char)inst->usage);
+			stream.write(inst->usageIndex);
+
+			writeParameter(stream, inst->dst);
+			stream.write(inst->dst.mask);
+			stream.write((unsigned char)inst->dst.integer);
+			stream.write((unsigned char)inst->dst.saturate);
+			stream.write((unsigned char)inst->dst.partialPrecision);
+			stream.write((unsigned char)inst->dst.centroid);
+			stream.write((signed char)inst->dst.shift);
+
+			for(const SourceParameter &src : inst->src)
 			{
-				if(i == instruction.size() - 1 || instruction[i + 1]->opcode == OPCODE_RET)
-				{
-					instruction[i]->opcode = OPCODE_NULL;
-				}
+				writeParameter(stream, src);
+				stream.write((unsigned char)src.swizzle);
+				stream.write((unsigned char)src.modifier);
+				stream.write((signed char)src.bufferIndex);
 			}
 		}
 	}
 
-	void Shader::optimizeCall()
+	void Shader::deserializeInstructions(Deserializer &stream)
 	{
-		// Eliminate uncalled functions
-		std::set<int> calledFunctions;
-		bool rescan = true;
+		stream.read(version);
+		stream.read(usedSamplers);
 
-		while(rescan)
+		const size_t minimumSize = sizeof(Opcode) + 8 + 6 * (1 + 8);   // Operation fields, then per operand its type and the shortest payload (a label)
+		unsigned int count = stream.readCount(minimumSize);
+
+		std::vector<unsigned int> callSites(registerCount(shaderType, PARAMETER_LABEL, -1));
+		std::vector<bool> labels(callSites.size());
+
+		for(unsigned int i = 0; i < count && stream.isValid(); i++)
 		{
-			calledFunctions.clear();
-			rescan = false;
+			Instruction *inst = new Instruction(OPCODE_NOP);
 
-			for(unsigned int i = 0; i < instruction.size(); i++)
+			stream.read(inst->opcode);
+			inst->control = readByte<Control>(stream, CONTROL_RESERVED1);
+			inst->predicate = readByte<bool>(stream, 1);
+			inst->predicateNot = readByte<bool>(stream, 1);
+			stream.read(inst->predicateSwizzle);
+			inst->coissue = readByte<bool>(stream, 1);
+			inst->samplerType = readByte<SamplerType>(stream, SAMPLER_VOLUME);
+			inst->usage = readByte<Usage>(stream, USAGE_SAMPLE);
+			stream.read(inst->usageIndex);
+
+			readParameter(stream, inst->dst);
+			inst->dst.mask = readByte<unsigned char>(stream, 0xF);
+			inst->dst.integer = readByte<bool>(stream, 1);
+			inst->dst.saturate = readByte<bool>(stream, 1);
+			inst->dst.partialPrecision = readByte<bool>(stream, 1);
+			inst->dst.centroid = readByte<bool>(stream, 1);
+
+			signed char shift = 0;
+			stream.read(shift);
+			inst->dst.shift = shift;
+
+			bool valid = isKnownOpcode(inst->opcode) && shift >= -8 && shift <= 7 &&
+			             isValidParameter(shaderType, inst->dst, -1, 1);
+
+			for(int j = 0; j < 5; j++)
 			{
-				if(instruction[i]->isCall())
-				{
-					calledFunctions.insert(instruction[i]->dst.label);
-				}
+				SourceParameter &src = inst->src[j];
+
+				readParameter(stream, src);
+				src.swizzle = readByte<unsigned char>(stream, 0xFF);
+				src.modifier = readByte<Modifier>(stream, MODIFIER_NOT);
+
+				signed char bufferIndex = -1;
+				stream.read(bufferIndex);
+				src.bufferIndex = bufferIndex;
+
+				unsigned int rows = (j == 1) ? matrixRows(inst->opcode) : 1;
+
+				valid = valid && bufferIndex >= -1 && bufferIndex < MAX_UNIFORM_BUFFER_BINDINGS &&
+				        isValidParameter(shaderType, src, bufferIndex, rows);
 			}
 
-			if(!calledFunctions.empty())
+			// Call sites index the return blocks the JIT creates for each label, so they must be numbered consecutively
+			if(valid && inst->isCall())
 			{
-				for(unsigned int i = 0; i < instruction.size(); i++)
-				{
-					if(instruction[i]->opcode == OPCODE_LABEL)
-					{
-						if(calledFunctions.find(instruction[i]->dst.label) == calledFunctions.end())
-						{
-							for( ; i < instruction.size(); i++)
-							{
-								Opcode oldOpcode = instruction[i]->opcode;
-								instruction[i]->opcode = OPCODE_NULL;
-
-								if(oldOpcode == OPCODE_RET)
-								{
-									rescan = true;
-									break;
-								}
-							}
-						}
-					}
-				}
+				valid = inst->dst.type == PARAMETER_LABEL && inst->dst.callSite == callSites[inst->dst.label]++;
 			}
-		}
 
-		// Optimize the entry call
-		if(instruction.size() >= 2 && instruction[0]->opcode == OPCODE_CALL && instruction[1]->opcode == OPCODE_RET)
-		{
-			if(calledFunctions.size() == 1)
+			if(valid && inst->opcode == OPCODE_LABEL)
 			{
-				instruction[0]->opcode = OPCODE_NULL;
-				instruction[1]->opcode = OPCODE_NULL;
+				valid = inst->dst.type == PARAMETER_LABEL;
 
-				for(size_t i = 2; i < instruction.size(); i++)
+				if(valid)
 				{
-					if(instruction[i]->opcode == OPCODE_LABEL || instruction[i]->opcode == OPCODE_RET)
-					{
-						instruction[i]->opcode = OPCODE_NULL;
-					}
+					labels[inst->dst.label] = true;
 				}
 			}
-		}
-	}
 
-	void Shader::removeNull()
-	{
-		size_t size = 0;
-		for(size_t i = 0; i < instruction.size(); i++)
-		{
-			if(instruction[i]->opcode != OPCODE_NULL)
+			if(!valid)
 			{
-				instruction[size] = instruction[i];
-				size++;
+				stream.invalidate();
 			}
-			else
+
+			append(inst);
+		}
+
+		// Every called function has to be defined
+		for(size_t label = 0; label < labels.size(); label++)
+		{
+			if(callSites[label] != 0 && !labels[label])
 			{
-				delete instruction[i];
+				stream.invalidate();
 			}
 		}
+	}
 
-		instruction.resize(size);
+	void Shader::setSpecializationLimit(int variants)
+	{
+		specializationLimit = variants;
 	}
 
-	void Shader::analyzeDirtyConstants()
+	bool Shader::isSpecializable() const
 	{
-		dirtyConstantsF = 0;
-		dirtyConstantsI = 0;
-		dirtyConstantsB = 0;
+		return specializableBooleans != 0 || specializableIntegers != 0 || conditionConstants != 0;
+	}
 
-		for(unsigned int i = 0; i < instruction.size(); i++)
+	bool Shader::specialize(Specialization &specialization, const float4 *c, const int4 *i, const bool *b) const
+	{
+		if(specializationLimit == 0 || !isSpecializable())
 		{
-			switch(instruction[i]->opcode)
+			return false;
+		}
+
+		Specialization variant;
+		memset(&variant, 0, sizeof(Specialization));
+
+		for(int index = 0; index < 16; index++)
+		{
+			if(specializableBooleans & (1 << index))
 			{
-			case OPCODE_DEF:
-				if(instruction[i]->dst.index + 1 > dirtyConstantsF)
-				{
+				variant.booleanMask |= 1 << index;
+				variant.booleanValues |= b[index] ? (1 << index) : 0;
+			}
+
+			if(specializableIntegers & (1 << index))
+			{
+				bool fits = true;
+
+				for(int component = 0; component < 3; component++)
+				{
+					fits = fits && i[index][component] >= -32768 && i[index][component] <= 32767;
+				}
+
+				if(fits)
+				{
+					variant.integerMask |= 1 << index;
+
+					for(int component = 0; component < 3; component++)
+					{
+						variant.integer[index][component] = (short)i[index][component];
+					}
+				}
+			}
+		}
+
+		for(int index = 0; index < conditionConstants; index++)
+		{
+			int bits;
+			memcpy(&bits, &c[conditionConstant[index] / 4][conditionConstant[index] % 4], sizeof(int));
+
+			variant.conditionMask |= 1 << index;
+			variant.conditionValues |= (bits < 0) ? (1 << index) : 0;   // Conditions test the sign bit
+		}
+
+		specializationMutex.lock();
+
+		bool known = false;
+
+		for(size_t index = 0; index < specializations.size() && !known; index++)
+		{
+			known = memcmp(&specializations[index], &variant, sizeof(Specialization)) == 0;
+		}
+
+		bool accept = known || specializations.size() < (size_t)specializationLimit;
+
+		if(!known && accept)
+		{
+			specializations.push_back(variant);
+		}
+
+		specializationMutex.unlock();
+
+		if(accept)   // Else too many different values, keep using the generic routine
+		{
+			specialization = variant;
+		}
+
+		return accept;
+	}
+
+	int Shader::getConditionIndex(const SourceParameter &src) const
+	{
+		if(src.type != PARAMETER_CONST || src.rel.type != PARAMETER_VOID || src.bufferIndex != -1)
+		{
+			return -1;
+		}
+
+		unsigned short constant = (unsigned short)(src.index * 4 + (src.swizzle & 0x3));
+
+		for(int index = 0; index < conditionConstants; index++)
+		{
+			if(conditionConstant[index] == constant)
+			{
+				return index;
+			}
+		}
+
+		return -1;
+	}
+
+	void Shader::optimizeLeave()
+	{
+		// A return (leave) right before the end of a function or the shader can be removed
+		for(unsigned int i = 0; i < instruction.size(); i++)
+		{
+			if(instruction[i]->opcode == OPCODE_LEAVE)
+			{
+				if(i == instruction.size() - 1 || instruction[i + 1]->opcode == OPCODE_RET)
+				{
+					instruction[i]->opcode = OPCODE_NULL;
+				}
+			}
+		}
+	}
+
+	void Shader::optimizeCall()
+	{
+		// Eliminate uncalled functions
+		std::set<int> calledFunctions;
+		bool rescan = true;
+
+		while(rescan)
+		{
+			calledFunctions.clear();
+			rescan = false;
+
+			for(unsigned int i = 0; i < instruction.size(); i++)
+			{
+				if(instruction[i]->isCall())
+				{
+					calledFunctions.insert(instruction[i]->dst.label);
+				}
+			}
+
+			if(!calledFunctions.empty())
+			{
+				for(unsigned int i = 0; i < instruction.size(); i++)
+				{
+					if(instruction[i]->opcode == OPCODE_LABEL)
+					{
+						if(calledFunctions.find(instruction[i]->dst.label) == calledFunctions.end())
+						{
+							for( ; i < instruction.size(); i++)
+							{
+								Opcode oldOpcode = instruction[i]->opcode;
+								instruction[i]->opcode = OPCODE_NULL;
+
+								if(oldOpcode == OPCODE_RET)
+								{
+									rescan = true;
+									break;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Optimize the entry call
+		if(instruction.size() >= 2 && instruction[0]->opcode == OPCODE_CALL && instruction[1]->opcode == OPCODE_RET)
+		{
+			if(calledFunctions.size() == 1)
+			{
+				instruction[0]->opcode = OPCODE_NULL;
+				instruction[1]->opcode = OPCODE_NULL;
+
+				for(size_t i = 2; i < instruction.size(); i++)
+				{
+					if(instruction[i]->opcode == OPCODE_LABEL || instruction[i]->opcode == OPCODE_RET)
+					{
+						instruction[i]->opcode = OPCODE_NULL;
+					}
+				}
+			}
+		}
+	}
+
+	void Shader::optimizeTemporaries()
+	{
+		if(shaderType == SHADER_PIXEL && version < 0x0200)
+		{
+			return;   // Integer pipeline, with implicit register reads
+		}
+
+		unsigned int temporaries = 0;
+
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			const Instruction &inst = *instruction[i];
+
+			if(inst.dst.type == PARAMETER_TEMP)
+			{
+				if(isRelative(inst.dst))
+				{
+					return;   // Dynamically indexed temporaries can't be tracked
+				}
+
+				temporaries = std::max(temporaries, inst.dst.index + 1);
+			}
+
+			for(int j = 0; j < 5; j++)
+			{
+				if(inst.src[j].type == PARAMETER_TEMP)
+				{
+					if(isRelative(inst.src[j]))
+					{
+						return;
+					}
+
+					temporaries = std::max(temporaries, inst.src[j].index + 4);   // Matrix rows
+				}
+			}
+		}
+
+		// Temporaries used for relative addressing are read outside of the regular operands
+		std::vector<bool> indexRegister(temporaries, false);
+
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			const Instruction &inst = *instruction[i];
+
+			for(int j = 0; j < 5; j++)
+			{
+				if(isRelative(inst.src[j]) && inst.src[j].rel.type == PARAMETER_TEMP)
+				{
+					if(inst.src[j].rel.index >= indexRegister.size())
+					{
+						indexRegister.resize(inst.src[j].rel.index + 1, false);
+					}
+
+					indexRegister[inst.src[j].rel.index] = true;
+				}
+			}
+
+			if(isRelative(inst.dst) && inst.dst.rel.type == PARAMETER_TEMP)
+			{
+				if(inst.dst.rel.index >= indexRegister.size())
+				{
+					indexRegister.resize(inst.dst.rel.index + 1, false);
+				}
+
+				indexRegister[inst.dst.rel.index] = true;
+			}
+		}
+
+		propagateCopies(indexRegister);
+		foldConstants();
+		propagateCopies(indexRegister);   // Into users of folded results
+		eliminateDeadCode(indexRegister);
+	}
+
+	void Shader::propagateCopies(const std::vector<bool> &indexRegister)
+	{
+		// Replace reads of a temporary assigned by a plain mov with reads of its source,
+		// within the same basic block. The mov itself becomes dead code if all reads got replaced.
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			const Instruction &copy = *instruction[i];
+			const DestinationParameter &dst = copy.dst;
+			const SourceParameter &source = copy.src[0];
+
+			if(copy.opcode != OPCODE_MOV || copy.predicate || dst.type != PARAMETER_TEMP ||
+			   dst.integer || dst.saturate || dst.shift != 0 || indexRegister[dst.index])
+			{
+				continue;
+			}
+
+			if(source.modifier != MODIFIER_NONE || isRelative(source))
+			{
+				continue;
+			}
+
+			switch(source.type)
+			{
+			case PARAMETER_TEMP:
+				if(source.index == dst.index) continue;
+				break;
+			case PARAMETER_INPUT:
+			case PARAMETER_CONST:
+			case PARAMETER_FLOAT4LITERAL:
+				break;
+			default:
+				continue;
+			}
+
+			for(size_t j = i + 1; j < instruction.size(); j++)
+			{
+				Instruction &use = *instruction[j];
+
+				if(isControlFlow(use.opcode) || use.opcode == OPCODE_NULL)
+				{
+					break;
+				}
+
+				for(int k = 0; k < 5; k++)
+				{
+					SourceParameter &src = use.src[k];
+
+					if(src.type != PARAMETER_TEMP || src.index != dst.index)
+					{
+						continue;
+					}
+
+					if(k == 1 && matrixRows(use.opcode) > 1)
+					{
+						continue;   // Consecutive registers
+					}
+
+					if((readMask(use, k) & ~dst.mask) != 0)
+					{
+						continue;   // Reads components not written by the mov
+					}
+
+					unsigned int swizzle = 0;
+
+					for(int c = 0; c < 4; c++)
+					{
+						int component = (src.swizzle >> (2 * c)) & 0x3;
+						swizzle |= ((source.swizzle >> (2 * component)) & 0x3) << (2 * c);
+					}
+
+					static_cast<Parameter&>(src) = source;
+					src.swizzle = swizzle;
+					src.bufferIndex = source.bufferIndex;
+
+					statistics.propagatedCopies++;
+				}
+
+				if(use.dst.type == dst.type && use.dst.index == dst.index)
+				{
+					break;
+				}
+
+				if(!isLiteral(source) && use.dst.type == source.type && use.dst.index == source.index)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	void Shader::foldConstants()
+	{
+		// Evaluate arithmetic on literals and DEF constants, leaving a mov of a literal
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			Instruction &inst = *instruction[i];
+			int operands = 0;
+
+			switch(inst.opcode)
+			{
+			case OPCODE_NEG: operands = 1; break;
+			case OPCODE_ADD: operands = 2; break;
+			case OPCODE_SUB: operands = 2; break;
+			case OPCODE_MUL: operands = 2; break;
+			case OPCODE_MAD: operands = 3; break;
+			default: continue;
+			}
+
+			if(inst.predicate || inst.dst.integer || inst.dst.shift != 0 || inst.dst.type == PARAMETER_ADDR)
+			{
+				continue;
+			}
+
+			float value[3][4];
+			bool constant = true;
+
+			for(int j = 0; j < operands && constant; j++)
+			{
+				constant = constantValue(instruction, inst.src[j], value[j]);
+			}
+
+			if(!constant)
+			{
+				continue;
+			}
+
+			float result[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+			for(int c = 0; c < 4 && constant; c++)
+			{
+				if(!(inst.dst.mask & (1 << c)))
+				{
+					continue;
+				}
+
+				float x = value[0][c];
+
+				switch(inst.opcode)
+				{
+				case OPCODE_NEG: x = -x;                    break;
+				case OPCODE_ADD: x = x + value[1][c];       break;
+				case OPCODE_SUB: x = x - value[1][c];       break;
+				case OPCODE_MUL: x = x * value[1][c];       break;
+				case OPCODE_MAD:
+					x = x * value[1][c];   // Not fused
+					x = x + value[2][c];
+					break;
+				default:
+					ASSERT(false);
+				}
+
+				if(inst.dst.saturate)
+				{
+					x = std::min(std::max(x, 0.0f), 1.0f);
+				}
+
+				// Leave non-finite and denormal results to the run-time floating-point environment
+				if(!std::isfinite(x) || (x != 0.0f && std::fabs(x) < FLT_MIN))
+				{
+					constant = false;
+				}
+
+				result[c] = x;
+			}
+
+			if(!constant)
+			{
+				continue;
+			}
+
+			inst.opcode = OPCODE_MOV;
+			inst.dst.saturate = false;
+
+			for(int j = 0; j < 5; j++)
+			{
+				inst.src[j] = SourceParameter();
+			}
+
+			inst.src[0].type = PARAMETER_FLOAT4LITERAL;
+			inst.src[0].value[0] = result[0];
+			inst.src[0].value[1] = result[1];
+			inst.src[0].value[2] = result[2];
+			inst.src[0].value[3] = result[3];
+
+			statistics.foldedInstructions++;
+		}
+	}
+
+	void Shader::eliminateDeadCode(const std::vector<bool> &indexRegister)
+	{
+		// Backward liveness analysis of temporary register components. Main and each function
+		// are analyzed separately, so temporaries shared between them are considered always live.
+		// Writes only make a register dead when they are unconditional, i.e. outside of any
+		// branch or loop, not predicated, and in code which can't be skipped by a 'leave'.
+		size_t length = instruction.size();
+		size_t temporaries = indexRegister.size();
+
+		std::vector<size_t> loopBegin(length, 0);
+		std::vector<size_t> regionBegin;
+		std::vector<size_t> loopStack;
+
+		for(size_t i = 0; i < length; i++)
+		{
+			if(instruction[i]->opcode == OPCODE_LABEL || i == 0)
+			{
+				regionBegin.push_back(i);
+			}
+
+			if(instruction[i]->isLoop())
+			{
+				loopStack.push_back(i);
+			}
+			else if(instruction[i]->isEndLoop())
+			{
+				if(loopStack.empty())
+				{
+					return;   // Malformed
+				}
+
+				loopBegin[i] = loopStack.back();
+				loopStack.pop_back();
+			}
+		}
+
+		regionBegin.push_back(length);
+
+		std::vector<bool> alwaysLive(indexRegister);
+		std::vector<int> region(temporaries, -1);
+
+		for(size_t r = 0; r + 1 < regionBegin.size(); r++)
+		{
+			std::vector<unsigned char> used(temporaries, 0);
+
+			for(size_t i = regionBegin[r]; i < regionBegin[r + 1]; i++)
+			{
+				markTemporaryReads(*instruction[i], used);
+
+				if(writesTemporary(*instruction[i]))
+				{
+					used[instruction[i]->dst.index] = 0xF;
+				}
+			}
+
+			for(size_t t = 0; t < temporaries; t++)
+			{
+				if(used[t])
+				{
+					if(region[t] != -1 && region[t] != (int)r)
+					{
+						alwaysLive[t] = true;
+					}
+
+					region[t] = (int)r;
+				}
+			}
+		}
+
+		for(size_t r = 0; r + 1 < regionBegin.size(); r++)
+		{
+			size_t begin = regionBegin[r];
+			size_t end = regionBegin[r + 1];
+			bool function = (instruction[begin]->opcode == OPCODE_LABEL);
+			bool leave = false;
+
+			std::vector<unsigned char> live(temporaries, 0);
+
+			for(size_t t = 0; t < temporaries; t++)
+			{
+				if(alwaysLive[t])
+				{
+					live[t] = 0xF;
+				}
+			}
+
+			for(size_t i = begin; i < end; i++)
+			{
+				if(function)   // Values may be read by a subsequent call
+				{
+					markTemporaryReads(*instruction[i], live);
+				}
+
+				if(instruction[i]->opcode == OPCODE_LEAVE)
+				{
+					leave = true;
+				}
+			}
+
+			int depth = 0;
+
+			for(size_t i = end; i-- > begin;)
+			{
+				Instruction &inst = *instruction[i];
+
+				switch(inst.opcode)
+				{
+				case OPCODE_ENDLOOP:
+				case OPCODE_ENDREP:
+				case OPCODE_ENDWHILE:
+					for(size_t j = loopBegin[i]; j < i; j++)   // Values may be read by a subsequent iteration
+					{
+						markTemporaryReads(*instruction[j], live);
+					}
+					depth++;
+					break;
+				case OPCODE_ENDIF:
+				case OPCODE_ENDSWITCH:
+					depth++;
+					break;
+				case OPCODE_LOOP:
+				case OPCODE_REP:
+				case OPCODE_WHILE:
+				case OPCODE_IF:
+				case OPCODE_IFC:
+				case OPCODE_SWITCH:
+					depth--;
+					break;
+				default:
+					break;
+				}
+
+				if(writesTemporary(inst))
+				{
+					unsigned char &components = live[inst.dst.index];
+
+					if(isComponentWise(inst.opcode) && (inst.dst.mask & ~components) != 0 && (inst.dst.mask & components) != 0)
+					{
+						inst.dst.mask &= components;
+						statistics.narrowedMasks++;
+					}
+
+					if((inst.dst.mask & components) == 0)
+					{
+						inst.opcode = OPCODE_NULL;
+						statistics.deadInstructions++;
+						continue;
+					}
+
+					if(depth == 0 && !inst.predicate && !leave)
+					{
+						components &= ~inst.dst.mask;
+					}
+				}
+
+				markTemporaryReads(inst, live);
+			}
+		}
+	}
+
+	void Shader::removeNull()
+	{
+		size_t size = 0;
+		for(size_t i = 0; i < instruction.size(); i++)
+		{
+			if(instruction[i]->opcode != OPCODE_NULL)
+			{
+				instruction[size] = instruction[i];
+				size++;
+			}
+			else
+			{
+				delete instruction[i];
+			}
+		}
+
+		instruction.resize(size);
+	}
+
+	void Shader::analyzeDirtyConstants()
+	{
+		dirtyConstantsF = 0;
+		dirtyConstantsI = 0;
+		dirtyConstantsB = 0;
+
+		for(unsigned int i = 0; i < instruction.size(); i++)
+		{
+			switch(instruction[i]->opcode)
+			{
+			case OPCODE_DEF:
+				if(instruction[i]->dst.index + 1 > dirtyConstantsF)
+				{
 					dirtyConstantsF = instruction[i]->dst.index + 1;
 				}
 				break;
@@ -1902,4 +2931,55 @@ namespace sw
 			}
 		}
 	}
+
+	void Shader::analyzeSpecialization()
+	{
+		specializableBooleans = 0;
+		specializableIntegers = 0;
+		conditionConstants = 0;
+
+		const unsigned int uniforms = (shaderType == SHADER_PIXEL) ? FRAGMENT_UNIFORM_VECTORS : VERTEX_UNIFORM_VECTORS;
+
+		for(unsigned int i = 0; i < instruction.size(); i++)
+		{
+			const Instruction &inst = *instruction[i];
+			const SourceParameter &src = (inst.opcode == OPCODE_LOOP) ? inst.src[1] : inst.src[0];
+
+			switch(inst.opcode)
+			{
+			case OPCODE_IF:
+			case OPCODE_CALLNZ:
+				if(src.type == PARAMETER_CONSTBOOL && src.index < 16)
+				{
+					specializableBooleans |= 1 << src.index;
+				}
+				else if(inst.opcode == OPCODE_IF && src.type == PARAMETER_CONST && src.rel.type == PARAMETER_VOID &&
+				        src.bufferIndex == -1 && src.index < uniforms &&
+				        (src.modifier == MODIFIER_NONE || src.modifier == MODIFIER_NOT))
+				{
+					bool defined = false;   // Values of DEF constants take precedence over the uniforms
+
+					for(unsigned int j = 0; j < instruction.size(); j++)
+					{
+						defined = defined || (instruction[j]->opcode == OPCODE_DEF && instruction[j]->dst.index == src.index);
+					}
+
+					if(!defined && getConditionIndex(src) == -1 && conditionConstants < MAX_CONDITION_CONSTANTS)
+					{
+						conditionConstant[conditionConstants++] = (unsigned short)(src.index * 4 + (src.swizzle & 0x3));
+					}
+				}
+				break;
+			case OPCODE_LOOP:
+			case OPCODE_REP:
+				if(src.type == PARAMETER_CONSTINT && src.index < 16)
+				{
+					specializableIntegers |= 1 << src.index;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
 }
@@ -16,12 +16,16 @@
 #define sw_Shader_hpp
 
 #include "Common/Types.hpp"
+#include "Common/MutexLock.hpp"
 
 #include <string>
 #include <vector>
 
 namespace sw
 {
+	class Serializer;
+	class Deserializer;
+
 	class Shader
 	{
 	public:
@@ -592,7 +596,44 @@ namespace sw
 			bool flat;
 		};
 
+		struct Statistics
+		{
+			unsigned int instructions;            // Before optimization
+			unsigned int optimizedInstructions;
+			unsigned int propagatedCopies;        // Operands replaced by the source of a mov
+			unsigned int foldedInstructions;      // Evaluated at compile time
+			unsigned int narrowedMasks;           // Write masks reduced to the live components
+			unsigned int deadInstructions;        // Results never read
+		};
+
 		void optimize();
+		const Statistics &getStatistics() const;
+
+		static unsigned int getBinaryVersion();   // Differs between builds whose serialized shaders are incompatible
+
+		enum {MAX_CONDITION_CONSTANTS = 8};
+
+		// Uniform values which control flow depends on, folded into a routine
+		struct Specialization
+		{
+			bool active() const
+			{
+				return booleanMask != 0 || integerMask != 0 || conditionMask != 0;
+			}
+
+			unsigned short booleanMask;     // Boolean constants b#
+			unsigned short booleanValues;
+			unsigned short integerMask;     // Integer constants i#
+			unsigned char conditionMask;    // Float constants used as 'if' condition, see getConditionIndex()
+			unsigned char conditionValues;
+			short integer[16][3];           // Loop count, initial value and step
+		};
+
+		static void setSpecializationLimit(int variants);   // Routine variants per shader, 0 disables specialization
+
+		bool isSpecializable() const;
+		bool specialize(Specialization &specialization, const float4 *c, const int4 *i, const bool *b) const;
+		int getConditionIndex(const SourceParameter &src) const;
 
 		// FIXME: Private
 		unsigned int dirtyConstantsF;
@@ -606,8 +647,15 @@ namespace sw
 	protected:
 		void parse(const unsigned long *token);
 
+		void serializeInstructions(Serializer &stream) const;
+		void deserializeInstructions(Deserializer &stream);
+
 		void optimizeLeave();
 		void optimizeCall();
+		void optimizeTemporaries();
+		void propagateCopies(const std::vector<bool> &indexRegister);
+		void foldConstants();
+		void eliminateDeadCode(const std::vector<bool> &indexRegister);
 		void removeNull();
 
 		void analyzeDirtyConstants();
@@ -615,6 +663,7 @@ namespace sw
 		void analyzeSamplers();
 		void analyzeCallSites();
 		void analyzeDynamicIndexing();
+		void analyzeSpecialization();
 		void markFunctionAnalysis(unsigned int functionLabel, Analysis flag);
 
 		ShaderType shaderType;
@@ -634,6 +683,13 @@ namespace sw
 
 		unsigned short usedSamplers;   // Bit flags
 
+		Statistics statistics;
+
+		unsigned short specializableBooleans;   // Bit flags
+		unsigned short specializableIntegers;   // Bit flags
+		int conditionConstants;
+		unsigned short conditionConstant[MAX_CONDITION_CONSTANTS];   // Register index * 4 + component
+
 	private:
 		const int serialID;
 		static volatile int serialCounter;
@@ -643,6 +699,10 @@ namespace sw
 		bool containsContinue;
 		bool containsLeave;
 		bool containsDefine;
+
+		static int specializationLimit;
+		mutable MutexLock specializationMutex;
+		mutable std::vector<Specialization> specializations;   // Variants seen so far
 	};
 }
 
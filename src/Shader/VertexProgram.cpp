@@ -790,6 +790,34 @@ namespace sw
 		return uniformAddress(bufferIndex, index) + offset * sizeof(float4);
 	}
 
+	RValue<Bool> VertexProgram::readBoolean(const Src &boolRegister)
+	{
+		const Shader::Specialization &specialization = state.specialization;
+
+		if(boolRegister.type == Shader::PARAMETER_CONST)   // Specialized 'if' condition
+		{
+			return Bool((specialization.conditionValues & (1 << shader->getConditionIndex(boolRegister))) != 0);
+		}
+		else if(specialization.booleanMask & (1 << boolRegister.index))
+		{
+			return Bool((specialization.booleanValues & (1 << boolRegister.index)) != 0);
+		}
+
+		return *Pointer<Byte>(data + OFFSET(DrawData,vs.b[boolRegister.index])) != Byte(0);   // FIXME
+	}
+
+	RValue<Int> VertexProgram::readInteger(const Src &integerRegister, int component)
+	{
+		const Shader::Specialization &specialization = state.specialization;
+
+		if(specialization.integerMask & (1 << integerRegister.index))
+		{
+			return Int(specialization.integer[integerRegister.index][component]);
+		}
+
+		return *Pointer<Int>(data + OFFSET(DrawData,vs.i[integerRegister.index][component]));
+	}
+
 	Vector4f VertexProgram::readConstant(const Src &src, unsigned int offset)
 	{
 		Vector4f c;
@@ -1113,7 +1141,7 @@ namespace sw
 
 	void VertexProgram::CALLNZb(int labelIndex, int callSiteIndex, const Src &boolRegister)
 	{
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData,vs.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = readBoolean(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1274,6 +1302,8 @@ namespace sw
 
 	void VertexProgram::IF(const Src &src)
 	{
+		int conditionIndex = shader->getConditionIndex(src);
+
 		if(src.type == Shader::PARAMETER_CONSTBOOL)
 		{
 			IFb(src);
@@ -1282,6 +1312,10 @@ namespace sw
 		{
 			IFp(src);
 		}
+		else if(conditionIndex != -1 && (state.specialization.conditionMask & (1 << conditionIndex)))   // Uniform folded into the routine
+		{
+			IFb(src);
+		}
 		else
 		{
 			Int4 condition = As<Int4>(fetchRegister(src).x);
@@ -1293,7 +1327,7 @@ namespace sw
 	{
 		ASSERT(ifDepth < 24 + 4);
 
-		Bool condition = (*Pointer<Byte>(data + OFFSET(DrawData,vs.b[boolRegister.index])) != Byte(0));   // FIXME
+		Bool condition = readBoolean(boolRegister);
 
 		if(boolRegister.modifier == Shader::MODIFIER_NOT)
 		{
@@ -1378,9 +1412,9 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData,vs.i[integerRegister.index][0]));
-		aL[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData,vs.i[integerRegister.index][1]));
-		increment[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData,vs.i[integerRegister.index][2]));
+		iteration[loopDepth] = readInteger(integerRegister, 0);
+		aL[loopDepth] = readInteger(integerRegister, 1);
+		increment[loopDepth] = readInteger(integerRegister, 2);
 
 		// FIXME: Compiles to two instructions?
 		If(increment[loopDepth] == 0)
@@ -1412,7 +1446,7 @@ namespace sw
 	{
 		loopDepth++;
 
-		iteration[loopDepth] = *Pointer<Int>(data + OFFSET(DrawData,vs.i[integerRegister.index][0]));
+		iteration[loopDepth] = readInteger(integerRegister, 0);
 		aL[loopDepth] = aL[loopDepth - 1];
 
 		BasicBlock *loopBlock = Nucleus::createBasicBlock();
@@ -1584,10 +1618,17 @@ namespace sw
 	{
 		Vector4f tmp;
 
+		addCounter(PERF_TEXTURE_OPERATIONS, 4);
+
 		if(s.type == Shader::PARAMETER_SAMPLER && s.rel.type == Shader::PARAMETER_VOID)
 		{
 			Pointer<Byte> texture = data + OFFSET(DrawData, mipmap[TEXTURE_IMAGE_UNITS]) + s.index * sizeof(Texture);
 			sampler[s.index]->sampleTexture(texture, tmp, uvwq.x, uvwq.y, uvwq.z, uvwq.w, dsx, dsy, offset, function);
+
+			if(state.samplerState[s.index].compressedFormat)
+			{
+				addCounter(PERF_COMPRESSED_TEXTURE_OPERATIONS, 4);
+			}
 		}
 		else
 		{
@@ -1602,6 +1643,11 @@ namespace sw
 						Pointer<Byte> texture = data + OFFSET(DrawData, mipmap[TEXTURE_IMAGE_UNITS]) + i * sizeof(Texture);
 						sampler[i]->sampleTexture(texture, tmp, uvwq.x, uvwq.y, uvwq.z, uvwq.w, dsx, dsy, offset, function);
 						// FIXME: When the sampler states are the same, we could use one sampler and just index the texture
+
+						if(state.samplerState[i].compressedFormat)
+						{
+							addCounter(PERF_COMPRESSED_TEXTURE_OPERATIONS, 4);
+						}
 					}
 				}
 			}
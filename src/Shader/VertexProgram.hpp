@@ -70,6 +70,8 @@ namespace sw
 		Vector4f readConstant(const Src &src, unsigned int offset = 0);
 		RValue<Pointer<Byte>> uniformAddress(int bufferIndex, unsigned int index);
 		RValue<Pointer<Byte>> uniformAddress(int bufferIndex, unsigned int index, Int& offset);
+		RValue<Bool> readBoolean(const Src &boolRegister);
+		RValue<Int> readInteger(const Src &integerRegister, int component);
 		Int relativeAddress(const Shader::Parameter &var, int bufferIndex = -1);
 		Int4 enableMask(const Shader::Instruction *instruction);
 
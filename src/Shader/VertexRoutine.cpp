@@ -51,6 +51,8 @@ namespace sw
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 
+		Int shaded = 0;
+
 		Do
 		{
 			UInt index = *Pointer<UInt>(batch);
@@ -68,6 +70,11 @@ namespace sw
 
 				Pointer<Byte> cacheLine0 = vertexCache + tagIndex * UInt((int)sizeof(Vertex));
 				writeCache(cacheLine0);
+
+				if(state.profile)
+				{
+					shaded += 4;   // Processed as a vector
+				}
 			}
 
 			UInt cacheIndex = index & 0x0000003F;
@@ -92,9 +99,19 @@ namespace sw
 		}
 		Until(vertexCount == 0)
 
+		addCounter(PERF_VERTICES, shaded);
+
 		Return();
 	}
 
+	void VertexRoutine::addCounter(int counter, RValue<Int> n)
+	{
+		if(state.profile)
+		{
+			AddAtomic(Pointer<Long>(data + OFFSET(DrawData,counters) + 8 * counter), Long(n));
+		}
+	}
+
 	void VertexRoutine::readInput(UInt &index)
 	{
 		for(int i = 0; i < MAX_VERTEX_INPUTS; i++)
@@ -131,6 +148,10 @@ namespace sw
 		Int4 finiteXYZ = finiteX & finiteY & finiteZ;
 		clipFlags |= *Pointer<Int>(constants + OFFSET(Constants,fini) + SignMask(finiteXYZ) * 4);
 
+		Int4 guardX = CmpLT(*Pointer<Float4>(data + OFFSET(DrawData,guardBandX)) * o[pos].w, Abs(o[pos].x));
+		Int4 guardY = CmpLT(*Pointer<Float4>(data + OFFSET(DrawData,guardBandY)) * o[pos].w, Abs(o[pos].y));
+		clipFlags |= *Pointer<Int>(constants + OFFSET(Constants,guard) + SignMask(guardX | guardY) * 4);
+
 		if(state.preTransformed)
 		{
 			clipFlags &= 0xFBFBFBFB;   // Don't clip against far clip plane
@@ -53,6 +53,8 @@ namespace sw
 
 		const VertexProcessor::State &state;
 
+		void addCounter(int counter, RValue<Int> n);   // Adds to the draw's counter when profiling
+
 	private:
 		virtual void pipeline() = 0;
 
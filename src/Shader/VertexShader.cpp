@@ -16,6 +16,7 @@
 
 #include "Vertex.hpp"
 #include "Debug.hpp"
+#include "Serializer.hpp"
 
 #include <string.h>
 
@@ -23,6 +24,7 @@ namespace sw
 {
 	VertexShader::VertexShader(const VertexShader *vs) : Shader()
 	{
+		shaderType = SHADER_VERTEX;
 		version = 0x0300;
 		positionRegister = Pos;
 		pointSizeRegister = Unused;
@@ -195,6 +197,52 @@ namespace sw
 		return output[outputIdx][component];
 	}
 
+	void VertexShader::serialize(Serializer &stream) const
+	{
+		serializeInstructions(stream);
+
+		stream.write(input);
+		stream.write(output);
+		stream.write(attribType);
+		stream.write(positionRegister);
+		stream.write(pointSizeRegister);
+		stream.write(instanceIdDeclared);
+	}
+
+	bool VertexShader::deserialize(Deserializer &stream, bool optimized)
+	{
+		ASSERT(getLength() == 0);
+
+		deserializeInstructions(stream);
+
+		stream.read(input);
+		stream.read(output);
+		stream.read(attribType);
+		stream.read(positionRegister);
+		stream.read(pointSizeRegister);
+		stream.read(instanceIdDeclared);
+
+		if(!stream.isValid() || positionRegister < 0 || positionRegister >= MAX_VERTEX_OUTPUTS || pointSizeRegister < 0 || pointSizeRegister > Unused)
+		{
+			return false;
+		}
+
+		for(AttribType type : attribType)
+		{
+			if(type > ATTRIBTYPE_LAST)
+			{
+				return false;
+			}
+		}
+
+		if(optimized)
+		{
+			analyze();
+		}
+
+		return true;
+	}
+
 	void VertexShader::analyze()
 	{
 		analyzeInput();
@@ -205,6 +253,7 @@ namespace sw
 		analyzeSamplers();
 		analyzeCallSites();
 		analyzeDynamicIndexing();
+		analyzeSpecialization();
 	}
 
 	void VertexShader::analyzeInput()
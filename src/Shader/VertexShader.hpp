@@ -53,6 +53,9 @@ namespace sw
 		int getPointSizeRegister() const { return pointSizeRegister; }
 		bool isInstanceIdDeclared() const { return instanceIdDeclared; }
 
+		void serialize(Serializer &stream) const;
+		bool deserialize(Deserializer &stream, bool optimized);   // Optimized shaders also get analyzed, as on construction
+
 	private:
 		void analyze();
 		void analyzeInput();
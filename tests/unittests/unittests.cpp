@@ -16,12 +16,30 @@
 #include "gmock/gmock.h"
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <string.h>
 
 #if defined(_WIN32)
 #include <Windows.h>
 #endif
 
+#if defined(__linux__)
+#include <EGL/eglext_swiftshader.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
 class SwiftShaderTest : public testing::Test
 {
 protected:
@@ -37,8 +55,149 @@ protected:
 			EXPECT_NE((HMODULE)NULL, libGLESv2);
 		#endif
 	}
+
+	void initializeContext()
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EXPECT_NE(EGL_NO_DISPLAY, display);
+
+		EGLBoolean initialized = eglInitialize(display, nullptr, nullptr);
+		EXPECT_EQ((EGLBoolean)EGL_TRUE, initialized);
+
+		const EGLint configAttributes[] =
+		{
+			EGL_SURFACE_TYPE,      EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE,   EGL_OPENGL_ES3_BIT,
+			EGL_RED_SIZE,          8,
+			EGL_GREEN_SIZE,        8,
+			EGL_BLUE_SIZE,         8,
+			EGL_ALPHA_SIZE,        8,
+			EGL_NONE
+		};
+
+		EGLConfig config;
+		EGLint numConfigs = 0;
+		EGLBoolean chosen = eglChooseConfig(display, configAttributes, &config, 1, &numConfigs);
+		EXPECT_EQ((EGLBoolean)EGL_TRUE, chosen);
+		EXPECT_EQ(1, numConfigs);
+
+		const EGLint surfaceAttributes[] =
+		{
+			EGL_WIDTH,  16,
+			EGL_HEIGHT, 16,
+			EGL_NONE
+		};
+
+		surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+		EXPECT_NE(EGL_NO_SURFACE, surface);
+
+		const EGLint contextAttributes[] =
+		{
+			EGL_CONTEXT_CLIENT_VERSION, 3,
+			EGL_NONE
+		};
+
+		context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+		EXPECT_NE(EGL_NO_CONTEXT, context);
+
+		EGLBoolean current = eglMakeCurrent(display, surface, surface, context);
+		EXPECT_EQ((EGLBoolean)EGL_TRUE, current);
+		EXPECT_EQ(EGL_SUCCESS, eglGetError());
+	}
+
+	void uninitializeContext()
+	{
+		EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+		eglDestroySurface(display, surface);
+		eglTerminate(display);
+		EXPECT_EQ(EGL_SUCCESS, eglGetError());
+	}
+
+	GLuint compileShader(GLenum type, const char *source)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		return shader;
+	}
+
+	GLuint createProgram(const char *vertexSource, const char *fragmentSource)
+	{
+		GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+		GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+
+		// The program keeps the compiled shaders alive
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		return program;
+	}
+
+	// Draws a quad covering the whole viewport, without waiting for it to be rendered
+	void queueQuad(GLuint program)
+	{
+		const GLfloat vertices[] =
+		{
+			-1.0f, -1.0f,
+			 1.0f, -1.0f,
+			-1.0f,  1.0f,
+			 1.0f,  1.0f,
+		};
+
+		glUseProgram(program);
+
+		GLint position = glGetAttribLocation(program, "position");
+		EXPECT_NE(-1, position);
+		glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+		glEnableVertexAttribArray(position);
+
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		glDisableVertexAttribArray(position);
+	}
+
+	// Draws a quad covering the whole surface, and returns the color of its center
+	GLuint drawQuad(GLuint program)
+	{
+		queueQuad(program);
+
+		GLuint pixel = 0;
+		glReadPixels(8, 8, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixel);
+
+		return pixel;
+	}
+
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLSurface surface = EGL_NO_SURFACE;
+	EGLContext context = EGL_NO_CONTEXT;
 };
 
+namespace
+{
+	const char *const vertexSource =
+		"attribute vec2 position;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_Position = vec4(position, 0.0, 1.0);\n"
+		"}\n";
+
+	const char *const fragmentSource =
+		"precision mediump float;\n"
+		"uniform vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_FragColor = color;\n"
+		"}\n";
+}
+
 TEST_F(SwiftShaderTest, CompilationOnly)
 {
 	// Empty test to trigger compilation of SwiftShader on build bots
@@ -71,3 +230,705 @@ TEST_F(SwiftShaderTest, Initalization)
 	EXPECT_EQ(EGL_SUCCESS, eglGetError());
 	EXPECT_THAT(version, testing::HasSubstr("1.4 SwiftShader "));
 }
+
+TEST_F(SwiftShaderTest, ProgramBinary)
+{
+	initializeContext();
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	EXPECT_EQ(GL_TRUE, linked);
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	EXPECT_GT(length, 0);
+
+	std::vector<unsigned char> binary(length);
+	GLenum format = GL_NONE;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	EXPECT_EQ((GLsizei)binary.size(), length);
+
+	// Binaries only depend on the program, not on uninitialized memory
+	GLuint relinked = createProgram(vertexSource, fragmentSource);
+	std::vector<unsigned char> relinkedBinary(length);
+	glGetProgramBinary(relinked, length, nullptr, &format, relinkedBinary.data());
+	EXPECT_EQ(binary, relinkedBinary);
+	glDeleteProgram(relinked);
+
+	// A program loaded from the binary behaves like the one it was retrieved from
+	GLuint loaded = glCreateProgram();
+	glProgramBinary(loaded, format, binary.data(), length);
+	glGetProgramiv(loaded, GL_LINK_STATUS, &linked);
+	EXPECT_EQ(GL_TRUE, linked);
+	EXPECT_EQ(glGetUniformLocation(program, "color"), glGetUniformLocation(loaded, "color"));
+
+	glUseProgram(loaded);
+	glUniform4f(glGetUniformLocation(loaded, "color"), 0.0f, 1.0f, 0.0f, 1.0f);
+	EXPECT_EQ(0xFF00FF00u, drawQuad(loaded));
+
+	// Corrupt binaries fail to link, with a fresh info log
+	std::vector<unsigned char> corrupt(binary);
+	corrupt.back() ^= 0xFF;
+	glProgramBinary(loaded, format, corrupt.data(), length);
+	glGetProgramiv(loaded, GL_LINK_STATUS, &linked);
+	EXPECT_EQ(GL_FALSE, linked);
+
+	GLint infoLogLength = 0;
+	glGetProgramiv(loaded, GL_INFO_LOG_LENGTH, &infoLogLength);
+	EXPECT_GT(infoLogLength, 0);
+
+	glProgramBinary(loaded, format, corrupt.data(), length);
+	GLint repeatedInfoLogLength = 0;
+	glGetProgramiv(loaded, GL_INFO_LOG_LENGTH, &repeatedInfoLogLength);
+	EXPECT_EQ(infoLogLength, repeatedInfoLogLength);
+
+	glProgramBinary(loaded, format, binary.data(), length - 1);
+	glGetProgramiv(loaded, GL_LINK_STATUS, &linked);
+	EXPECT_EQ(GL_FALSE, linked);
+
+	// Binaries with a valid checksum are still range checked. This patches the
+	// first vertex shader instruction's destination register, which follows the
+	// 16 byte header, the shader's version and counts, the operation fields and
+	// the operand type.
+	const size_t headerSize = 16;
+	const size_t dstIndexOffset = headerSize + 8 + 12 + 1;
+	const unsigned int dstIndices[] = {1, 4096};
+
+	for(unsigned int dstIndex : dstIndices)
+	{
+		std::vector<unsigned char> patched(binary);
+		memcpy(&patched[dstIndexOffset], &dstIndex, sizeof(dstIndex));
+
+		unsigned int checksum = 0x811C9DC5;   // FNV-1a, see src/Common/Serializer.hpp
+		for(size_t i = headerSize; i < patched.size(); i++)
+		{
+			checksum = (checksum ^ patched[i]) * 0x01000193;
+		}
+		memcpy(&patched[headerSize - sizeof(checksum)], &checksum, sizeof(checksum));
+
+		glProgramBinary(loaded, format, patched.data(), length);
+		glGetProgramiv(loaded, GL_LINK_STATUS, &linked);
+		EXPECT_EQ(dstIndex < 4096 ? GL_TRUE : GL_FALSE, linked);
+	}
+
+	glUseProgram(0);
+	glDeleteProgram(loaded);
+	glDeleteProgram(program);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, ShaderCompileCache)
+{
+	initializeContext();
+
+	// The second compilation of the same source is a cache hit, and must
+	// produce shaders indistinguishable from those of the first compilation
+	for(int i = 0; i < 2; i++)
+	{
+		GLuint program = createProgram(vertexSource, fragmentSource);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		EXPECT_EQ(GL_TRUE, linked);
+
+		glUseProgram(program);
+		glUniform4f(glGetUniformLocation(program, "color"), 1.0f, 0.0f, 0.0f, 1.0f);
+		EXPECT_EQ(0xFF0000FFu, drawQuad(program));
+
+		glUseProgram(0);
+		glDeleteProgram(program);
+	}
+
+	// Failed compilations are cached as well, including their info log
+	const char *invalidSource = "void main() { undeclared = 1.0; }\n";
+	std::vector<char> infoLogs[2];
+
+	for(int i = 0; i < 2; i++)
+	{
+		GLuint shader = compileShader(GL_FRAGMENT_SHADER, invalidSource);
+
+		GLint compiled = GL_TRUE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		EXPECT_EQ(GL_FALSE, compiled);
+
+		GLint infoLogLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLogLength);
+		EXPECT_GT(infoLogLength, 0);
+
+		infoLogs[i].resize(infoLogLength);
+		glGetShaderInfoLog(shader, infoLogLength, nullptr, infoLogs[i].data());
+
+		glDeleteShader(shader);
+	}
+
+	EXPECT_EQ(infoLogs[0], infoLogs[1]);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, CompletionStatus)
+{
+	initializeContext();
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+
+	// Polling doesn't block, and eventually reports the link as completed
+	GLint completed = GL_FALSE;
+	for(int i = 0; i < 10000 && completed == GL_FALSE; i++)
+	{
+		glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+
+		if(completed == GL_FALSE)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	EXPECT_EQ(GL_TRUE, completed);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	EXPECT_EQ(GL_TRUE, linked);
+
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+	EXPECT_EQ(GL_TRUE, completed);
+
+	glDeleteProgram(program);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, PixelPackBufferFence)
+{
+	initializeContext();
+
+	glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, 16 * 16 * 4, nullptr, GL_STREAM_READ);
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	// The read back completes asynchronously, and the fence signals its completion
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	EXPECT_NE((GLsync)nullptr, sync);
+
+	// Clearing the framebuffer again must not affect the pixels already read
+	glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+	EXPECT_TRUE(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED);
+
+	GLint status = GL_UNSIGNALED;
+	glGetSynciv(sync, GL_SYNC_STATUS, 1, nullptr, &status);
+	EXPECT_EQ(GL_SIGNALED, status);
+	glDeleteSync(sync);
+
+	const GLuint *pixels = static_cast<const GLuint*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 16 * 16 * 4, GL_MAP_READ_BIT));
+	EXPECT_NE(nullptr, pixels);
+
+	for(int i = 0; pixels && i < 16 * 16; i++)
+	{
+		EXPECT_EQ(0xFFFF0000u, pixels[i]);
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, PixelPackBufferContents)
+{
+	initializeContext();
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+
+	glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glViewport(0, 0, 8, 16);
+	glUseProgram(program);
+	glUniform4f(glGetUniformLocation(program, "color"), 1.0f, 0.0f, 0.0f, 1.0f);
+	queueQuad(program);
+	glViewport(0, 0, 16, 16);
+
+	// Read back at an offset, while the draw may still be in progress
+	const GLintptr offset = 64;
+	std::vector<unsigned char> initial(offset + 16 * 16 * 4, 0xCD);
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, initial.size(), initial.data(), GL_STREAM_READ);
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(offset));
+
+	// Later rendering must not affect the pixels being read, and mapping waits for them
+	glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	const unsigned char *data = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, initial.size(), GL_MAP_READ_BIT));
+	ASSERT_NE(nullptr, data);
+
+	for(GLintptr i = 0; i < offset; i++)
+	{
+		EXPECT_EQ(0xCD, data[i]);
+	}
+
+	const GLuint *pixels = reinterpret_cast<const GLuint*>(data + offset);
+
+	for(int y = 0; y < 16; y++)
+	{
+		for(int x = 0; x < 16; x++)
+		{
+			EXPECT_EQ(x < 8 ? 0xFF0000FFu : 0xFFFF0000u, pixels[y * 16 + x]);
+		}
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	glUseProgram(0);
+	glDeleteProgram(program);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, PixelPackBufferErrors)
+{
+	initializeContext();
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, 16 * 16 * 4, nullptr, GL_STREAM_READ);
+
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+
+	// Mapped pack buffers can't be written to
+	EXPECT_NE(nullptr, glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT));
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	EXPECT_EQ((GLenum)GL_INVALID_OPERATION, glGetError());
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+	// The pixels have to fit in the buffer, after the offset
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(4));
+	EXPECT_EQ((GLenum)GL_INVALID_OPERATION, glGetError());
+
+	glBufferData(GL_PIXEL_PACK_BUFFER, 16 * 16 * 4 - 1, nullptr, GL_STREAM_READ);
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	EXPECT_EQ((GLenum)GL_INVALID_OPERATION, glGetError());
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, FenceSyncStatus)
+{
+	initializeContext();
+
+	// Render enough for it to still be in progress when the fence is inserted
+	const GLsizei size = 2048;
+
+	GLuint renderbuffer = 0;
+	glGenRenderbuffers(1, &renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+	EXPECT_EQ((GLenum)GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	glViewport(0, 0, size, size);
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+	glUseProgram(program);
+	glUniform4f(glGetUniformLocation(program, "color"), 1.0f, 1.0f, 0.0f, 1.0f);
+
+	for(int i = 0; i < 8; i++)
+	{
+		queueQuad(program);
+	}
+
+	GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	EXPECT_NE((GLsync)nullptr, sync);
+
+	GLint status = GL_SIGNALED;
+	glGetSynciv(sync, GL_SYNC_STATUS, 1, nullptr, &status);
+	EXPECT_EQ(GL_UNSIGNALED, status);
+	EXPECT_EQ((GLenum)GL_TIMEOUT_EXPIRED, glClientWaitSync(sync, 0, 0));
+
+	EXPECT_EQ((GLenum)GL_CONDITION_SATISFIED, glClientWaitSync(sync, 0, GL_TIMEOUT_IGNORED));
+	glGetSynciv(sync, GL_SYNC_STATUS, 1, nullptr, &status);
+	EXPECT_EQ(GL_SIGNALED, status);
+	EXPECT_EQ((GLenum)GL_ALREADY_SIGNALED, glClientWaitSync(sync, 0, 0));
+	glDeleteSync(sync);
+
+	// Deleting a fence doesn't wait for it, the renderer releases it when signaled
+	for(int i = 0; i < 8; i++)
+	{
+		queueQuad(program);
+	}
+
+	sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glDeleteSync(sync);
+
+	GLsync pending = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glGetSynciv(pending, GL_SYNC_STATUS, 1, nullptr, &status);
+	EXPECT_EQ(GL_UNSIGNALED, status);
+	EXPECT_EQ((GLenum)GL_CONDITION_SATISFIED, glClientWaitSync(pending, 0, GL_TIMEOUT_IGNORED));
+	glDeleteSync(pending);
+
+	glUseProgram(0);
+	glDeleteProgram(program);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &renderbuffer);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, BufferUpdateWhileInUse)
+{
+	initializeContext();
+
+	// Render enough for the buffer to still be in use when it gets updated
+	const GLsizei size = 2048;
+
+	GLuint renderbuffer = 0;
+	glGenRenderbuffers(1, &renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+
+	GLuint framebuffer = 0;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+	EXPECT_EQ((GLenum)GL_FRAMEBUFFER_COMPLETE, glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	glViewport(0, 0, size, size);
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+	glUseProgram(program);
+	GLint color = glGetUniformLocation(program, "color");
+	GLint position = glGetAttribLocation(program, "position");
+
+	const GLfloat leftHalf[] = {-1.0f, -1.0f, 0.0f, -1.0f, -1.0f, 1.0f, 0.0f, 1.0f};
+	const GLfloat rightHalf[] = {0.0f, -1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+
+	enum Update
+	{
+		SUB_DATA,               // Small buffer, copied on write
+		SUB_DATA_LARGE,         // Too large to copy for a small update, so it waits
+		MAP_INVALIDATE_RANGE,   // Copied on write, preserving the rest of the buffer
+		MAP_UNSYNCHRONIZED,     // Writes data not used by the pending draw, without waiting
+		UPDATE_COUNT
+	};
+
+	for(int update = 0; update < UPDATE_COUNT; update++)
+	{
+		// The left half quad, followed by values which updates of the quad must preserve
+		std::vector<GLfloat> contents((update == SUB_DATA_LARGE) ? 32 * 1024 : 256);
+
+		for(size_t i = 0; i < contents.size(); i++)
+		{
+			contents[i] = (i < 8) ? leftHalf[i] : (GLfloat)i;
+		}
+
+		GLuint buffer = 0;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, contents.size() * sizeof(GLfloat), contents.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glUniform4f(color, 0.0f, 0.0f, 1.0f, 1.0f);
+		queueQuad(program);
+		queueQuad(program);
+
+		// Draw the left half from the buffer, then update the buffer while that draw is pending
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+		glEnableVertexAttribArray(position);
+
+		glUniform4f(color, 1.0f, 0.0f, 0.0f, 1.0f);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+		GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		GLint first = 0;
+
+		switch(update)
+		{
+		case SUB_DATA:
+		case SUB_DATA_LARGE:
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(rightHalf), rightHalf);
+			break;
+		case MAP_INVALIDATE_RANGE:
+			{
+				void *data = glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(rightHalf), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+				ASSERT_NE(nullptr, data);
+				memcpy(data, rightHalf, sizeof(rightHalf));
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+			}
+			break;
+		case MAP_UNSYNCHRONIZED:
+			{
+				first = 4;
+				void *data = glMapBufferRange(GL_ARRAY_BUFFER, sizeof(rightHalf), sizeof(rightHalf), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+				ASSERT_NE(nullptr, data);
+				memcpy(data, rightHalf, sizeof(rightHalf));
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+			}
+			break;
+		}
+
+		std::copy(rightHalf, rightHalf + 8, contents.begin() + 2 * first);
+
+		// Only updates of large buffers wait for the pending draw
+		if(update != SUB_DATA_LARGE)
+		{
+			GLint status = GL_SIGNALED;
+			glGetSynciv(sync, GL_SYNC_STATUS, 1, nullptr, &status);
+			EXPECT_EQ(GL_UNSIGNALED, status);
+		}
+
+		glDeleteSync(sync);
+
+		glUniform4f(color, 0.0f, 1.0f, 0.0f, 1.0f);
+		glDrawArrays(GL_TRIANGLE_STRIP, first, 4);
+		glDisableVertexAttribArray(position);
+
+		// The pending draw used the old contents, and the next one the updated contents
+		GLuint pixels[2] = {};
+		glReadPixels(size / 4, size / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+		glReadPixels(3 * size / 4, size / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[1]);
+		EXPECT_EQ(0xFF0000FFu, pixels[0]);
+		EXPECT_EQ(0xFF00FF00u, pixels[1]);
+
+		const GLfloat *data = static_cast<const GLfloat*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, contents.size() * sizeof(GLfloat), GL_MAP_READ_BIT));
+		ASSERT_NE(nullptr, data);
+		EXPECT_EQ(0, memcmp(contents.data(), data, contents.size() * sizeof(GLfloat)));
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	glUseProgram(0);
+	glDeleteProgram(program);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &renderbuffer);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, MapBufferRangeErrors)
+{
+	initializeContext();
+
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, 64, nullptr, GL_DYNAMIC_DRAW);
+
+	// Reading is incompatible with discarding the contents or ignoring pending operations
+	const GLbitfield invalidAccess[] =
+	{
+		GL_MAP_READ_BIT | GL_MAP_INVALIDATE_RANGE_BIT,
+		GL_MAP_READ_BIT | GL_MAP_INVALIDATE_BUFFER_BIT,
+		GL_MAP_READ_BIT | GL_MAP_UNSYNCHRONIZED_BIT,
+		GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT,
+	};
+
+	for(GLbitfield access : invalidAccess)
+	{
+		EXPECT_EQ(nullptr, glMapBufferRange(GL_ARRAY_BUFFER, 0, 64, access));
+		EXPECT_EQ((GLenum)GL_INVALID_OPERATION, glGetError());
+	}
+
+	EXPECT_NE(nullptr, glMapBufferRange(GL_ARRAY_BUFFER, 0, 64, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	EXPECT_EQ((GLenum)GL_NO_ERROR, glGetError());
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	uninitializeContext();
+}
+
+TEST_F(SwiftShaderTest, ScissorLargerThanViewport)
+{
+	initializeContext();
+
+	GLuint program = createProgram(vertexSource, fragmentSource);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// A triangle crossing the sides of the viewport, but not the guard band,
+	// must not be drawn outside of the viewport, whatever the scissor rectangle
+	const GLfloat vertices[] =
+	{
+		-1.0f, -1.0f,
+		 3.0f, -1.0f,
+		-1.0f,  3.0f,
+	};
+
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(0, 0, 16, 16);
+	glViewport(4, 4, 8, 8);
+
+	glUseProgram(program);
+	glUniform4f(glGetUniformLocation(program, "color"), 0.0f, 1.0f, 0.0f, 1.0f);
+
+	GLint position = glGetAttribLocation(program, "position");
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
+	glEnableVertexAttribArray(position);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(position);
+
+	GLuint pixels[16 * 16];
+	glReadPixels(0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	for(int y = 0; y < 16; y++)
+	{
+		for(int x = 0; x < 16; x++)
+		{
+			bool inside = (x >= 4 && x < 12 && y >= 4 && y < 12);
+			EXPECT_EQ(inside ? 0xFF00FF00u : 0xFF000000u, pixels[y * 16 + x]) << "at " << x << ", " << y;
+		}
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glUseProgram(0);
+	glDeleteProgram(program);
+
+	uninitializeContext();
+}
+
+#if defined(__linux__)
+// Resizes headless windows while frames are in flight, and destroys their surfaces
+// right after swapping. This is done with synchronous and asynchronous presentation,
+// the latter stressing the present thread, which writes file sink frames after the swap.
+TEST_F(SwiftShaderTest, HeadlessResizeAndTeardown)
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	ASSERT_NE(nullptr, getPlatformDisplay);
+
+	display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	ASSERT_NE(EGL_NO_DISPLAY, display);
+
+	EGLBoolean initialized = eglInitialize(display, nullptr, nullptr);
+	EXPECT_EQ((EGLBoolean)EGL_TRUE, initialized);
+
+	const EGLint configAttributes[] =
+	{
+		EGL_SURFACE_TYPE,      EGL_WINDOW_BIT,
+		EGL_RENDERABLE_TYPE,   EGL_OPENGL_ES2_BIT,
+		EGL_RED_SIZE,          8,
+		EGL_GREEN_SIZE,        8,
+		EGL_BLUE_SIZE,         8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	eglChooseConfig(display, configAttributes, &config, 1, &numConfigs);
+	ASSERT_EQ(1, numConfigs);
+
+	const EGLint contextAttributes[] =
+	{
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	EXPECT_NE(EGL_NO_CONTEXT, context);
+
+	char path[] = "/tmp/swiftshader_unittests_XXXXXX";
+	int fd = mkstemp(path);
+	ASSERT_NE(-1, fd);
+	close(fd);
+
+	for(int asynchronous = 0; asynchronous < 2; asynchronous++)
+	{
+		// Read when creating the surface's frame buffer
+		setenv("SWIFTSHADER_ASYNCHRONOUS_PRESENT", asynchronous ? "1" : "0", 1);
+
+		for(int i = 0; i < 16; i++)
+		{
+			EGLHeadlessWindowSW window = {};
+			window.magic = EGL_HEADLESS_WINDOW_MAGIC_SW;
+			window.width = 64;
+			window.height = 64;
+			window.sink = EGL_HEADLESS_SINK_RAW_SW;
+			window.path = path;
+
+			surface = eglCreateWindowSurface(display, config, (EGLNativeWindowType)&window, nullptr);
+			ASSERT_NE(EGL_NO_SURFACE, surface);
+
+			EGLBoolean current = eglMakeCurrent(display, surface, surface, context);
+			EXPECT_EQ((EGLBoolean)EGL_TRUE, current);
+
+			// Resizes take effect after the next swap, and restart the file. So it ends
+			// up holding the frames swapped after the one which applied the last resize.
+			int framesSinceResize = 0;
+
+			for(int frame = 0; frame < 8; frame++)
+			{
+				bool resized = false;
+
+				if(frame % 3 == 2)
+				{
+					window.width = 16 + 8 * ((i + frame) % 7);
+					window.height = 16 + 4 * ((i * frame) % 11);
+
+					EGLint width = 0;
+					EGLint height = 0;
+					eglQuerySurface(display, surface, EGL_WIDTH, &width);
+					eglQuerySurface(display, surface, EGL_HEIGHT, &height);
+					resized = (width != window.width) || (height != window.height);
+				}
+
+				glClearColor((float)frame / 8, 0.0f, 1.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+
+				EGLBoolean swapped = eglSwapBuffers(display, surface);
+				EXPECT_EQ((EGLBoolean)EGL_TRUE, swapped);
+				framesSinceResize = resized ? 0 : framesSinceResize + 1;
+			}
+
+			// Pending frames have to be written before the surface goes away
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroySurface(display, surface);
+			EXPECT_EQ(EGL_SUCCESS, eglGetError());
+
+			FILE *file = fopen(path, "rb");
+			ASSERT_NE(nullptr, file);
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			fclose(file);
+
+			EXPECT_EQ((long)framesSinceResize * window.width * window.height * 4, size);
+		}
+	}
+
+	unsetenv("SWIFTSHADER_ASYNCHRONOUS_PRESENT");
+	unlink(path);
+
+	eglDestroyContext(display, context);
+	eglTerminate(display);
+	EXPECT_EQ(EGL_SUCCESS, eglGetError());
+}
+#endif